@@ -1,11 +1,14 @@
 #include "CAS.hpp"
+#include "CASInternal.hpp"
+#include "FileIo.hpp"
 
+#include <chrono>
 #include <fstream>
-#include <openssl/evp.h>
+#include <iomanip>
+#include <sstream>
+#include <utility>
 #include <vector>
 #include <zstd.h>
-#include <random>
-#include <thread>
 #include <algorithm>
 
 namespace fs = std::filesystem;
@@ -14,50 +17,48 @@ using namespace Docmasys;
 /// @brief Private helper declarations
 namespace
 {
+  using Docmasys::CAS::Detail::CASLocation;
+  using Docmasys::CAS::Detail::CloseHash;
+  using Docmasys::CAS::Detail::InitHash;
+  using Docmasys::CAS::Detail::ObjectStore;
+  using Docmasys::CAS::Detail::Rand64;
+  using Docmasys::CAS::Detail::UpdateHash;
 
-  [[nodiscard]] EVP_MD_CTX *InitHash();
-  void UpdateHash(EVP_MD_CTX *md, const char *data, size_t len);
+  /// @brief Bytes a CompressionTuner gathers before it reconsiders the level.
+  constexpr uint64_t ADAPT_WINDOW_BYTES = 8u << 20; // 8 MiB
+  /// @brief One side has to be this much slower before the level moves.
+  constexpr double ADAPT_HYSTERESIS = 1.25;
 
-  [[nodiscard]] Identity CloseHash(EVP_MD_CTX *md);
+  using Clock = std::chrono::steady_clock;
 
-  inline std::filesystem::path ObjectStore(const std::filesystem::path &root) noexcept
+  inline double SecondsSince(Clock::time_point start) noexcept
   {
-    return root / "Objects";
-  }
-
-  inline const std::filesystem::path CASLocation(const std::filesystem::path &objectStore, const Identity &identity) noexcept
-  {
-    auto identityStr = Docmasys::CAS::ToHexString(identity);
-    return objectStore / identityStr.substr(0, 2) / identityStr.substr(2, 2) / identityStr;
-  }
-
-  inline uint64_t Rand64() noexcept
-  {
-    static thread_local std::mt19937_64 rng{
-        std::random_device{}() ^
-        (uint64_t(std::hash<std::thread::id>{}(std::this_thread::get_id())) << 1)};
-    return rng();
+    return std::chrono::duration<double>(Clock::now() - start).count();
   }
 }
 
 Identity Docmasys::CAS::Identify(const fs::path &file)
 {
-  std::ifstream in(file, std::ios::binary);
-  if (!in)
+  return Identify(file, IoMode::Cached);
+}
+
+Identity Docmasys::CAS::Identify(const fs::path &file, IoMode mode)
+{
+  constexpr size_t IN_CHUNK = 1u << 20; // 1 MiB
+  Detail::InputFile in(file, mode, IN_CHUNK);
+  if (!in.IsOpen())
     throw std::runtime_error("Identify: cannot open input");
 
   auto md = ::InitHash();
-
-  constexpr size_t IN_CHUNK = 1u << 20; // 1 MiB
-  std::vector<char> inBuf(IN_CHUNK);
-  for (;;)
+  try
   {
-    in.read(inBuf.data(), inBuf.size());
-    std::streamsize got = in.gcount();
-    if (got <= 0)
-      break;
-
-    ::UpdateHash(md, inBuf.data(), static_cast<size_t>(got));
+    for (auto chunk = in.Read(); !chunk.empty(); chunk = in.Read())
+      ::UpdateHash(md, chunk.data(), chunk.size());
+  }
+  catch (const std::exception &ex)
+  {
+    EVP_MD_CTX_free(md);
+    throw std::runtime_error(std::string("Identify: ") + ex.what());
   }
 
   return ::CloseHash(md);
@@ -65,9 +66,18 @@ Identity Docmasys::CAS::Identify(const fs::path &file)
 
 Identity Docmasys::CAS::Store(const fs::path &root, const fs::path &file)
 {
+  return Store(root, file, StoreOptions{}).Hash;
+}
 
-  std::ifstream in(file, std::ios::binary);
-  if (!in)
+Docmasys::CAS::StoreResult Docmasys::CAS::Store(const fs::path &root, const fs::path &file, const StoreOptions &options)
+{
+  StoreResult result;
+  result.CompressionLevel = std::clamp(options.CompressionLevel, ZSTD_minCLevel(), ZSTD_maxCLevel());
+
+  constexpr size_t IN_CHUNK = 1u << 20;  // 1 MiB
+  constexpr size_t OUT_CHUNK = 1u << 17; // 128 KiB
+  Detail::InputFile in(file, options.Mode, IN_CHUNK);
+  if (!in.IsOpen())
     throw std::runtime_error("Store: cannot open input");
 
   EVP_MD_CTX *md = ::InitHash();
@@ -84,8 +94,7 @@ Identity Docmasys::CAS::Store(const fs::path &root, const fs::path &file)
   ZSTD_CCtx_setPledgedSrcSize(cctx, pledged);
   ZSTD_CCtx_setParameter(cctx, ZSTD_c_contentSizeFlag, 1); // store original size in frame
 
-  int level = 3; // tune as you like
-  ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+  ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, result.CompressionLevel);
   // Optional: enable multithreaded compression for big files
   // ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, 2);
 
@@ -96,88 +105,100 @@ Identity Docmasys::CAS::Store(const fs::path &root, const fs::path &file)
 
   fs::path tmpPath = tmpDir / ("tmp-" + std::to_string(Rand64()) + ".zst");
 
-  std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
-  if (!out)
+  Detail::OutputFile out(tmpPath, options.Mode);
+  if (!out.IsOpen())
   {
     ZSTD_freeCCtx(cctx);
     EVP_MD_CTX_free(md);
     throw std::runtime_error("Store: open temp failed");
   }
 
-  constexpr size_t IN_CHUNK = 1u << 20;  // 1 MiB
-  constexpr size_t OUT_CHUNK = 1u << 17; // 128 KiB
-  std::vector<char> inBuf(IN_CHUNK);
   std::vector<char> outBuf(OUT_CHUNK);
-
-  uint64_t total = 0;
-
-  // Stream input -> hash + compress
-  for (;;)
+  try
   {
-    in.read(inBuf.data(), inBuf.size());
-    std::streamsize got = in.gcount();
-    if (got <= 0)
-      break;
-
-    ::UpdateHash(md, inBuf.data(), static_cast<size_t>(got));
-
-    // compress
-    ZSTD_inBuffer zin{inBuf.data(), static_cast<size_t>(got), 0};
-    while (zin.pos < zin.size)
+    // Stream input -> hash + compress
+    for (;;)
     {
-      ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
-      size_t r = ZSTD_compressStream2(cctx, &zout, &zin, ZSTD_e_continue);
+      auto started = Clock::now();
+      const auto chunk = in.Read();
+      result.ReadSeconds += SecondsSince(started);
+      if (chunk.empty())
+        break;
 
-      if (ZSTD_isError(r))
+      ::UpdateHash(md, chunk.data(), chunk.size());
+
+      // compress
+      ZSTD_inBuffer zin{chunk.data(), chunk.size(), 0};
+      while (zin.pos < zin.size)
       {
-        ZSTD_freeCCtx(cctx);
-        EVP_MD_CTX_free(md);
-        throw std::runtime_error(std::string("zstd compressStream2 failed: ") + ZSTD_getErrorName(r));
+        ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
+        started = Clock::now();
+        size_t r = ZSTD_compressStream2(cctx, &zout, &zin, ZSTD_e_continue);
+        result.CompressSeconds += SecondsSince(started);
+
+        if (ZSTD_isError(r))
+          throw std::runtime_error(std::string("zstd compressStream2 failed: ") + ZSTD_getErrorName(r));
+
+        if (zout.pos)
+        {
+          started = Clock::now();
+          out.Write(outBuf.data(), zout.pos);
+          result.WriteSeconds += SecondsSince(started);
+          result.StoredBytes += zout.pos;
+        }
       }
 
-      if (zout.pos)
-        out.write(outBuf.data(), static_cast<std::streamsize>(zout.pos));
+      result.RawBytes += chunk.size();
     }
 
-    total += static_cast<uint64_t>(got);
-  }
-
-  // flush & finalize compressor
-  {
+    // flush & finalize compressor
     ZSTD_inBuffer zin{nullptr, 0, 0};
-
     for (;;)
     {
       ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
+      auto started = Clock::now();
       size_t r = ZSTD_compressStream2(cctx, &zout, &zin, ZSTD_e_end);
+      result.CompressSeconds += SecondsSince(started);
 
       if (ZSTD_isError(r))
-      {
-        ZSTD_freeCCtx(cctx);
-        EVP_MD_CTX_free(md);
         throw std::runtime_error(std::string("zstd finalize failed: ") + ZSTD_getErrorName(r));
-      }
 
       if (zout.pos)
-        out.write(outBuf.data(), static_cast<std::streamsize>(zout.pos));
+      {
+        started = Clock::now();
+        out.Write(outBuf.data(), zout.pos);
+        result.WriteSeconds += SecondsSince(started);
+        result.StoredBytes += zout.pos;
+      }
 
       if (r == 0)
         break; // done
     }
+
+    const auto started = Clock::now();
+    out.Close();
+    result.WriteSeconds += SecondsSince(started);
   }
-  out.flush();
-  out.close();
-  if (!out)
+  catch (const std::exception &ex)
   {
     ZSTD_freeCCtx(cctx);
     EVP_MD_CTX_free(md);
-    throw std::runtime_error("Store: final write failed");
+    try
+    {
+      out.Close();
+    }
+    catch (...)
+    {
+    }
+    std::error_code ec;
+    fs::remove(tmpPath, ec);
+    throw std::runtime_error(std::string("Store: ") + ex.what());
   }
   ZSTD_freeCCtx(cctx);
 
-  auto identity = ::CloseHash(md);
+  result.Hash = ::CloseHash(md);
 
-  fs::path objPath = ::CASLocation(objStore, identity);
+  fs::path objPath = ::CASLocation(objStore, result.Hash);
   fs::create_directories(objPath.parent_path());
 
   // Atomic install: try rename; if target already exists, drop temp
@@ -198,132 +219,180 @@ Identity Docmasys::CAS::Store(const fs::path &root, const fs::path &file)
     }
   }
 
-  return identity;
+  return result;
+}
+
+Docmasys::CAS::CompressionTuner::CompressionTuner(const CompressionOptions &options)
+    : m_Options(options)
+{
+  m_Options.MinLevel = std::clamp(m_Options.MinLevel, ZSTD_minCLevel(), ZSTD_maxCLevel());
+  m_Options.MaxLevel = std::clamp(m_Options.MaxLevel, m_Options.MinLevel, ZSTD_maxCLevel());
+  m_Level = m_Options.Adaptive
+                ? std::clamp(m_Options.Level, m_Options.MinLevel, m_Options.MaxLevel)
+                : std::clamp(m_Options.Level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+}
+
+void Docmasys::CAS::CompressionTuner::ObserveInput(std::uint64_t bytes, double seconds)
+{
+  if (!m_Options.Adaptive)
+    return;
+  m_InputBytes += bytes;
+  m_InputSeconds += seconds;
+}
+
+void Docmasys::CAS::CompressionTuner::Observe(const StoreResult &result)
+{
+  if (!m_Options.Adaptive)
+    return;
+
+  const double readSeconds = m_InputBytes > 0
+                                ? static_cast<double>(result.RawBytes) * m_InputSeconds / static_cast<double>(m_InputBytes)
+                                : result.ReadSeconds;
+  m_WindowBytes += result.RawBytes;
+  m_WindowIoSeconds += readSeconds + result.WriteSeconds;
+  m_WindowCompressSeconds += result.CompressSeconds;
+  if (m_WindowBytes < ADAPT_WINDOW_BYTES)
+    return;
+
+  // Compression is the bottleneck -> cheaper level; I/O is the bottleneck -> spend the spare CPU.
+  if (m_WindowCompressSeconds > m_WindowIoSeconds * ADAPT_HYSTERESIS)
+    m_Level = std::max(m_Level - 1, m_Options.MinLevel);
+  else if (m_WindowIoSeconds > m_WindowCompressSeconds * ADAPT_HYSTERESIS)
+    m_Level = std::min(m_Level + 1, m_Options.MaxLevel);
+
+  m_WindowBytes = 0;
+  m_WindowIoSeconds = 0;
+  m_WindowCompressSeconds = 0;
+  // Older input counts half as much in each following window, so the rate follows changes in the source.
+  m_InputBytes /= 2;
+  m_InputSeconds /= 2;
 }
 
 void Docmasys::CAS::Retrieve(const fs::path &root, const Identity &identity, const std::filesystem::path &outFile)
+{
+  Retrieve(root, identity, outFile, RetrieveOptions{});
+}
+
+void Docmasys::CAS::Retrieve(const fs::path &root, const Identity &identity, const std::filesystem::path &outFile, const RetrieveOptions &options)
 {
 
   const fs::path obj = ::CASLocation(ObjectStore(root), identity);
   if (!fs::exists(obj))
     throw std::runtime_error("Retrieve: given identity doesn't exist");
 
-  std::ifstream in(obj, std::ios::binary);
-  if (!in)
+  Detail::InputFile in(obj, options.Mode, ZSTD_DStreamInSize());
+  if (!in.IsOpen())
     throw std::runtime_error("Retrieve: cannot open compressed object");
 
   fs::create_directories(outFile.parent_path());
 
   // temp file (atomic install)
-  const fs::path tmpDir = outFile.parent_path() / ".tmp";
-  fs::create_directories(tmpDir);
-
-  fs::path tmpFile = tmpDir / (outFile.filename().string() + "-" + std::to_string(Rand64()) + ".part");
+  fs::path tmpFile = Docmasys::CAS::Detail::TempOutputPath(outFile);
+  fs::create_directories(tmpFile.parent_path());
 
-  std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
-  if (!out)
+  Detail::OutputFile out(tmpFile, options.Mode, options.ExpectedSize);
+  if (!out.IsOpen())
+  {
+    std::error_code ec;
+    fs::remove(tmpFile, ec);
     throw std::runtime_error("Retrieve: cannot open temp output");
+  }
+  uint64_t written = 0;
 
   ZSTD_DCtx *dctx = ZSTD_createDCtx();
   if (!dctx)
   {
+    out.Close();
     fs::remove(tmpFile);
     throw std::runtime_error("Retrieve: ZSTD_createDCtx failed");
   }
 
-  const size_t inChunk = ZSTD_DStreamInSize();
-  const size_t outChunk = ZSTD_DStreamOutSize();
-  std::vector<char> inBuf(inChunk);
-  std::vector<char> outBuf(outChunk);
-
-  bool frameEnded = false;
-  // Read & decompress input chunks
-  while (!frameEnded)
+  std::vector<char> outBuf(ZSTD_DStreamOutSize());
+  EVP_MD_CTX *md = options.Verify ? ::InitHash() : nullptr;
+  try
   {
-    in.read(inBuf.data(), static_cast<std::streamsize>(inBuf.size()));
-    const size_t readBytes = static_cast<size_t>(in.gcount());
-
-    if (readBytes == 0 && !in.eof())
-    {
-      // real I/O error
-      ZSTD_freeDCtx(dctx);
-      fs::remove(tmpFile);
-      throw std::runtime_error("Retrieve: read failed");
-    }
-
-    if (readBytes == 0)
+    bool frameEnded = false;
+    // Read & decompress input chunks
+    while (!frameEnded)
     {
-      // EOF reached: do ONE final empty call to flush and check frame end
-      ZSTD_inBuffer zin{nullptr, 0, 0};
-      ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
-      size_t const r = ZSTD_decompressStream(dctx, &zout, &zin);
-
-      if (ZSTD_isError(r))
+      const auto chunk = in.Read();
+      if (chunk.empty())
       {
-        ZSTD_freeDCtx(dctx);
-        fs::remove(tmpFile);
-        throw std::runtime_error(std::string("Get: finalize failed: ") + ZSTD_getErrorName(r));
-      }
+        // EOF reached: do ONE final empty call to flush and check frame end
+        ZSTD_inBuffer zin{nullptr, 0, 0};
+        ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
+        size_t const r = ZSTD_decompressStream(dctx, &zout, &zin);
 
-      if (zout.pos)
-      {
-        out.write(outBuf.data(), static_cast<std::streamsize>(zout.pos));
-        if (!out)
+        if (ZSTD_isError(r))
+          throw std::runtime_error(std::string("finalize failed: ") + ZSTD_getErrorName(r));
+
+        if (zout.pos)
         {
-          ZSTD_freeDCtx(dctx);
-          fs::remove(tmpFile);
-          throw std::runtime_error("Retrieve: write failed (finalize)");
+          if (md)
+            ::UpdateHash(md, outBuf.data(), zout.pos);
+          out.Write(outBuf.data(), zout.pos);
+          written += zout.pos;
         }
+        if (r != 0)
+        {
+          // decoder still expects more input → compressed file is truncated
+          throw std::runtime_error("unexpected EOF in compressed stream");
+        }
+        frameEnded = true;
+        break;
       }
-      if (r != 0)
-      {
-        // decoder still expects more input → compressed file is truncated
-        ZSTD_freeDCtx(dctx);
-        fs::remove(tmpFile);
-        throw std::runtime_error("Retrieve: unexpected EOF in compressed stream");
-      }
-      frameEnded = true;
-      break;
-    }
 
-    // Normal chunk
-    ZSTD_inBuffer zin{inBuf.data(), readBytes, 0};
-    while (zin.pos < zin.size)
-    {
-      ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
-      size_t const r = ZSTD_decompressStream(dctx, &zout, &zin);
-
-      if (ZSTD_isError(r))
+      // Normal chunk
+      ZSTD_inBuffer zin{chunk.data(), chunk.size(), 0};
+      while (zin.pos < zin.size)
       {
-        ZSTD_freeDCtx(dctx);
-        fs::remove(tmpFile);
-        throw std::runtime_error(std::string("Retrieve: zstd decompressStream failed: ") + ZSTD_getErrorName(r));
-      }
+        ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
+        size_t const r = ZSTD_decompressStream(dctx, &zout, &zin);
 
-      if (zout.pos)
-      {
-        out.write(outBuf.data(), static_cast<std::streamsize>(zout.pos));
-        if (!out)
+        if (ZSTD_isError(r))
+          throw std::runtime_error(std::string("zstd decompressStream failed: ") + ZSTD_getErrorName(r));
+
+        if (zout.pos)
         {
-          ZSTD_freeDCtx(dctx);
-          fs::remove(tmpFile);
-          throw std::runtime_error("Retrieve: write failed");
+          if (md)
+            ::UpdateHash(md, outBuf.data(), zout.pos);
+          out.Write(outBuf.data(), zout.pos);
+          written += zout.pos;
         }
-      }
 
-      if (r == 0)
-      { // end of frame reached
-        frameEnded = true;
-        // If your format is guaranteed single-frame, you can ignore any trailing junk;
-        // here we stop cleanly.
-        break;
+        if (r == 0)
+        { // end of frame reached
+          frameEnded = true;
+          // If your format is guaranteed single-frame, you can ignore any trailing junk;
+          // here we stop cleanly.
+          break;
+        }
       }
     }
-  }
 
+    out.Close();
+    if (options.ExpectedSize && written != *options.ExpectedSize)
+      throw std::runtime_error("decompressed size does not match expected size");
+    if (md && ::CloseHash(std::exchange(md, nullptr)) != identity)
+      throw std::runtime_error("content hash mismatch, object is corrupt");
+  }
+  catch (const std::exception &ex)
+  {
+    if (md)
+      EVP_MD_CTX_free(md);
+    ZSTD_freeDCtx(dctx);
+    try
+    {
+      out.Close();
+    }
+    catch (...)
+    {
+    }
+    std::error_code ec;
+    fs::remove(tmpFile, ec);
+    throw std::runtime_error(std::string("Retrieve: ") + ex.what());
+  }
   ZSTD_freeDCtx(dctx);
-  out.flush();
-  out.close();
 
   // Try atomic rename first
   std::error_code ec;
@@ -339,6 +408,58 @@ void Docmasys::CAS::Retrieve(const fs::path &root, const Identity &identity, con
   }
 }
 
+Docmasys::CAS::ObjectInfo Docmasys::CAS::Inspect(const fs::path &root, const Identity &identity)
+{
+  const fs::path obj = ::CASLocation(ObjectStore(root), identity);
+  std::ifstream in(obj, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Inspect: given identity doesn't exist");
+
+  ObjectInfo info;
+  info.StoredSize = static_cast<uint64_t>(fs::file_size(obj));
+
+  char header[18]; // ZSTD_FRAMEHEADERSIZE_MAX, which zstd only exposes under ZSTD_STATIC_LINKING_ONLY
+  in.read(header, sizeof(header));
+  const auto contentSize = ZSTD_getFrameContentSize(header, static_cast<size_t>(in.gcount()));
+  if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN && contentSize != ZSTD_CONTENTSIZE_ERROR)
+  {
+    info.RawSize = contentSize;
+    return info;
+  }
+
+  // No size in the header: count the decompressed bytes instead.
+  in.clear();
+  in.seekg(0);
+  ZSTD_DCtx *dctx = ZSTD_createDCtx();
+  if (!dctx)
+    throw std::runtime_error("Inspect: ZSTD_createDCtx failed");
+
+  std::vector<char> inBuf(ZSTD_DStreamInSize());
+  std::vector<char> outBuf(ZSTD_DStreamOutSize());
+  for (;;)
+  {
+    in.read(inBuf.data(), static_cast<std::streamsize>(inBuf.size()));
+    const size_t readBytes = static_cast<size_t>(in.gcount());
+    if (readBytes == 0)
+      break;
+
+    ZSTD_inBuffer zin{inBuf.data(), readBytes, 0};
+    while (zin.pos < zin.size)
+    {
+      ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
+      const size_t r = ZSTD_decompressStream(dctx, &zout, &zin);
+      if (ZSTD_isError(r))
+      {
+        ZSTD_freeDCtx(dctx);
+        throw std::runtime_error(std::string("Inspect: zstd decompressStream failed: ") + ZSTD_getErrorName(r));
+      }
+      info.RawSize += zout.pos;
+    }
+  }
+  ZSTD_freeDCtx(dctx);
+  return info;
+}
+
 std::filesystem::path Docmasys::CAS::BlobPath(const fs::path &root, const Identity &identity)
 {
   return ::CASLocation(ObjectStore(root), identity);
@@ -380,44 +501,3 @@ std::string Docmasys::CAS::ToHexString(const Identity &identity)
   return oss.str();
 }
 
-namespace
-{
-  EVP_MD_CTX *InitHash()
-  {
-    EVP_MD_CTX *md = EVP_MD_CTX_new();
-    if (!md)
-      throw std::runtime_error("EVP_MD_CTX_new failed");
-
-    if (EVP_DigestInit_ex(md, EVP_sha256(), nullptr) != 1)
-    {
-      EVP_MD_CTX_free(md);
-      throw std::runtime_error("EVP_DigestInit_ex failed");
-    }
-
-    return md;
-  }
-
-  void UpdateHash(EVP_MD_CTX *md, const char *data, size_t len)
-  {
-    if (EVP_DigestUpdate(md, data, len) != 1)
-      throw std::runtime_error("EVP_DigestUpdate failed");
-  }
-
-  Identity CloseHash(EVP_MD_CTX *md)
-  {
-    // finalize hash
-    unsigned char mdBuf[EVP_MAX_MD_SIZE];
-    unsigned int mdLen = 0;
-    if (EVP_DigestFinal_ex(md, mdBuf, &mdLen) != 1)
-    {
-      EVP_MD_CTX_free(md);
-      throw std::runtime_error("EVP_DigestFinal_ex failed");
-    }
-    EVP_MD_CTX_free(md);
-
-    Identity out{};
-
-    std::copy_n(mdBuf, std::min(std::tuple_size_v<Identity>, static_cast<size_t>(mdLen)), out.begin());
-    return out;
-  }
-}
\ No newline at end of file
@@ -1,18 +1,107 @@
 #pragma once
+#include <cstdint>
 #include <filesystem>
+#include <optional>
 #include "../Types.hpp"
 
 /// @brief Content Addressable Storage that indentifies files by SHA256 and uses zlib to compress the files when stored.
 namespace Docmasys::CAS
 {
+  /// @brief How the CAS read and write loops treat the OS page cache.
+  enum class IoMode : std::uint8_t
+  {
+    /// @brief Regular buffered I/O; file data stays in the page cache.
+    Cached = 0,
+    /// @brief Buffered sequential I/O; consumed ranges are dropped from the page cache.
+    Bulk = 1,
+    /// @brief O_DIRECT with aligned buffers where the filesystem supports it, Bulk otherwise.
+    Direct = 2,
+  };
+
+  /// @brief Process-wide byte counters of the CAS file loops, split by page-cache involvement.
+  struct IoCounters
+  {
+    /// @brief Read through the page cache and left there (Cached).
+    std::uint64_t CachedReadBytes{};
+    /// @brief Read through the page cache and dropped right after (Bulk).
+    std::uint64_t DroppedReadBytes{};
+    /// @brief Read around the page cache (Direct).
+    std::uint64_t DirectReadBytes{};
+    std::uint64_t CachedWriteBytes{};
+    std::uint64_t DroppedWriteBytes{};
+    std::uint64_t DirectWriteBytes{};
+  };
+
+  [[nodiscard]] IoCounters GetIoCounters() noexcept;
+  void ResetIoCounters() noexcept;
+
   /// @brief Calculate hash identity for give file
   /// @param file Full path to local file which content to read and calculate hash for.
   /// @return SHA256 identity
   [[nodiscard]] Identity Identify(
       const std::filesystem::path &file);
 
+  /// @brief Calculate hash identity for given file with an explicit I/O mode.
+  [[nodiscard]] Identity Identify(
+      const std::filesystem::path &file,
+      IoMode mode);
+
   [[nodiscard]] std::string ToHexString(const Identity &identity);
 
+  /// @brief zstd level used when no explicit level is requested.
+  inline constexpr int DefaultCompressionLevel = 3;
+
+  struct StoreOptions
+  {
+    int CompressionLevel{DefaultCompressionLevel};
+    IoMode Mode{IoMode::Cached};
+  };
+
+  /// @brief Outcome of a single Store call, including where the time went.
+  struct StoreResult
+  {
+    Identity Hash{};
+    int CompressionLevel{DefaultCompressionLevel};
+    std::uint64_t RawBytes{};
+    std::uint64_t StoredBytes{};
+    double ReadSeconds{};
+    double CompressSeconds{};
+    double WriteSeconds{};
+  };
+
+  /// @brief Compression settings for a run of Store calls.
+  struct CompressionOptions
+  {
+    int Level{DefaultCompressionLevel};
+    bool Adaptive{false};
+    int MinLevel{1};
+    int MaxLevel{19};
+  };
+
+  /// @brief Chooses the zstd level for consecutive Store calls.
+  /// In adaptive mode it compares time spent on I/O with time spent compressing over a
+  /// window of stored bytes (like `zstd --adapt`): CPU-bound runs step the level down,
+  /// I/O-bound runs step it up, always within [MinLevel, MaxLevel].
+  class CompressionTuner
+  {
+  public:
+    explicit CompressionTuner(const CompressionOptions &options);
+    [[nodiscard]] int Level() const noexcept { return m_Level; }
+    /// @brief Reports @p bytes of input that took @p seconds to read from their device, such as hashing files before storing them.
+    /// Store then re-reads warm pages, so once input was reported its ReadSeconds are replaced by this input rate.
+    void ObserveInput(std::uint64_t bytes, double seconds);
+    void Observe(const StoreResult &result);
+
+  private:
+    CompressionOptions m_Options;
+    int m_Level;
+    std::uint64_t m_WindowBytes{};
+    double m_WindowIoSeconds{};
+    double m_WindowCompressSeconds{};
+    std::uint64_t m_InputBytes{};
+    double m_InputSeconds{};
+  };
+
   /// @brief Store the given files to CAS vault.
   /// @param root Full path to the CAS vault root.
   /// @param file Full path to the file to store.
@@ -21,6 +110,25 @@ namespace Docmasys::CAS
       const std::filesystem::path &root,
       const std::filesystem::path &file);
 
+  /// @brief Store the given file to CAS vault with explicit options.
+  /// @param root Full path to the CAS vault root.
+  /// @param file Full path to the file to store.
+  /// @param options Compression level etc.
+  /// @return SHA256 identity plus size and timing figures for the stored object.
+  [[nodiscard]] StoreResult Store(
+      const std::filesystem::path &root,
+      const std::filesystem::path &file,
+      const StoreOptions &options);
+
+  struct RetrieveOptions
+  {
+    /// @brief Decompressed size when known up front; the target is preallocated and the output length checked.
+    std::optional<std::uint64_t> ExpectedSize;
+    IoMode Mode{IoMode::Cached};
+    /// @brief Hash the decompressed stream while writing it; a mismatch with the identity throws and nothing is installed.
+    bool Verify{false};
+  };
+
   /// @brief Retrieve stored file from CAS with given identity.
   /// @param root Full path to the CAS vault root.
   /// @param identity Hexadecimal string (SHA256) that identifies the file.
@@ -30,6 +138,26 @@ namespace Docmasys::CAS
       const Identity &identity,
       const std::filesystem::path &outFile);
 
+  /// @brief Retrieve stored file from CAS with given identity and options.
+  void Retrieve(
+      const std::filesystem::path &root,
+      const Identity &identity,
+      const std::filesystem::path &outFile,
+      const RetrieveOptions &options);
+
+  struct ObjectInfo
+  {
+    std::uint64_t RawSize{};
+    std::uint64_t StoredSize{};
+  };
+
+  /// @brief Reads the sizes of a stored object, normally from its zstd frame header only.
+  /// @param root Full path to the CAS vault root.
+  /// @param identity SHA256 identity
+  [[nodiscard]] ObjectInfo Inspect(
+      const std::filesystem::path &root,
+      const Identity &identity);
+
   [[nodiscard]] std::filesystem::path BlobPath(
       const std::filesystem::path &root,
       const Identity &identity);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CAS.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <openssl/evp.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/// @brief Helpers shared by the CAS translation units; not part of the public API.
+namespace Docmasys::CAS::Detail
+{
+  inline std::filesystem::path ObjectStore(const std::filesystem::path &root) noexcept
+  {
+    return root / "Objects";
+  }
+
+  inline const std::filesystem::path CASLocation(const std::filesystem::path &objectStore, const Identity &identity) noexcept
+  {
+    auto identityStr = Docmasys::CAS::ToHexString(identity);
+    return objectStore / identityStr.substr(0, 2) / identityStr.substr(2, 2) / identityStr;
+  }
+
+  inline uint64_t Rand64() noexcept
+  {
+    static thread_local std::mt19937_64 rng{
+        std::random_device{}() ^
+        (uint64_t(std::hash<std::thread::id>{}(std::this_thread::get_id())) << 1)};
+    return rng();
+  }
+
+  /// @brief Temp file next to @p outFile that Retrieve writes before the atomic install.
+  inline std::filesystem::path TempOutputPath(const std::filesystem::path &outFile)
+  {
+    return outFile.parent_path() / ".tmp" / (outFile.filename().string() + "-" + std::to_string(Rand64()) + ".part");
+  }
+
+  inline EVP_MD_CTX *InitHash()
+  {
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    if (!md)
+      throw std::runtime_error("EVP_MD_CTX_new failed");
+
+    if (EVP_DigestInit_ex(md, EVP_sha256(), nullptr) != 1)
+    {
+      EVP_MD_CTX_free(md);
+      throw std::runtime_error("EVP_DigestInit_ex failed");
+    }
+
+    return md;
+  }
+
+  inline void UpdateHash(EVP_MD_CTX *md, const char *data, size_t len)
+  {
+    if (EVP_DigestUpdate(md, data, len) != 1)
+      throw std::runtime_error("EVP_DigestUpdate failed");
+  }
+
+  inline Identity CloseHash(EVP_MD_CTX *md)
+  {
+    // finalize hash
+    unsigned char mdBuf[EVP_MAX_MD_SIZE];
+    unsigned int mdLen = 0;
+    if (EVP_DigestFinal_ex(md, mdBuf, &mdLen) != 1)
+    {
+      EVP_MD_CTX_free(md);
+      throw std::runtime_error("EVP_DigestFinal_ex failed");
+    }
+    EVP_MD_CTX_free(md);
+
+    Identity out{};
+
+    std::copy_n(mdBuf, std::min(std::tuple_size_v<Identity>, static_cast<size_t>(mdLen)), out.begin());
+    return out;
+  }
+}
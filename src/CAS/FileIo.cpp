@@ -0,0 +1,391 @@
+#include "FileIo.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+using namespace Docmasys::CAS;
+using namespace Docmasys::CAS::Detail;
+
+namespace
+{
+  /// @brief Buffer, offset and length alignment that O_DIRECT accepts on common Linux filesystems.
+  constexpr std::size_t DIRECT_ALIGNMENT = 4096;
+  /// @brief Write-side staging buffer for Direct mode.
+  constexpr std::size_t DIRECT_WRITE_CHUNK = 1u << 20; // 1 MiB
+
+  struct Counters
+  {
+    std::atomic<std::uint64_t> CachedRead{};
+    std::atomic<std::uint64_t> DroppedRead{};
+    std::atomic<std::uint64_t> DirectRead{};
+    std::atomic<std::uint64_t> CachedWrite{};
+    std::atomic<std::uint64_t> DroppedWrite{};
+    std::atomic<std::uint64_t> DirectWrite{};
+  };
+
+  Counters &GlobalCounters() noexcept
+  {
+    static Counters counters;
+    return counters;
+  }
+
+  AlignedBuffer AllocateAligned(std::size_t size)
+  {
+    return AlignedBuffer(static_cast<char *>(::operator new[](size, std::align_val_t{DIRECT_ALIGNMENT})));
+  }
+
+  std::size_t RoundUp(std::size_t value, std::size_t alignment) noexcept
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+#ifndef _WIN32
+  std::string SystemError() { return std::strerror(errno); }
+
+  /// @brief Opens with O_DIRECT when asked for and supported; @p mode is downgraded to Bulk otherwise.
+  int OpenFile(const fs::path &file, int flags, IoMode &mode)
+  {
+#ifdef O_DIRECT
+    if (mode == IoMode::Direct)
+    {
+      const int fd = ::open(file.c_str(), flags | O_DIRECT, 0666);
+      if (fd >= 0 || errno != EINVAL)
+        return fd;
+    }
+#endif
+    if (mode == IoMode::Direct)
+      mode = IoMode::Bulk;
+    return ::open(file.c_str(), flags, 0666);
+  }
+
+  /// @brief Turns O_DIRECT off on an open descriptor (filesystem refused an unaligned or direct request).
+  void LeaveDirect(int fd, IoMode &mode) noexcept
+  {
+#ifdef O_DIRECT
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags >= 0)
+      static_cast<void>(::fcntl(fd, F_SETFL, flags & ~O_DIRECT));
+#else
+    static_cast<void>(fd);
+#endif
+    mode = IoMode::Bulk;
+  }
+
+  void Advise(int fd, std::uint64_t offset, std::uint64_t length, [[maybe_unused]] int advice) noexcept
+  {
+#ifdef POSIX_FADV_DONTNEED
+    static_cast<void>(::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), advice));
+#else
+    static_cast<void>(fd);
+    static_cast<void>(offset);
+    static_cast<void>(length);
+#endif
+  }
+
+#ifdef POSIX_FADV_DONTNEED
+  constexpr int ADVICE_SEQUENTIAL = POSIX_FADV_SEQUENTIAL;
+  constexpr int ADVICE_DONTNEED = POSIX_FADV_DONTNEED;
+#else
+  constexpr int ADVICE_SEQUENTIAL = 0;
+  constexpr int ADVICE_DONTNEED = 0;
+#endif
+#endif
+}
+
+void AlignedFree::operator()(char *buffer) const noexcept
+{
+  ::operator delete[](buffer, std::align_val_t{DIRECT_ALIGNMENT});
+}
+
+void Docmasys::CAS::Detail::CountRead(IoMode mode, std::uint64_t bytes) noexcept
+{
+  auto &counters = GlobalCounters();
+  (mode == IoMode::Cached ? counters.CachedRead : mode == IoMode::Bulk ? counters.DroppedRead : counters.DirectRead).fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Docmasys::CAS::Detail::CountWrite(IoMode mode, std::uint64_t bytes) noexcept
+{
+  auto &counters = GlobalCounters();
+  (mode == IoMode::Cached ? counters.CachedWrite : mode == IoMode::Bulk ? counters.DroppedWrite : counters.DirectWrite).fetch_add(bytes, std::memory_order_relaxed);
+}
+
+IoCounters Docmasys::CAS::GetIoCounters() noexcept
+{
+  const auto &counters = GlobalCounters();
+  return IoCounters{
+      .CachedReadBytes = counters.CachedRead.load(std::memory_order_relaxed),
+      .DroppedReadBytes = counters.DroppedRead.load(std::memory_order_relaxed),
+      .DirectReadBytes = counters.DirectRead.load(std::memory_order_relaxed),
+      .CachedWriteBytes = counters.CachedWrite.load(std::memory_order_relaxed),
+      .DroppedWriteBytes = counters.DroppedWrite.load(std::memory_order_relaxed),
+      .DirectWriteBytes = counters.DirectWrite.load(std::memory_order_relaxed)};
+}
+
+void Docmasys::CAS::ResetIoCounters() noexcept
+{
+  auto &counters = GlobalCounters();
+  for (auto *counter : {&counters.CachedRead, &counters.DroppedRead, &counters.DirectRead,
+                        &counters.CachedWrite, &counters.DroppedWrite, &counters.DirectWrite})
+    counter->store(0, std::memory_order_relaxed);
+}
+
+InputFile::InputFile(const fs::path &file, IoMode mode, std::size_t chunkSize)
+    : m_Mode(mode),
+      m_ChunkSize(RoundUp(std::max<std::size_t>(chunkSize, 1), DIRECT_ALIGNMENT))
+{
+#ifdef _WIN32
+  m_Stream.open(file, std::ios::binary);
+#else
+  m_Fd = OpenFile(file, O_RDONLY | O_CLOEXEC, m_Mode);
+  if (m_Fd < 0)
+    return;
+  if (m_Mode == IoMode::Bulk)
+    Advise(m_Fd, 0, 0, ADVICE_SEQUENTIAL);
+#endif
+  m_Buffer = AllocateAligned(m_ChunkSize);
+}
+
+InputFile::~InputFile()
+{
+#ifndef _WIN32
+  if (m_Fd < 0)
+    return;
+  if (m_Mode == IoMode::Bulk)
+    Advise(m_Fd, 0, 0, ADVICE_DONTNEED);
+  ::close(m_Fd);
+#endif
+}
+
+bool InputFile::IsOpen() const noexcept
+{
+#ifdef _WIN32
+  return m_Stream.is_open();
+#else
+  return m_Fd >= 0;
+#endif
+}
+
+std::span<const char> InputFile::Read()
+{
+  if (m_Eof || !IsOpen())
+    return {};
+
+#ifdef _WIN32
+  m_Stream.read(m_Buffer.get(), static_cast<std::streamsize>(m_ChunkSize));
+  const auto got = static_cast<std::size_t>(m_Stream.gcount());
+  if (got == 0 && !m_Stream.eof())
+    throw std::runtime_error("read failed");
+#else
+  ssize_t result;
+  for (;;)
+  {
+    result = ::read(m_Fd, m_Buffer.get(), m_ChunkSize);
+    if (result >= 0)
+      break;
+    if (errno == EINTR)
+      continue;
+    if (errno == EINVAL && m_Mode == IoMode::Direct)
+    {
+      LeaveDirect(m_Fd, m_Mode);
+      continue;
+    }
+    throw std::runtime_error("read failed: " + SystemError());
+  }
+  const auto got = static_cast<std::size_t>(result);
+  // A short direct read only happens at the end of the file; the next offset would be unaligned.
+  if (m_Mode == IoMode::Direct && got < m_ChunkSize)
+    m_Eof = true;
+#endif
+  if (got == 0)
+  {
+    m_Eof = true;
+    return {};
+  }
+
+  m_Offset += got;
+  CountRead(m_Mode, got);
+#ifndef _WIN32
+  if (m_Mode == IoMode::Bulk && m_Offset - m_Dropped >= CACHE_DROP_WINDOW)
+  {
+    Advise(m_Fd, m_Dropped, m_Offset - m_Dropped, ADVICE_DONTNEED);
+    m_Dropped = m_Offset;
+  }
+#endif
+  return {m_Buffer.get(), got};
+}
+
+OutputFile::OutputFile(const fs::path &file, IoMode mode, std::optional<std::uint64_t> reserve)
+    : m_Mode(mode)
+{
+#ifdef _WIN32
+  static_cast<void>(reserve);
+  // The stream always writes through the cache; Direct would otherwise stage into a buffer that is never allocated.
+  m_Mode = IoMode::Cached;
+  m_Stream.open(file, std::ios::binary | std::ios::trunc);
+#else
+  m_Fd = OpenFile(file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, m_Mode);
+  if (m_Fd < 0)
+    return;
+#ifdef __linux__
+  // Best effort: reserve blocks without changing the visible length.
+  if (reserve && *reserve > 0)
+    static_cast<void>(::fallocate(m_Fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(*reserve)));
+#else
+  static_cast<void>(reserve);
+#endif
+  if (m_Mode == IoMode::Direct)
+    m_Buffer = AllocateAligned(DIRECT_WRITE_CHUNK);
+#endif
+}
+
+OutputFile::~OutputFile()
+{
+  try
+  {
+    Close();
+  }
+  catch (...)
+  {
+  }
+}
+
+bool OutputFile::IsOpen() const noexcept
+{
+#ifdef _WIN32
+  return m_Stream.is_open();
+#else
+  return m_Fd >= 0;
+#endif
+}
+
+void OutputFile::Write(const char *data, std::size_t size)
+{
+  if (m_Mode != IoMode::Direct)
+  {
+    WriteThrough(data, size);
+    return;
+  }
+
+  while (size > 0)
+  {
+    const auto take = std::min(size, DIRECT_WRITE_CHUNK - m_Buffered);
+    std::copy_n(data, take, m_Buffer.get() + m_Buffered);
+    m_Buffered += take;
+    data += take;
+    size -= take;
+    if (m_Buffered == DIRECT_WRITE_CHUNK)
+    {
+      m_Buffered = 0;
+      WriteThrough(m_Buffer.get(), DIRECT_WRITE_CHUNK);
+    }
+  }
+}
+
+void OutputFile::Close()
+{
+  if (!IsOpen())
+    return;
+
+#ifdef _WIN32
+  m_Stream.close();
+  if (!m_Stream)
+    throw std::runtime_error("write failed");
+#else
+  const int fd = m_Fd;
+  try
+  {
+    if (m_Buffered > 0)
+    {
+      // Whole blocks still go direct; the unaligned tail is written through the cache and dropped.
+      const auto aligned = m_Buffered / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+      const auto tail = m_Buffered - aligned;
+      m_Buffered = 0;
+      if (aligned > 0)
+        WriteThrough(m_Buffer.get(), aligned);
+      if (tail > 0)
+      {
+        if (m_Mode == IoMode::Direct)
+          LeaveDirect(m_Fd, m_Mode);
+        WriteThrough(m_Buffer.get() + aligned, tail);
+      }
+    }
+    if (m_Mode == IoMode::Bulk)
+      DropWritten(true);
+  }
+  catch (...)
+  {
+    m_Fd = -1;
+    ::close(fd);
+    throw;
+  }
+
+  m_Fd = -1;
+  if (::close(fd) != 0)
+    throw std::runtime_error("close failed: " + SystemError());
+#endif
+}
+
+void OutputFile::WriteThrough(const char *data, std::size_t size)
+{
+#ifdef _WIN32
+  m_Stream.write(data, static_cast<std::streamsize>(size));
+  if (!m_Stream)
+    throw std::runtime_error("write failed");
+  m_Offset += size;
+  CountWrite(m_Mode, size);
+#else
+  while (size > 0)
+  {
+    const auto written = ::write(m_Fd, data, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      if (errno == EINVAL && m_Mode == IoMode::Direct)
+      {
+        LeaveDirect(m_Fd, m_Mode);
+        continue;
+      }
+      throw std::runtime_error("write failed: " + SystemError());
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+    m_Offset += static_cast<std::uint64_t>(written);
+    CountWrite(m_Mode, static_cast<std::uint64_t>(written));
+  }
+
+  if (m_Mode == IoMode::Bulk && m_Offset - m_Dropped >= CACHE_DROP_WINDOW)
+    DropWritten(false);
+#endif
+}
+
+void OutputFile::DropWritten([[maybe_unused]] bool all)
+{
+#ifndef _WIN32
+  if (m_Offset == m_Dropped)
+    return;
+  // Dirty pages cannot be dropped; write the range back first.
+#ifdef __linux__
+  if (::sync_file_range(m_Fd, static_cast<off_t>(m_Dropped), static_cast<off_t>(m_Offset - m_Dropped),
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+    throw std::runtime_error("write failed: " + SystemError());
+#else
+  if (all && ::fsync(m_Fd) != 0)
+    throw std::runtime_error("write failed: " + SystemError());
+#endif
+  Advise(m_Fd, m_Dropped, m_Offset - m_Dropped, ADVICE_DONTNEED);
+  m_Dropped = m_Offset;
+#endif
+}
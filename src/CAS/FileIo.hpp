@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CAS.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+
+#ifdef _WIN32
+#include <fstream>
+#endif
+
+/// @brief Sequential file reader/writer used by the CAS loops; honours CAS::IoMode.
+/// On Windows both fall back to plain buffered streams and the mode only affects the counters.
+namespace Docmasys::CAS::Detail
+{
+  /// @brief Bytes processed between two page-cache drops in Bulk mode.
+  inline constexpr std::uint64_t CACHE_DROP_WINDOW = 8u << 20; // 8 MiB
+
+  void CountRead(IoMode mode, std::uint64_t bytes) noexcept;
+  void CountWrite(IoMode mode, std::uint64_t bytes) noexcept;
+
+  struct AlignedFree
+  {
+    void operator()(char *buffer) const noexcept;
+  };
+  using AlignedBuffer = std::unique_ptr<char[], AlignedFree>;
+
+  class InputFile
+  {
+  public:
+    /// @param chunkSize Upper bound of the span returned by Read.
+    InputFile(const std::filesystem::path &file, IoMode mode, std::size_t chunkSize);
+    ~InputFile();
+
+    InputFile(const InputFile &) = delete;
+    InputFile &operator=(const InputFile &) = delete;
+
+    [[nodiscard]] bool IsOpen() const noexcept;
+    /// @brief Mode in effect; Direct degrades to Bulk when the filesystem refuses O_DIRECT.
+    [[nodiscard]] IoMode Mode() const noexcept { return m_Mode; }
+    /// @brief Next chunk of the file; empty at end of file. Throws std::runtime_error on I/O errors.
+    [[nodiscard]] std::span<const char> Read();
+
+  private:
+    IoMode m_Mode;
+    std::size_t m_ChunkSize;
+    AlignedBuffer m_Buffer;
+    std::uint64_t m_Offset{};
+    std::uint64_t m_Dropped{};
+    bool m_Eof{false};
+#ifdef _WIN32
+    std::ifstream m_Stream;
+#else
+    int m_Fd{-1};
+#endif
+  };
+
+  class OutputFile
+  {
+  public:
+    /// @brief Creates or truncates @p file.
+    /// @param reserve Size to reserve on disk up front (Linux); the file length is unchanged.
+    OutputFile(const std::filesystem::path &file, IoMode mode, std::optional<std::uint64_t> reserve = std::nullopt);
+    ~OutputFile();
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    [[nodiscard]] bool IsOpen() const noexcept;
+    [[nodiscard]] IoMode Mode() const noexcept { return m_Mode; }
+    /// @brief Throws std::runtime_error on I/O errors.
+    void Write(const char *data, std::size_t size);
+    /// @brief Flushes buffered data and closes; throws std::runtime_error on failure.
+    void Close();
+
+  private:
+    void WriteThrough(const char *data, std::size_t size);
+    void DropWritten(bool all);
+
+    IoMode m_Mode;
+    AlignedBuffer m_Buffer;
+    std::size_t m_Buffered{};
+    std::uint64_t m_Offset{};
+    std::uint64_t m_Dropped{};
+#ifdef _WIN32
+    std::ofstream m_Stream;
+#else
+    int m_Fd{-1};
+#endif
+  };
+}
@@ -0,0 +1,768 @@
+#include "IoEngine.hpp"
+#include "CASInternal.hpp"
+#include "FileIo.hpp"
+
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <zstd.h>
+
+#ifdef __linux__
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+using namespace Docmasys::CAS;
+
+namespace
+{
+  /// @brief Files kept open at the same time by one batched call.
+  constexpr unsigned FILES_IN_FLIGHT = 64;
+  /// @brief Read size per request; small files finish in one read.
+  constexpr size_t READ_CHUNK = 1u << 16; // 64 KiB
+  /// @brief Larger objects are streamed synchronously instead of being held in memory.
+  constexpr uint64_t RING_RETRIEVE_LIMIT = 4u << 20; // 4 MiB
+
+  std::vector<Identity> IdentifySynchronously(const std::vector<fs::path> &files, IoMode mode)
+  {
+    std::vector<Identity> identities;
+    identities.reserve(files.size());
+    for (const auto &file : files)
+      identities.push_back(Identify(file, mode));
+    return identities;
+  }
+
+#ifdef __linux__
+  /// @brief Minimal io_uring wrapper on raw syscalls (no liburing dependency).
+  class Ring
+  {
+  public:
+    explicit Ring(unsigned entries)
+    {
+      io_uring_params params{};
+      m_Fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+      if (m_Fd < 0)
+        throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+
+      m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+      if (singleMmap)
+        m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+
+      m_SqRing = ::mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+      if (m_SqRing == MAP_FAILED)
+      {
+        m_SqRing = nullptr;
+        Release();
+        throw std::runtime_error("io_uring: mmap of submission ring failed");
+      }
+
+      m_CqRing = singleMmap ? m_SqRing : ::mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING);
+      if (m_CqRing == MAP_FAILED)
+      {
+        m_CqRing = nullptr;
+        Release();
+        throw std::runtime_error("io_uring: mmap of completion ring failed");
+      }
+
+      m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+      auto *sqes = ::mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES);
+      if (sqes == MAP_FAILED)
+      {
+        Release();
+        throw std::runtime_error("io_uring: mmap of submission entries failed");
+      }
+      m_Sqes = static_cast<io_uring_sqe *>(sqes);
+
+      auto *sq = static_cast<char *>(m_SqRing);
+      auto *cq = static_cast<char *>(m_CqRing);
+      m_SqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+      m_SqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+      m_SqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+      m_SqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+      m_SqEntries = params.sq_entries;
+      m_CqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+      m_CqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+      m_CqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+      m_Cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+      m_SqLocalTail = *m_SqTail;
+    }
+
+    ~Ring() { Release(); }
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    /// @brief True when the kernel implements every opcode in @p ops.
+    [[nodiscard]] bool Supports(std::initializer_list<unsigned> ops) const
+    {
+      constexpr unsigned PROBE_OPS = 256;
+      std::vector<char> storage(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op));
+      auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+      if (::syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0)
+        return false;
+      for (const auto op : ops)
+        if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)
+          return false;
+      return true;
+    }
+
+    void PrepOpen(const char *path, int flags, unsigned mode, std::uint64_t userData)
+    {
+      auto &sqe = Next(IORING_OP_OPENAT, AT_FDCWD, userData);
+      sqe.addr = reinterpret_cast<std::uint64_t>(path);
+      sqe.len = mode;
+      sqe.open_flags = static_cast<std::uint32_t>(flags);
+    }
+
+    void PrepRead(int fd, char *buffer, unsigned length, std::uint64_t offset, std::uint64_t userData)
+    {
+      auto &sqe = Next(IORING_OP_READ, fd, userData);
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+      sqe.len = length;
+      sqe.off = offset;
+    }
+
+    void PrepWrite(int fd, const char *buffer, unsigned length, std::uint64_t offset, std::uint64_t userData)
+    {
+      auto &sqe = Next(IORING_OP_WRITE, fd, userData);
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+      sqe.len = length;
+      sqe.off = offset;
+    }
+
+    void PrepClose(int fd, std::uint64_t userData)
+    {
+      Next(IORING_OP_CLOSE, fd, userData);
+    }
+
+    void PrepRename(const char *from, const char *to, std::uint64_t userData)
+    {
+      auto &sqe = Next(IORING_OP_RENAMEAT, AT_FDCWD, userData);
+      sqe.addr = reinterpret_cast<std::uint64_t>(from);
+      sqe.len = static_cast<std::uint32_t>(AT_FDCWD);
+      sqe.addr2 = reinterpret_cast<std::uint64_t>(to);
+    }
+
+    /// @brief Hands every queued entry to the kernel in one syscall and waits for @p waitFor completions.
+    void Submit(unsigned waitFor)
+    {
+      std::atomic_ref<unsigned>(*m_SqTail).store(m_SqLocalTail, std::memory_order_release);
+      for (;;)
+      {
+        const auto submitted = ::syscall(__NR_io_uring_enter, m_Fd, m_Pending, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+        if (submitted >= 0)
+        {
+          m_Pending -= static_cast<unsigned>(submitted);
+          return;
+        }
+        if (errno != EINTR)
+          throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+      }
+    }
+
+    template <typename Handler>
+    void Drain(Handler &&handler)
+    {
+      unsigned head = *m_CqHead;
+      const unsigned tail = std::atomic_ref<unsigned>(*m_CqTail).load(std::memory_order_acquire);
+      for (; head != tail; ++head)
+      {
+        const auto &cqe = m_Cqes[head & m_CqMask];
+        const auto userData = cqe.user_data;
+        const auto result = cqe.res;
+        std::atomic_ref<unsigned>(*m_CqHead).store(head + 1, std::memory_order_release);
+        handler(userData, result);
+      }
+    }
+
+  private:
+    io_uring_sqe &Next(unsigned opcode, int fd, std::uint64_t userData)
+    {
+      const unsigned head = std::atomic_ref<unsigned>(*m_SqHead).load(std::memory_order_acquire);
+      if (m_SqLocalTail - head >= m_SqEntries)
+        throw std::runtime_error("io_uring: submission queue full");
+
+      const unsigned index = m_SqLocalTail & m_SqMask;
+      auto &sqe = m_Sqes[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = static_cast<std::uint8_t>(opcode);
+      sqe.fd = fd;
+      sqe.user_data = userData;
+      m_SqArray[index] = index;
+      ++m_SqLocalTail;
+      ++m_Pending;
+      return sqe;
+    }
+
+    void Release() noexcept
+    {
+      if (m_Sqes)
+        ::munmap(m_Sqes, m_SqesSize);
+      if (m_CqRing && m_CqRing != m_SqRing)
+        ::munmap(m_CqRing, m_CqRingSize);
+      if (m_SqRing)
+        ::munmap(m_SqRing, m_SqRingSize);
+      if (m_Fd >= 0)
+        ::close(m_Fd);
+      m_Sqes = nullptr;
+      m_CqRing = m_SqRing = nullptr;
+      m_Fd = -1;
+    }
+
+    int m_Fd{-1};
+    void *m_SqRing{};
+    void *m_CqRing{};
+    size_t m_SqRingSize{};
+    size_t m_CqRingSize{};
+    io_uring_sqe *m_Sqes{};
+    size_t m_SqesSize{};
+    unsigned *m_SqHead{};
+    unsigned *m_SqTail{};
+    unsigned *m_SqArray{};
+    unsigned m_SqMask{};
+    unsigned m_SqEntries{};
+    unsigned m_SqLocalTail{};
+    unsigned m_Pending{};
+    unsigned *m_CqHead{};
+    unsigned *m_CqTail{};
+    unsigned m_CqMask{};
+    io_uring_cqe *m_Cqes{};
+  };
+
+  std::string ErrnoMessage(const char *what, int result)
+  {
+    return std::string(what) + ": " + std::strerror(-result);
+  }
+
+  /// @brief Per-file state of IdentifyWithRing. Each slot has at most one request in flight.
+  struct HashSlot
+  {
+    enum class Stage : std::uint8_t { Idle, Opening, Reading, Closing };
+
+    Stage State{Stage::Idle};
+    size_t File{};
+    std::string Path;
+    int Fd{-1};
+    std::uint64_t Offset{};
+    EVP_MD_CTX *Md{};
+    std::vector<char> Buffer = std::vector<char>(READ_CHUNK);
+  };
+
+  /// @brief Requests a batch of @p items keeps in flight, and the ring size it needs.
+  unsigned SlotCount(size_t items)
+  {
+    return static_cast<unsigned>(std::min<size_t>(FILES_IN_FLIGHT, items));
+  }
+
+  /// @brief A ring with @p entries slots, or null when io_uring_setup fails (e.g. RLIMIT_MEMLOCK or fd exhaustion)
+  /// even though IoUringAvailable() passed; callers then fall back to the synchronous path.
+  std::unique_ptr<Ring> TryOpenRing(unsigned entries)
+  {
+    try
+    {
+      return std::make_unique<Ring>(entries);
+    }
+    catch (const std::exception &)
+    {
+      return nullptr;
+    }
+  }
+
+  std::vector<Identity> IdentifyWithRing(Ring &ring, const std::vector<fs::path> &files, IoMode mode)
+  {
+    if (mode == IoMode::Direct)
+      mode = IoMode::Bulk;
+    const unsigned slotCount = SlotCount(files.size());
+    std::vector<HashSlot> slots(slotCount);
+    std::vector<Identity> identities(files.size());
+    size_t next = 0;
+    unsigned active = 0;
+    std::string error;
+
+    const auto start = [&](std::uint64_t index)
+    {
+      auto &slot = slots[index];
+      slot.State = HashSlot::Stage::Idle;
+      if (next >= files.size() || !error.empty())
+        return;
+      slot.File = next++;
+      slot.Path = files[slot.File].string();
+      slot.Offset = 0;
+      slot.Fd = -1;
+      slot.Md = Detail::InitHash();
+      ring.PrepOpen(slot.Path.c_str(), O_RDONLY | O_CLOEXEC, 0, index);
+      slot.State = HashSlot::Stage::Opening;
+      ++active;
+    };
+
+    const auto fail = [&](HashSlot &slot, std::string message)
+    {
+      if (error.empty())
+        error = std::move(message);
+      if (slot.Md)
+        EVP_MD_CTX_free(slot.Md);
+      slot.Md = nullptr;
+    };
+
+    for (unsigned i = 0; i < slotCount; ++i)
+      start(i);
+
+    while (active > 0)
+    {
+      ring.Submit(1);
+      ring.Drain([&](std::uint64_t index, int result)
+                 {
+        auto &slot = slots[index];
+        --active;
+        // Nothing may throw past this point while other requests still reference slot buffers.
+        try
+        {
+          switch (slot.State)
+          {
+          case HashSlot::Stage::Opening:
+            if (result < 0)
+            {
+              fail(slot, "Identify: cannot open input");
+              start(index);
+              return;
+            }
+            slot.Fd = result;
+            ring.PrepRead(slot.Fd, slot.Buffer.data(), static_cast<unsigned>(slot.Buffer.size()), 0, index);
+            slot.State = HashSlot::Stage::Reading;
+            ++active;
+            return;
+
+          case HashSlot::Stage::Reading:
+            if (result < 0)
+              fail(slot, ErrnoMessage("Identify: read failed", result));
+            else if (result == 0)
+            {
+              identities[slot.File] = Detail::CloseHash(std::exchange(slot.Md, nullptr));
+            }
+            else
+            {
+              Detail::UpdateHash(slot.Md, slot.Buffer.data(), static_cast<size_t>(result));
+              Detail::CountRead(mode, static_cast<std::uint64_t>(result));
+              slot.Offset += static_cast<std::uint64_t>(result);
+              ring.PrepRead(slot.Fd, slot.Buffer.data(), static_cast<unsigned>(slot.Buffer.size()), slot.Offset, index);
+              ++active;
+              return;
+            }
+            if (mode == IoMode::Bulk)
+              static_cast<void>(::posix_fadvise(slot.Fd, 0, 0, POSIX_FADV_DONTNEED));
+            ring.PrepClose(slot.Fd, index);
+            slot.State = HashSlot::Stage::Closing;
+            ++active;
+            return;
+
+          case HashSlot::Stage::Closing:
+            slot.Fd = -1;
+            start(index);
+            return;
+
+          case HashSlot::Stage::Idle:
+            return;
+          }
+        }
+        catch (const std::exception &ex)
+        {
+          fail(slot, ex.what());
+          if (slot.Fd >= 0)
+          {
+            ::close(slot.Fd);
+            slot.Fd = -1;
+          }
+          slot.State = HashSlot::Stage::Idle;
+        } });
+    }
+
+    if (!error.empty())
+      throw std::runtime_error(error);
+    return identities;
+  }
+
+  /// @brief Per-object state of RetrieveWithRing.
+  struct RetrieveSlot
+  {
+    enum class Stage : std::uint8_t { Idle, OpeningObject, ReadingObject, ClosingObject, OpeningTemp, WritingTemp, ClosingTemp, Installing };
+
+    Stage State{Stage::Idle};
+    const RetrieveRequest *Request{};
+    std::string ObjectPath;
+    std::string TempPath;
+    std::string OutPath;
+    int Fd{-1};
+    std::uint64_t Offset{};
+    std::vector<char> Compressed;
+    std::vector<char> Content;
+    bool Failed{};
+  };
+
+  /// @brief Decompresses one complete in-memory object; throws on corruption.
+  void Decompress(const std::vector<char> &compressed, std::vector<char> &content)
+  {
+    const auto contentSize = ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR)
+      throw std::runtime_error("Retrieve: not a zstd frame");
+
+    if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN)
+    {
+      content.resize(static_cast<size_t>(contentSize));
+      const size_t r = ZSTD_decompress(content.data(), content.size(), compressed.data(), compressed.size());
+      if (ZSTD_isError(r))
+        throw std::runtime_error(std::string("Retrieve: zstd decompress failed: ") + ZSTD_getErrorName(r));
+      if (r != content.size())
+        throw std::runtime_error("Retrieve: unexpected EOF in compressed stream");
+      return;
+    }
+
+    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+    if (!dctx)
+      throw std::runtime_error("Retrieve: ZSTD_createDCtx failed");
+    content.clear();
+    std::vector<char> outBuf(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer zin{compressed.data(), compressed.size(), 0};
+    size_t r = 1;
+    while (zin.pos < zin.size && r != 0)
+    {
+      ZSTD_outBuffer zout{outBuf.data(), outBuf.size(), 0};
+      r = ZSTD_decompressStream(dctx, &zout, &zin);
+      if (ZSTD_isError(r))
+      {
+        ZSTD_freeDCtx(dctx);
+        throw std::runtime_error(std::string("Retrieve: zstd decompressStream failed: ") + ZSTD_getErrorName(r));
+      }
+      content.insert(content.end(), outBuf.data(), outBuf.data() + zout.pos);
+    }
+    ZSTD_freeDCtx(dctx);
+    if (r != 0)
+      throw std::runtime_error("Retrieve: unexpected EOF in compressed stream");
+  }
+
+  void RetrieveWithRing(Ring &ring, const fs::path &root, const std::vector<const RetrieveRequest *> &requests,
+                        const std::function<void(const RetrieveRequest &)> &installed)
+  {
+    const unsigned slotCount = SlotCount(requests.size());
+    std::vector<RetrieveSlot> slots(slotCount);
+    size_t next = 0;
+    unsigned active = 0;
+    std::string error;
+    const auto objectStore = Detail::ObjectStore(root);
+
+    const auto start = [&](std::uint64_t index)
+    {
+      auto &slot = slots[index];
+      slot.State = RetrieveSlot::Stage::Idle;
+      if (next >= requests.size())
+        return;
+      slot.Request = requests[next++];
+      slot.Failed = false;
+      slot.ObjectPath = Detail::CASLocation(objectStore, slot.Request->Hash).string();
+      slot.OutPath = slot.Request->OutFile.string();
+      slot.TempPath = Detail::TempOutputPath(slot.Request->OutFile).string();
+      slot.Offset = 0;
+      slot.Fd = -1;
+      slot.Compressed.clear();
+      ring.PrepOpen(slot.ObjectPath.c_str(), O_RDONLY | O_CLOEXEC, 0, index);
+      slot.State = RetrieveSlot::Stage::OpeningObject;
+      ++active;
+    };
+
+    const auto fail = [&](RetrieveSlot &slot, std::string message)
+    {
+      slot.Failed = true;
+      if (error.empty())
+        error = std::move(message);
+      if (slot.State >= RetrieveSlot::Stage::OpeningTemp)
+        ::unlink(slot.TempPath.c_str());
+    };
+
+    const auto readObject = [&](std::uint64_t index)
+    {
+      auto &slot = slots[index];
+      slot.Compressed.resize(static_cast<size_t>(slot.Offset) + READ_CHUNK);
+      ring.PrepRead(slot.Fd, slot.Compressed.data() + slot.Offset, static_cast<unsigned>(READ_CHUNK), slot.Offset, index);
+      ++active;
+    };
+
+    const auto writeTemp = [&](std::uint64_t index)
+    {
+      auto &slot = slots[index];
+      const auto remaining = slot.Content.size() - static_cast<size_t>(slot.Offset);
+      const auto length = static_cast<unsigned>(std::min<size_t>(remaining, 1u << 30));
+      ring.PrepWrite(slot.Fd, slot.Content.data() + slot.Offset, length, slot.Offset, index);
+      ++active;
+    };
+
+    for (unsigned i = 0; i < slotCount; ++i)
+      start(i);
+
+    while (active > 0)
+    {
+      ring.Submit(1);
+      ring.Drain([&](std::uint64_t index, int result)
+                 {
+        auto &slot = slots[index];
+        --active;
+        try
+        {
+          switch (slot.State)
+          {
+          case RetrieveSlot::Stage::OpeningObject:
+            if (result < 0)
+            {
+              fail(slot, result == -ENOENT ? "Retrieve: given identity doesn't exist" : ErrnoMessage("Retrieve: cannot open compressed object", result));
+              start(index);
+              return;
+            }
+            slot.Fd = result;
+            slot.State = RetrieveSlot::Stage::ReadingObject;
+            readObject(index);
+            return;
+
+          case RetrieveSlot::Stage::ReadingObject:
+            if (result < 0)
+            {
+              fail(slot, ErrnoMessage("Retrieve: read failed", result));
+              slot.Compressed.clear();
+            }
+            else if (result > 0)
+            {
+              slot.Offset += static_cast<std::uint64_t>(result);
+              Detail::CountRead(IoMode::Cached, static_cast<std::uint64_t>(result));
+              readObject(index);
+              return;
+            }
+            slot.Compressed.resize(static_cast<size_t>(slot.Offset));
+            ring.PrepClose(slot.Fd, index);
+            slot.State = RetrieveSlot::Stage::ClosingObject;
+            ++active;
+            return;
+
+          case RetrieveSlot::Stage::ClosingObject:
+            slot.Fd = -1;
+            if (slot.Compressed.empty())
+            {
+              if (!slot.Failed)
+                fail(slot, "Retrieve: unexpected EOF in compressed stream");
+              start(index);
+              return;
+            }
+            Decompress(slot.Compressed, slot.Content);
+            slot.Compressed.clear();
+            if (slot.Request->Options.ExpectedSize && slot.Content.size() != *slot.Request->Options.ExpectedSize)
+            {
+              fail(slot, "Retrieve: decompressed size does not match expected size");
+              start(index);
+              return;
+            }
+            if (slot.Request->Options.Verify)
+            {
+              auto *md = Detail::InitHash();
+              try
+              {
+                Detail::UpdateHash(md, slot.Content.data(), slot.Content.size());
+              }
+              catch (...)
+              {
+                EVP_MD_CTX_free(md);
+                throw;
+              }
+              if (Detail::CloseHash(md) != slot.Request->Hash)
+              {
+                fail(slot, "Retrieve: content hash mismatch, object is corrupt");
+                start(index);
+                return;
+              }
+            }
+            ring.PrepOpen(slot.TempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666, index);
+            slot.State = RetrieveSlot::Stage::OpeningTemp;
+            ++active;
+            return;
+
+          case RetrieveSlot::Stage::OpeningTemp:
+            if (result < 0)
+            {
+              fail(slot, ErrnoMessage("Retrieve: cannot open temp output", result));
+              start(index);
+              return;
+            }
+            slot.Fd = result;
+            slot.Offset = 0;
+            slot.State = RetrieveSlot::Stage::WritingTemp;
+            if (!slot.Content.empty())
+            {
+              writeTemp(index);
+              return;
+            }
+            result = 0;
+            [[fallthrough]];
+
+          case RetrieveSlot::Stage::WritingTemp:
+            if (result < 0)
+              fail(slot, ErrnoMessage("Retrieve: write failed", result));
+            else
+            {
+              slot.Offset += static_cast<std::uint64_t>(result);
+              Detail::CountWrite(IoMode::Cached, static_cast<std::uint64_t>(result));
+              if (slot.Offset < slot.Content.size())
+              {
+                writeTemp(index);
+                return;
+              }
+            }
+            ring.PrepClose(slot.Fd, index);
+            slot.State = RetrieveSlot::Stage::ClosingTemp;
+            ++active;
+            return;
+
+          case RetrieveSlot::Stage::ClosingTemp:
+            slot.Fd = -1;
+            slot.Content.clear();
+            if (result < 0 && !slot.Failed)
+              fail(slot, ErrnoMessage("Retrieve: write failed", result));
+            if (slot.Failed)
+            {
+              ::unlink(slot.TempPath.c_str());
+              start(index);
+              return;
+            }
+            ring.PrepRename(slot.TempPath.c_str(), slot.OutPath.c_str(), index);
+            slot.State = RetrieveSlot::Stage::Installing;
+            ++active;
+            return;
+
+          case RetrieveSlot::Stage::Installing:
+            if (result < 0)
+              fail(slot, ErrnoMessage("Retrieve: install failed", result));
+            else if (installed)
+              installed(*slot.Request);
+            start(index);
+            return;
+
+          case RetrieveSlot::Stage::Idle:
+            return;
+          }
+        }
+        catch (const std::exception &ex)
+        {
+          fail(slot, ex.what());
+          if (slot.Fd >= 0)
+            ::close(slot.Fd);
+          slot.Fd = -1;
+          start(index);
+        } });
+    }
+
+    if (!error.empty())
+      throw std::runtime_error(error);
+  }
+#endif
+}
+
+bool Docmasys::CAS::IoUringAvailable() noexcept
+{
+#ifdef __linux__
+  static const bool available = []
+  {
+    try
+    {
+      Ring ring(4);
+      return ring.Supports({IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE, IORING_OP_RENAMEAT});
+    }
+    catch (...)
+    {
+      return false;
+    }
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+std::vector<Identity> Docmasys::CAS::IdentifyMany(const std::vector<fs::path> &files, IoEngine engine, IoMode mode)
+{
+#ifdef __linux__
+  if (engine == IoEngine::IoUring && !files.empty() && IoUringAvailable())
+    if (const auto ring = TryOpenRing(SlotCount(files.size())))
+      return IdentifyWithRing(*ring, files, mode);
+#else
+  static_cast<void>(engine);
+#endif
+  return IdentifySynchronously(files, mode);
+}
+
+void Docmasys::CAS::RetrieveMany(const fs::path &root, const std::vector<RetrieveRequest> &requests, IoEngine engine,
+                                 const std::function<void(const RetrieveRequest &)> &installed)
+{
+  std::vector<const RetrieveRequest *> batched;
+  std::set<fs::path> preparedDirectories;
+  std::string error;
+  const auto retrieveOne = [&](const RetrieveRequest &request)
+  {
+    try
+    {
+      Retrieve(root, request.Hash, request.OutFile, request.Options);
+    }
+    catch (const std::exception &ex)
+    {
+      if (error.empty())
+        error = ex.what();
+      return;
+    }
+    if (installed)
+      installed(request);
+  };
+
+  for (const auto &request : requests)
+  {
+    // Without a size hint the object may be arbitrarily large, so it takes the streaming path rather than being held in memory.
+    const bool small = request.Options.ExpectedSize && *request.Options.ExpectedSize <= RING_RETRIEVE_LIMIT;
+    if (engine != IoEngine::IoUring || !small || request.Options.Mode != IoMode::Cached || !IoUringAvailable())
+    {
+      retrieveOne(request);
+      continue;
+    }
+
+    if (preparedDirectories.insert(request.OutFile.parent_path()).second)
+      fs::create_directories(Detail::TempOutputPath(request.OutFile).parent_path());
+    batched.push_back(&request);
+  }
+
+#ifdef __linux__
+  if (!batched.empty())
+  {
+    if (const auto ring = TryOpenRing(SlotCount(batched.size())))
+    {
+      try
+      {
+        RetrieveWithRing(*ring, root, batched, installed);
+      }
+      catch (const std::exception &ex)
+      {
+        if (error.empty())
+          error = ex.what();
+      }
+    }
+    else
+      for (const auto *request : batched)
+        retrieveOne(*request);
+  }
+#endif
+  if (!error.empty())
+    throw std::runtime_error(error);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include "CAS.hpp"
+
+/// @brief Batched variants of the CAS file operations for runs over many small files.
+namespace Docmasys::CAS
+{
+  enum class IoEngine : std::uint8_t
+  {
+    /// @brief One blocking file at a time through the regular CAS calls.
+    Synchronous = 0,
+    /// @brief Linux io_uring: open/read/write/close/rename of many files in flight per thread.
+    IoUring = 1,
+  };
+
+  /// @brief Whether the io_uring engine can run here (Linux build, kernel with the needed opcodes).
+  /// Batched calls silently use the synchronous engine when this is false.
+  [[nodiscard]] bool IoUringAvailable() noexcept;
+
+  /// @brief Calculate hash identities for many files.
+  /// @param files Full paths to local files.
+  /// @param engine Engine to use; falls back to Synchronous when unavailable.
+  /// @param mode Page-cache treatment; the io_uring engine handles Direct like Bulk.
+  /// @return SHA256 identities in the same order as @p files.
+  [[nodiscard]] std::vector<Identity> IdentifyMany(
+      const std::vector<std::filesystem::path> &files,
+      IoEngine engine,
+      IoMode mode = IoMode::Cached);
+
+  struct RetrieveRequest
+  {
+    Identity Hash{};
+    std::filesystem::path OutFile;
+    RetrieveOptions Options;
+  };
+
+  /// @brief Retrieve many stored files; each target is installed atomically like Retrieve.
+  /// A failing request does not stop the others; the first failure is thrown once every request was attempted.
+  /// Objects larger than a few MiB or without an ExpectedSize, and requests with a non-Cached IoMode, always use the
+  /// streaming synchronous path.
+  /// @param root Full path to the CAS vault root.
+  /// @param requests Objects and their targets.
+  /// @param engine Engine to use; falls back to Synchronous when unavailable.
+  /// @param installed Called for each request whose target was installed, so a caller can account for them
+  ///                  even when another request fails and the call throws.
+  void RetrieveMany(
+      const std::filesystem::path &root,
+      const std::vector<RetrieveRequest> &requests,
+      IoEngine engine,
+      const std::function<void(const RetrieveRequest &)> &installed = {});
+}
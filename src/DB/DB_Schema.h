@@ -12,10 +12,12 @@ namespace Docmasys::DB
   enum class RelationScope : std::uint8_t { None = 0, Strong = 1, StrongAndWeak = 2, All = 3 };
   enum class MaterializationKind : std::uint8_t { ReadOnlyCopy = 0, ReadOnlySymlink = 1, CheckoutCopy = 2 };
   enum class WorkspaceEntryState : std::uint8_t { Ok = 0, Missing = 1, Modified = 2, Replaced = 3 };
+  enum class ChangeKind : std::uint8_t { VersionCreated = 0, CurrentVersionChanged = 1, PropertySet = 2, PropertyRemoved = 3, RelationAdded = 4, RelationRemoved = 5, LockAcquired = 6, LockReleased = 7 };
 
-  struct Blob { Blob(const ID &id, const Identity &hash, const BlobStatus &status): Id(id), Hash(hash), Status(status) {} ID Id{}; Identity Hash{}; BlobStatus Status{BlobStatus::Pending}; };
+  struct Blob { Blob(const ID &id, const Identity &hash, const BlobStatus &status): Id(id), Hash(hash), Status(status) {} ID Id{}; Identity Hash{}; BlobStatus Status{BlobStatus::Pending}; std::optional<int> CompressionLevel; std::optional<std::uint64_t> RawSize; std::optional<std::uint64_t> StoredSize; };
+  struct BlobStorageInfo { int CompressionLevel{}; std::uint64_t RawSize{}; std::uint64_t StoredSize{}; };
   struct Folder { Folder(ID id, std::optional<ID> parent_id, const std::string &name): Id(id), ParentId(parent_id), Name(name) {} ID Id{}; std::optional<ID> ParentId; std::string Name; };
-  struct File { File(ID id, std::optional<ID> parent_id, const std::string &name, std::optional<ID> currentVersionId): Id(id), ParentId(parent_id), Name(name), CurrentVersionId(currentVersionId) {} ID Id{}; std::optional<ID> ParentId; std::string Name; std::optional<ID> CurrentVersionId; };
+  struct File { File(ID id, std::optional<ID> parent_id, const std::string &name, std::optional<ID> currentVersionId): Id(id), ParentId(parent_id), Name(name), CurrentVersionId(currentVersionId) {} ID Id{}; std::optional<ID> ParentId; std::string Name; std::optional<ID> CurrentVersionId; std::filesystem::path RelativePath; };
   struct FileVersion { FileVersion(ID id, ID fileId, ID blobId, std::int64_t versionNumber): Id(id), FileId(fileId), BlobId(blobId), VersionNumber(versionNumber) {} ID Id{}; ID FileId{}; ID BlobId{}; std::int64_t VersionNumber{}; };
   struct MaterializedFile { std::shared_ptr<File> LogicalFile; std::shared_ptr<FileVersion> Version; std::shared_ptr<Blob> BlobRef; std::filesystem::path RelativePath; };
   struct ImportResult { std::shared_ptr<FileVersion> Version; bool CreatedNewVersion{false}; };
@@ -40,23 +42,57 @@ namespace Docmasys::DB
     WorkspaceEntryState State{WorkspaceEntryState::Ok};
   };
 
-  static constexpr int DB_SCHEMA_VERSION = 1;
+  /// @brief Nullable columns added to schema version 1 after its release; older databases get them via ALTER TABLE.
+  struct SchemaColumn { const char *Table; const char *Column; const char *Definition; };
+  inline constexpr SchemaColumn DB_SCHEMA_ADDED_COLUMNS[] = {
+      {"blobs", "compression_level", "INTEGER"},
+      {"blobs", "raw_size", "INTEGER"},
+      {"blobs", "stored_size", "INTEGER"},
+      {"files", "relative_path", "TEXT COLLATE NOCASE"},
+  };
+
+  /// @brief Fills files.relative_path for rows that predate the column, resolving each folder chain once.
+  inline constexpr const char DB_BACKFILL_FILE_PATHS[] = R"SQL(
+    CREATE TEMP TABLE folder_paths (id INTEGER PRIMARY KEY, path TEXT NOT NULL);
+    INSERT INTO folder_paths(id, path)
+      WITH RECURSIVE walk(id, path) AS (
+        SELECT id, name FROM folders WHERE parent_id IS NULL
+        UNION ALL
+        SELECT f.id, walk.path || '/' || f.name FROM folders f JOIN walk ON f.parent_id = walk.id
+      )
+      SELECT id, path FROM walk;
+    UPDATE files SET relative_path = COALESCE((SELECT path || '/' FROM folder_paths WHERE id = files.parent_id), '') || name
+      WHERE relative_path IS NULL;
+    DROP TABLE temp.folder_paths;
+  )SQL";
+
+  /// @brief Per-connection settings for writer and readers: a 16 MiB page cache, reads through a 256 MiB memory map,
+  /// and a WAL file cut back to 64 MiB whenever a checkpoint lets it restart.
+  inline constexpr const char DB_CONNECTION_TUNING[] =
+      "PRAGMA cache_size = -16384; PRAGMA mmap_size = 268435456; PRAGMA journal_size_limit = 67108864;";
+
+  static constexpr int DB_SCHEMA_VERSION = 2;
   inline constexpr const char DB_SCHEMA[] = R"SQL(
-    CREATE TABLE IF NOT EXISTS blobs (id INTEGER PRIMARY KEY, hash BLOB NOT NULL CHECK (length(hash) = 32), status INT NOT NULL CHECK (status IN (0,1)), UNIQUE(hash));
-    CREATE INDEX IF NOT EXISTS idx_blobs ON blobs(hash);
+    CREATE TABLE IF NOT EXISTS blobs (id INTEGER PRIMARY KEY, hash BLOB NOT NULL CHECK (length(hash) = 32), status INT NOT NULL CHECK (status IN (0,1)), compression_level INTEGER, raw_size INTEGER, stored_size INTEGER, UNIQUE(hash));
     CREATE TABLE IF NOT EXISTS folders (id INTEGER PRIMARY KEY, parent_id INTEGER REFERENCES folders(id) ON DELETE CASCADE, name TEXT NOT NULL COLLATE NOCASE);
     CREATE UNIQUE INDEX IF NOT EXISTS uq_folders_parent_name ON folders(parent_id, name) WHERE parent_id IS NOT NULL;
     CREATE UNIQUE INDEX IF NOT EXISTS uq_folders_root_name ON folders(name) WHERE parent_id IS NULL;
     CREATE INDEX IF NOT EXISTS idx_folders_parent ON folders(parent_id);
-    CREATE TABLE IF NOT EXISTS files (id INTEGER PRIMARY KEY, parent_id INTEGER REFERENCES folders(id) ON DELETE CASCADE, name TEXT NOT NULL COLLATE NOCASE, current_version_id INTEGER, UNIQUE(parent_id, name), FOREIGN KEY(current_version_id) REFERENCES file_versions(id) ON DELETE RESTRICT);
+    CREATE TABLE IF NOT EXISTS files (id INTEGER PRIMARY KEY, parent_id INTEGER REFERENCES folders(id) ON DELETE CASCADE, name TEXT NOT NULL COLLATE NOCASE, current_version_id INTEGER, relative_path TEXT COLLATE NOCASE, UNIQUE(parent_id, name), FOREIGN KEY(current_version_id) REFERENCES file_versions(id) ON DELETE RESTRICT);
     CREATE INDEX IF NOT EXISTS idx_files_parent ON files(parent_id);
     CREATE INDEX IF NOT EXISTS idx_files_current_version ON files(current_version_id);
+    CREATE UNIQUE INDEX IF NOT EXISTS uq_files_relative_path ON files(relative_path);
     CREATE TABLE IF NOT EXISTS file_versions (id INTEGER PRIMARY KEY, file_id INTEGER NOT NULL REFERENCES files(id) ON DELETE CASCADE, version_number INTEGER NOT NULL, blob_id INTEGER NOT NULL REFERENCES blobs(id) ON DELETE RESTRICT, UNIQUE(file_id, version_number));
-    CREATE INDEX IF NOT EXISTS idx_file_versions_file ON file_versions(file_id);
     CREATE INDEX IF NOT EXISTS idx_file_versions_blob ON file_versions(blob_id);
-    CREATE TABLE IF NOT EXISTS version_relations (from_version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE, to_version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE, relation_type INTEGER NOT NULL CHECK (relation_type IN (0,1,2)), PRIMARY KEY(from_version_id, to_version_id, relation_type));
+    CREATE TABLE IF NOT EXISTS version_relations (from_version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE, to_version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE, relation_type INTEGER NOT NULL CHECK (relation_type IN (0,1,2)), PRIMARY KEY(from_version_id, to_version_id, relation_type)) WITHOUT ROWID;
     CREATE TRIGGER IF NOT EXISTS trg_version_relations_no_self_loop BEFORE INSERT ON version_relations FOR EACH ROW WHEN NEW.from_version_id = NEW.to_version_id BEGIN SELECT RAISE(ABORT, 'version relation cycle detected'); END;
-    CREATE TRIGGER IF NOT EXISTS trg_version_relations_no_cycle BEFORE INSERT ON version_relations FOR EACH ROW WHEN EXISTS (WITH RECURSIVE reach(id) AS (SELECT NEW.to_version_id UNION SELECT vr.to_version_id FROM version_relations vr JOIN reach ON vr.from_version_id = reach.id) SELECT 1 FROM reach WHERE id = NEW.from_version_id) BEGIN SELECT RAISE(ABORT, 'version relation cycle detected'); END;
+    DROP TRIGGER IF EXISTS trg_version_relations_no_cycle;
+    -- Carries the primary key, so incoming-relation and where-used lookups never touch the table.
+    CREATE INDEX IF NOT EXISTS idx_version_relations_to ON version_relations(to_version_id);
+    -- Topological order of every version that takes part in a relation: position(from) < position(to) for each edge.
+    -- Database::AddRelation keeps it (and thereby acyclicity) up to date incrementally.
+    CREATE TABLE IF NOT EXISTS version_order (version_id INTEGER PRIMARY KEY REFERENCES file_versions(id) ON DELETE CASCADE, position INTEGER NOT NULL);
+    CREATE INDEX IF NOT EXISTS idx_version_order_position ON version_order(position);
     CREATE TABLE IF NOT EXISTS version_properties (
       version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE,
       name TEXT NOT NULL,
@@ -70,23 +106,168 @@ namespace Docmasys::DB
              (value_type = 2 AND string_value IS NULL AND int_value IS NULL AND bool_value IN (0,1))),
       PRIMARY KEY(version_id, normalized_name)
     );
-    CREATE INDEX IF NOT EXISTS idx_version_properties_version ON version_properties(version_id);
+    CREATE INDEX IF NOT EXISTS idx_version_properties_int ON version_properties(normalized_name, int_value);
+    CREATE INDEX IF NOT EXISTS idx_version_properties_string ON version_properties(normalized_name, string_value);
+    -- Canonical workspace roots, stored once and referenced by id.
+    CREATE TABLE IF NOT EXISTS workspaces (id INTEGER PRIMARY KEY, root TEXT NOT NULL, UNIQUE(root));
     CREATE TABLE IF NOT EXISTS workspace_entries (
-      workspace_root TEXT NOT NULL,
+      workspace_id INTEGER NOT NULL REFERENCES workspaces(id) ON DELETE CASCADE,
       file_id INTEGER NOT NULL REFERENCES files(id) ON DELETE CASCADE,
       version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE,
       relative_path TEXT NOT NULL,
       materialization_kind INTEGER NOT NULL CHECK (materialization_kind IN (0,1,2)),
-      PRIMARY KEY(workspace_root, file_id),
-      UNIQUE(workspace_root, relative_path)
-    );
-    CREATE INDEX IF NOT EXISTS idx_workspace_entries_workspace ON workspace_entries(workspace_root);
+      PRIMARY KEY(workspace_id, file_id),
+      UNIQUE(workspace_id, relative_path)
+    ) WITHOUT ROWID;
+    -- Named, immutable snapshots of every file's current version; entries are written once by Database::CreateBaseline.
+    CREATE TABLE IF NOT EXISTS baselines (id INTEGER PRIMARY KEY, name TEXT NOT NULL COLLATE NOCASE, created_at INTEGER NOT NULL, UNIQUE(name));
+    CREATE TABLE IF NOT EXISTS baseline_entries (
+      baseline_id INTEGER NOT NULL REFERENCES baselines(id) ON DELETE CASCADE,
+      file_id INTEGER NOT NULL REFERENCES files(id) ON DELETE CASCADE,
+      version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE RESTRICT,
+      PRIMARY KEY(baseline_id, file_id)
+    ) WITHOUT ROWID;
+    CREATE TRIGGER IF NOT EXISTS trg_baseline_entries_immutable BEFORE UPDATE ON baseline_entries BEGIN SELECT RAISE(ABORT, 'baselines are immutable'); END;
     CREATE TABLE IF NOT EXISTS checkout_locks (
       file_id INTEGER PRIMARY KEY REFERENCES files(id) ON DELETE CASCADE,
       version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE,
       user_name TEXT NOT NULL,
       environment_name TEXT NOT NULL,
-      workspace_root TEXT NOT NULL
+      workspace_id INTEGER NOT NULL REFERENCES workspaces(id) ON DELETE CASCADE
+    );
+  )SQL";
+
+  /// @brief Append-only change journal, written by triggers inside the transaction that makes each change.
+  /// AUTOINCREMENT keeps sequence numbers strictly increasing even if the newest entries were ever deleted.
+  /// Rows carry plain ids without foreign keys, so they outlive what they describe. Applied after any migration,
+  /// so rows copied by DB_MIGRATE_V1_COPY are not journaled.
+  inline constexpr const char DB_CHANGE_JOURNAL_SCHEMA[] = R"SQL(
+    CREATE TABLE IF NOT EXISTS change_journal (
+      sequence INTEGER PRIMARY KEY AUTOINCREMENT,
+      kind INTEGER NOT NULL,
+      file_id INTEGER,
+      version_id INTEGER,
+      target_version_id INTEGER,
+      detail TEXT,
+      recorded_at INTEGER NOT NULL
     );
+    CREATE TRIGGER IF NOT EXISTS trg_journal_version_insert AFTER INSERT ON file_versions BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, recorded_at) VALUES (0, NEW.file_id, NEW.id, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_current_version AFTER UPDATE OF current_version_id ON files
+    WHEN NEW.current_version_id IS NOT OLD.current_version_id BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, recorded_at) VALUES (1, NEW.id, NEW.current_version_id, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_property_insert AFTER INSERT ON version_properties BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, detail, recorded_at)
+        VALUES (2, (SELECT file_id FROM file_versions WHERE id = NEW.version_id), NEW.version_id, NEW.name, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_property_update AFTER UPDATE ON version_properties BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, detail, recorded_at)
+        VALUES (2, (SELECT file_id FROM file_versions WHERE id = NEW.version_id), NEW.version_id, NEW.name, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_property_delete AFTER DELETE ON version_properties BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, detail, recorded_at)
+        VALUES (3, (SELECT file_id FROM file_versions WHERE id = OLD.version_id), OLD.version_id, OLD.name, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_relation_insert AFTER INSERT ON version_relations BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, target_version_id, detail, recorded_at)
+        VALUES (4, (SELECT file_id FROM file_versions WHERE id = NEW.from_version_id), NEW.from_version_id, NEW.to_version_id,
+                CASE NEW.relation_type WHEN 0 THEN 'strong' WHEN 1 THEN 'weak' ELSE 'optional' END, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_relation_delete AFTER DELETE ON version_relations BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, target_version_id, detail, recorded_at)
+        VALUES (5, (SELECT file_id FROM file_versions WHERE id = OLD.from_version_id), OLD.from_version_id, OLD.to_version_id,
+                CASE OLD.relation_type WHEN 0 THEN 'strong' WHEN 1 THEN 'weak' ELSE 'optional' END, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_lock_insert AFTER INSERT ON checkout_locks BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, detail, recorded_at)
+        VALUES (6, NEW.file_id, NEW.version_id, NEW.user_name || '@' || NEW.environment_name, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_lock_update AFTER UPDATE ON checkout_locks BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, detail, recorded_at)
+        VALUES (6, NEW.file_id, NEW.version_id, NEW.user_name || '@' || NEW.environment_name, CAST(strftime('%s','now') AS INTEGER));
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_journal_lock_delete AFTER DELETE ON checkout_locks BEGIN
+      INSERT INTO change_journal(kind, file_id, version_id, detail, recorded_at)
+        VALUES (7, OLD.file_id, OLD.version_id, OLD.user_name || '@' || OLD.environment_name, CAST(strftime('%s','now') AS INTEGER));
+    END;
+  )SQL";
+
+  /// @brief First step of the v1 to v2 migration: moves the tables whose layout changed aside, together with the
+  /// index and trigger names DB_SCHEMA would otherwise find taken. DB_SCHEMA then creates the v2 tables.
+  inline constexpr const char DB_MIGRATE_V1_PREPARE[] = R"SQL(
+    ALTER TABLE version_relations RENAME TO v1_version_relations;
+    ALTER TABLE workspace_entries RENAME TO v1_workspace_entries;
+    ALTER TABLE checkout_locks RENAME TO v1_checkout_locks;
+    DROP INDEX IF EXISTS idx_version_relations_to;
+    DROP TRIGGER IF EXISTS trg_version_relations_no_self_loop;
+  )SQL";
+
+  /// @brief Second step of the v1 to v2 migration: interns workspace roots, copies the moved rows into the v2 tables
+  /// and drops the v1 tables and the indexes that only duplicated a UNIQUE constraint or primary-key prefix.
+  inline constexpr const char DB_MIGRATE_V1_COPY[] = R"SQL(
+    INSERT INTO workspaces(root)
+      SELECT workspace_root FROM v1_workspace_entries UNION SELECT workspace_root FROM v1_checkout_locks;
+    INSERT INTO version_relations(from_version_id, to_version_id, relation_type)
+      SELECT from_version_id, to_version_id, relation_type FROM v1_version_relations;
+    INSERT INTO workspace_entries(workspace_id, file_id, version_id, relative_path, materialization_kind)
+      SELECT w.id, e.file_id, e.version_id, e.relative_path, e.materialization_kind
+      FROM v1_workspace_entries e JOIN workspaces w ON w.root = e.workspace_root;
+    INSERT INTO checkout_locks(file_id, version_id, user_name, environment_name, workspace_id)
+      SELECT l.file_id, l.version_id, l.user_name, l.environment_name, w.id
+      FROM v1_checkout_locks l JOIN workspaces w ON w.root = l.workspace_root;
+    DROP TABLE v1_version_relations;
+    DROP TABLE v1_workspace_entries;
+    DROP TABLE v1_checkout_locks;
+    DROP INDEX IF EXISTS idx_blobs;
+    DROP INDEX IF EXISTS idx_file_versions_file;
+    DROP INDEX IF EXISTS idx_version_properties_version;
+  )SQL";
+
+  /// @brief Per-connection scratch table holding the roots of one Database::ResolveMaterialization call.
+  inline constexpr const char DB_TEMP_MATERIALIZATION_ROOTS[] =
+      "CREATE TEMP TABLE IF NOT EXISTS materialization_roots (version_id INTEGER NOT NULL, scope INTEGER NOT NULL, PRIMARY KEY(version_id, scope)) WITHOUT ROWID;";
+
+  /// @brief FTS5 indexes over string property values and file names, kept in sync by triggers. External content
+  /// means only the token index is stored; version_properties has no INTEGER PRIMARY KEY, so its rowids can change
+  /// under VACUUM and the property index must be rebuilt afterwards. Created only when SQLite has FTS5; applying it
+  /// rebuilds both indexes, so it runs only while a trigger is missing (new or previously FTS5-less databases).
+  inline constexpr const char DB_FULL_TEXT_SCHEMA[] = R"SQL(
+    CREATE VIRTUAL TABLE IF NOT EXISTS property_text_index USING fts5(string_value, content='version_properties');
+    CREATE VIRTUAL TABLE IF NOT EXISTS file_name_index USING fts5(name, content='files', content_rowid='id');
+    CREATE TRIGGER IF NOT EXISTS trg_property_text_insert AFTER INSERT ON version_properties BEGIN
+      INSERT INTO property_text_index(rowid, string_value) VALUES (NEW.rowid, NEW.string_value);
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_property_text_delete AFTER DELETE ON version_properties BEGIN
+      INSERT INTO property_text_index(property_text_index, rowid, string_value) VALUES ('delete', OLD.rowid, OLD.string_value);
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_property_text_update AFTER UPDATE OF string_value ON version_properties BEGIN
+      INSERT INTO property_text_index(property_text_index, rowid, string_value) VALUES ('delete', OLD.rowid, OLD.string_value);
+      INSERT INTO property_text_index(rowid, string_value) VALUES (NEW.rowid, NEW.string_value);
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_file_name_insert AFTER INSERT ON files BEGIN
+      INSERT INTO file_name_index(rowid, name) VALUES (NEW.id, NEW.name);
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_file_name_delete AFTER DELETE ON files BEGIN
+      INSERT INTO file_name_index(file_name_index, rowid, name) VALUES ('delete', OLD.id, OLD.name);
+    END;
+    CREATE TRIGGER IF NOT EXISTS trg_file_name_update AFTER UPDATE OF name ON files BEGIN
+      INSERT INTO file_name_index(file_name_index, rowid, name) VALUES ('delete', OLD.id, OLD.name);
+      INSERT INTO file_name_index(rowid, name) VALUES (NEW.id, NEW.name);
+    END;
+    INSERT INTO property_text_index(property_text_index) VALUES ('rebuild');
+    INSERT INTO file_name_index(file_name_index) VALUES ('rebuild');
+  )SQL";
+
+  /// @brief Run instead of DB_FULL_TEXT_SCHEMA by builds without FTS5, whose writes would otherwise fail inside the
+  /// triggers. The orphaned indexes are rebuilt by the next FTS5 build that opens the database.
+  inline constexpr const char DB_DROP_FULL_TEXT_TRIGGERS[] = R"SQL(
+    DROP TRIGGER IF EXISTS trg_property_text_insert;
+    DROP TRIGGER IF EXISTS trg_property_text_delete;
+    DROP TRIGGER IF EXISTS trg_property_text_update;
+    DROP TRIGGER IF EXISTS trg_file_name_insert;
+    DROP TRIGGER IF EXISTS trg_file_name_delete;
+    DROP TRIGGER IF EXISTS trg_file_name_update;
   )SQL";
 }
@@ -4,8 +4,68 @@ namespace fs = std::filesystem;
 using namespace Docmasys;
 using namespace Docmasys::DB;
 
-Database::Database(const fs::path &databaseFile, const fs::path &localVaultRoot) : m_DatabaseFile(databaseFile), m_LocalVaultRoot(localVaultRoot)
+namespace
 {
+  /// @brief Copies every page of @p source's main database into @p destination in one backup step.
+  void BackupDatabase(sqlite3 *source, sqlite3 *destination)
+  {
+    auto *backup = sqlite3_backup_init(destination, "main", source, "main");
+    if (!backup)
+      throw std::runtime_error(sqlite3_errmsg(destination));
+    const int result = sqlite3_backup_step(backup, -1);
+    sqlite3_backup_finish(backup);
+    if (result != SQLITE_DONE)
+      throw std::runtime_error(std::string("database backup failed: ") + sqlite3_errstr(result));
+  }
+
+  /// @brief Owns a connection used only for a backup.
+  struct BackupConnection
+  {
+    sqlite3 *Db = nullptr;
+    BackupConnection(const fs::path &file, int flags)
+    {
+      if (sqlite3_open_v2(file.string().c_str(), &Db, flags, nullptr) != SQLITE_OK || !Db)
+      {
+        sqlite3_close(Db);
+        throw std::runtime_error("SQLite open failed: " + file.string());
+      }
+      sqlite3_busy_timeout(Db, 5000);
+    }
+    ~BackupConnection() { sqlite3_close(Db); }
+    BackupConnection(const BackupConnection &) = delete;
+    BackupConnection &operator=(const BackupConnection &) = delete;
+  };
+}
+
+Database::Database(const fs::path &databaseFile, const fs::path &localVaultRoot, StorageMode storage) : m_DatabaseFile(databaseFile), m_LocalVaultRoot(localVaultRoot)
+{
+  if (storage == StorageMode::Memory)
+  {
+    sqlite3 *db = nullptr;
+    if (sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK || !db)
+    {
+      sqlite3_close(db);
+      throw std::runtime_error("SQLite open failed");
+    }
+    m_Database = std::make_unique<Impl>(db);
+    m_Database->m_Storage = StorageMode::Memory;
+
+    if (fs::exists(m_DatabaseFile))
+    {
+      BackupConnection source(m_DatabaseFile, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
+      // A backup into an in-memory database fails when the page sizes differ; an empty database can still change its own.
+      Sqlite::Statement pageSize(source.Db, "PRAGMA page_size;");
+      pageSize.ExpectRow();
+      const auto sql = "PRAGMA page_size = " + std::to_string(sqlite3_column_int(pageSize.get(), 0)) + ";";
+      ExecSQL(sql.c_str());
+      BackupDatabase(source.Db, db);
+    }
+    ExecSQL("PRAGMA auto_vacuum = INCREMENTAL; PRAGMA foreign_keys = ON;");
+    ExecSQL(DB_CONNECTION_TUNING);
+    EnsureSchema();
+    return;
+  }
+
   if (!m_DatabaseFile.parent_path().empty())
     fs::create_directories(m_DatabaseFile.parent_path());
 
@@ -14,12 +74,61 @@ Database::Database(const fs::path &databaseFile, const fs::path &localVaultRoot)
     throw std::runtime_error("SQLite open failed");
 
   m_Database = std::make_unique<Impl>(db);
-  ExecSQL("PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA foreign_keys = ON;");
+  // auto_vacuum only takes effect on a database that is still empty, and switching to WAL already counts as content;
+  // existing archives keep their mode until Maintain runs a full vacuum.
+  ExecSQL("PRAGMA auto_vacuum = INCREMENTAL; PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA foreign_keys = ON;");
+  ExecSQL(DB_CONNECTION_TUNING);
   EnsureSchema();
 }
 
+Database::Database(const fs::path &databaseFile, const fs::path &localVaultRoot, ReadOnlyTag) : m_DatabaseFile(databaseFile), m_LocalVaultRoot(localVaultRoot)
+{
+  sqlite3 *db = nullptr;
+  if (sqlite3_open_v2(m_DatabaseFile.string().c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK || !db)
+  {
+    sqlite3_close(db);
+    throw std::runtime_error("SQLite open failed");
+  }
+
+  m_Database = std::make_unique<Impl>(db);
+  sqlite3_busy_timeout(db, 5000);
+  ExecSQL(DB_CONNECTION_TUNING);
+  m_Database->m_FullTextSearch = sqlite3_compileoption_used("ENABLE_FTS5") &&
+                                 Sqlite::Statement(db, "SELECT 1 FROM sqlite_master WHERE name = 'property_text_index';").Step() == SQLITE_ROW;
+}
+
 Database::~Database() = default;
 
+Database::ReadSession Database::OpenReadSession()
+{
+  if (m_Database->m_Storage == StorageMode::Memory)
+    throw std::runtime_error("read sessions need an archive stored in its database file");
+  {
+    std::lock_guard lock(m_Database->m_ReaderMutex);
+    if (!m_Database->m_IdleReaders.empty())
+    {
+      auto reader = std::move(m_Database->m_IdleReaders.back());
+      m_Database->m_IdleReaders.pop_back();
+      return ReadSession(*this, std::move(reader));
+    }
+  }
+  return ReadSession(*this, std::unique_ptr<Database>(new Database(m_DatabaseFile, m_LocalVaultRoot, ReadOnlyTag{})));
+}
+
+Database::ReadSession::~ReadSession()
+{
+  if (!m_Reader)
+    return;
+  try
+  {
+    std::lock_guard lock(m_Owner->m_Database->m_ReaderMutex);
+    m_Owner->m_Database->m_IdleReaders.push_back(std::move(m_Reader));
+  }
+  catch (...)
+  {
+  }
+}
+
 void Database::ExecSQL(const char *sql)
 {
   char *err = nullptr;
@@ -31,9 +140,93 @@ void Database::ExecSQL(const char *sql)
   }
 }
 
-void Database::OpenTransaction() { ExecSQL("BEGIN IMMEDIATE;"); }
-void Database::Commit() { ExecSQL("COMMIT;"); }
-void Database::Rollback() { sqlite3_exec(m_Database->m_db, "ROLLBACK;", nullptr, nullptr, nullptr); }
+void Database::OpenTransaction()
+{
+  m_Database->Prepare(m_Database->m_TransactionDepth == 0 ? StatementId::BeginTransaction : StatementId::Savepoint).ExpectDone();
+  ++m_Database->m_TransactionDepth;
+}
+
+void Database::Commit()
+{
+  if (m_Database->m_TransactionDepth == 0)
+    throw std::runtime_error("no open transaction");
+  m_Database->Prepare(m_Database->m_TransactionDepth == 1 ? StatementId::CommitTransaction : StatementId::ReleaseSavepoint).ExpectDone();
+  --m_Database->m_TransactionDepth;
+}
+
+void Database::Rollback()
+{
+  if (m_Database->m_TransactionDepth == 0)
+    return;
+  const bool nested = m_Database->m_TransactionDepth-- > 1;
+  m_Database->m_Folders.clear();
+  m_Database->m_Workspaces.clear();
+  try
+  {
+    if (nested)
+    {
+      // ROLLBACK TO keeps the savepoint open; RELEASE pops it without committing anything.
+      (void)m_Database->Prepare(StatementId::RollbackToSavepoint).Step();
+      (void)m_Database->Prepare(StatementId::ReleaseSavepoint).Step();
+    }
+    else
+      (void)m_Database->Prepare(StatementId::RollbackTransaction).Step();
+  }
+  catch (...)
+  {
+  }
+}
+
+Database::Transaction::Transaction(Database &database) : m_Database(database)
+{
+  m_Database.OpenTransaction();
+}
+
+Database::Transaction::~Transaction()
+{
+  if (!m_Done)
+    m_Database.Rollback();
+}
+
+void Database::Transaction::Commit()
+{
+  if (m_Done)
+    throw std::runtime_error("transaction already finished");
+  m_Database.Commit();
+  m_Done = true;
+}
+
+StatementStatistics Database::GetStatementStatistics() const noexcept
+{
+  const auto &counters = m_Database->m_Counters;
+  return {counters.Prepares, counters.CacheHits, counters.Steps};
+}
+
+StorageMode Database::GetStorageMode() const noexcept
+{
+  return m_Database->m_Storage;
+}
+
+void Database::SaveSnapshot(const fs::path &target)
+{
+  if (m_Database->m_TransactionDepth != 0)
+    throw std::runtime_error("a snapshot cannot be saved inside a transaction");
+  if (m_Database->m_Storage == StorageMode::File && fs::exists(target) && fs::equivalent(target, m_DatabaseFile))
+    throw std::runtime_error("a file archive cannot be snapshotted onto itself");
+  if (!target.parent_path().empty())
+    fs::create_directories(target.parent_path());
+
+  BackupConnection destination(target, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX);
+  BackupDatabase(m_Database->m_db, destination.Db);
+  // The copied header carries the source's journal mode, which is "memory" for an in-memory archive.
+  char *error = nullptr;
+  if (sqlite3_exec(destination.Db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &error) != SQLITE_OK)
+  {
+    const std::string message = error ? error : "failed to enable WAL";
+    sqlite3_free(error);
+    throw std::runtime_error(message);
+  }
+}
 
 void Database::EnsureSchema()
 {
@@ -42,12 +235,46 @@ void Database::EnsureSchema()
   if (version == 0)
   {
     ExecSQL(DB_SCHEMA);
+    ExecSQL(DB_CHANGE_JOURNAL_SCHEMA);
     Detail::SetUserVersion(m_Database->m_db, DB_SCHEMA_VERSION);
+    EnsureFullTextSchema();
     return;
   }
 
+  if (version > DB_SCHEMA_VERSION)
+    throw std::runtime_error("database schema version is newer than this build supports");
+  for (const auto &column : DB_SCHEMA_ADDED_COLUMNS)
+    if (!Detail::HasColumn(m_Database->m_db, column.Table, column.Column))
+      ExecSQL((std::string("ALTER TABLE ") + column.Table + " ADD COLUMN " + column.Column + " " + column.Definition + ";").c_str());
   MigrateSchemaIfNeeded(version);
   ExecSQL(DB_SCHEMA);
+  ExecSQL(DB_CHANGE_JOURNAL_SCHEMA);
+
+  const bool unresolvedPaths = Sqlite::Statement(m_Database->m_db, "SELECT 1 FROM files WHERE relative_path IS NULL LIMIT 1;").Step() == SQLITE_ROW;
+  if (unresolvedPaths)
+    ExecSQL(DB_BACKFILL_FILE_PATHS);
+  const bool unorderedRelations = Sqlite::Statement(m_Database->m_db, "SELECT 1 WHERE EXISTS (SELECT 1 FROM version_relations) AND NOT EXISTS (SELECT 1 FROM version_order);").Step() == SQLITE_ROW;
+  if (unorderedRelations)
+    RebuildRelationOrder();
+  EnsureFullTextSchema();
+}
+
+void Database::EnsureFullTextSchema()
+{
+  if (!sqlite3_compileoption_used("ENABLE_FTS5"))
+  {
+    ExecSQL(DB_DROP_FULL_TEXT_TRIGGERS);
+    return;
+  }
+
+  const bool complete = Sqlite::Statement(m_Database->m_db,
+                                          "SELECT 1 WHERE (SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' AND name IN "
+                                          "('trg_property_text_insert', 'trg_property_text_delete', 'trg_property_text_update', "
+                                          "'trg_file_name_insert', 'trg_file_name_delete', 'trg_file_name_update')) = 6;")
+                            .Step() == SQLITE_ROW;
+  if (!complete)
+    ExecSQL(DB_FULL_TEXT_SCHEMA);
+  m_Database->m_FullTextSearch = true;
 }
 
 void Database::MigrateSchemaIfNeeded(int version)
@@ -55,10 +282,105 @@ void Database::MigrateSchemaIfNeeded(int version)
   if (version == DB_SCHEMA_VERSION)
     return;
 
-  if (version > DB_SCHEMA_VERSION)
-    throw std::runtime_error("database schema version is newer than this build supports");
+  if (version != 1)
+    throw std::runtime_error("unsupported pre-release database schema version; recreate the archive database");
+
+  // v1 to v2 rebuilds the tables that held workspace roots as text and makes version_relations WITHOUT ROWID.
+  // Table rebuilds need foreign key enforcement off, which SQLite only allows outside a transaction; the
+  // copied rows are checked with foreign_key_check before the transaction commits.
+  ExecSQL("PRAGMA foreign_keys = OFF;");
+  try
+  {
+    Transaction transaction(*this);
+    ExecSQL(DB_MIGRATE_V1_PREPARE);
+    ExecSQL(DB_SCHEMA);
+    ExecSQL(DB_MIGRATE_V1_COPY);
+    if (Sqlite::Statement(m_Database->m_db, "PRAGMA foreign_key_check;").Step() == SQLITE_ROW)
+      throw std::runtime_error("schema migration found rows with dangling references");
+    Detail::SetUserVersion(m_Database->m_db, DB_SCHEMA_VERSION);
+    transaction.Commit();
+  }
+  catch (...)
+  {
+    ExecSQL("PRAGMA foreign_keys = ON;");
+    throw;
+  }
+  ExecSQL("PRAGMA foreign_keys = ON;");
+}
+
+DatabaseMetrics Database::GetDatabaseMetrics()
+{
+  const auto pragma = [&](const char *sql)
+  {
+    Sqlite::Statement statement(m_Database->m_db, sql);
+    if (statement.Step() != SQLITE_ROW)
+      throw std::runtime_error(std::string("failed to read ") + sql);
+    return static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 0));
+  };
+  const auto fileSize = [](const fs::path &path)
+  {
+    std::error_code error;
+    const auto size = fs::file_size(path, error);
+    return error ? std::uint64_t{} : static_cast<std::uint64_t>(size);
+  };
+
+  DatabaseMetrics metrics{
+      .PageSize = pragma("PRAGMA page_size;"),
+      .PageCount = pragma("PRAGMA page_count;"),
+      .FreePages = pragma("PRAGMA freelist_count;"),
+      .DatabaseBytes = fileSize(m_DatabaseFile),
+      .WalBytes = fileSize(fs::path(m_DatabaseFile.string() + "-wal")),
+      .IncrementalVacuum = pragma("PRAGMA auto_vacuum;") == 2};
+  if (m_Database->m_Storage == StorageMode::Memory)
+  {
+    metrics.DatabaseBytes = metrics.PageSize * metrics.PageCount;
+    metrics.WalBytes = 0;
+  }
+  return metrics;
+}
+
+MaintenanceReport Database::Maintain(const MaintenanceOptions &options)
+{
+  if (m_Database->m_TransactionDepth != 0)
+    throw std::runtime_error("maintenance cannot run inside a transaction");
+
+  MaintenanceReport report;
+  report.Before = GetDatabaseMetrics();
+
+  if (options.Analyze)
+    ExecSQL("ANALYZE;");
+  if (options.Optimize)
+    ExecSQL("PRAGMA optimize;");
+
+  if (options.FullVacuum)
+  {
+    ExecSQL("PRAGMA auto_vacuum = INCREMENTAL; VACUUM;");
+    // VACUUM may renumber version_properties rowids, which the external-content property index refers to.
+    if (m_Database->m_FullTextSearch)
+      ExecSQL("INSERT INTO property_text_index(property_text_index) VALUES('rebuild');");
+  }
+  else if (options.VacuumPages && report.Before.IncrementalVacuum && report.Before.FreePages > 0)
+  {
+    const auto sql = "PRAGMA incremental_vacuum(" + std::to_string(*options.VacuumPages) + ");";
+    ExecSQL(sql.c_str());
+  }
+
+  if (options.Checkpoint != CheckpointMode::None && m_Database->m_Storage == StorageMode::File)
+  {
+    int mode = SQLITE_CHECKPOINT_PASSIVE;
+    if (options.Checkpoint == CheckpointMode::Full)
+      mode = SQLITE_CHECKPOINT_FULL;
+    else if (options.Checkpoint == CheckpointMode::Truncate)
+      mode = SQLITE_CHECKPOINT_TRUNCATE;
+    const int result = sqlite3_wal_checkpoint_v2(m_Database->m_db, nullptr, mode, &report.WalFrames, &report.CheckpointedFrames);
+    if (result == SQLITE_BUSY)
+      report.CheckpointBusy = true;
+    else if (result != SQLITE_OK)
+      throw std::runtime_error(sqlite3_errmsg(m_Database->m_db));
+  }
 
-  throw std::runtime_error("unsupported pre-release database schema version; recreate the archive database");
+  report.After = GetDatabaseMetrics();
+  return report;
 }
 
 bool Database::TryGetRelativePath(const fs::path &file, fs::path &out) const
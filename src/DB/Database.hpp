@@ -1,12 +1,16 @@
 #pragma once
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
+#include "../CAS/IoEngine.hpp"
 #include "../Types.hpp"
 #include "DB_Schema.h"
+#include "RowSet.hpp"
 
 namespace Docmasys::DB
 {
@@ -17,12 +21,254 @@ namespace Docmasys::DB
     RelationType Type;
   };
 
+  /// @brief One root of a multi-root materialization and the relations followed from it.
+  struct MaterializationRoot
+  {
+    ID VersionId{};
+    RelationScope Scope{RelationScope::None};
+  };
+
+  /// @brief One current file as reported by Database::InspectFiles.
+  /// RelativePath points into the statement's row buffer and is only valid inside the visitor call.
+  struct InspectionRow
+  {
+    std::string_view RelativePath;
+    std::int64_t VersionNumber{};
+    BlobStatus Status{BlobStatus::Pending};
+    std::uint64_t PropertyCount{};
+    std::uint64_t OutgoingRelationCount{};
+  };
+
+  /// @brief Comparison applied by a PropertyQuery; Bool values support only Equal and NotEqual.
+  enum class PropertyComparison : std::uint8_t
+  {
+    Equal,
+    NotEqual,
+    Less,
+    LessOrEqual,
+    Greater,
+    GreaterOrEqual
+  };
+
+  /// @brief Versions whose property @c Name compares to @c Value; properties of another type never match.
+  struct PropertyQuery
+  {
+    std::string Name;
+    PropertyComparison Comparison{PropertyComparison::Equal};
+    PropertyValue Value{std::string{}};
+    bool CurrentOnly{true};
+    /// @brief Rooted vault folder such as "ROOT/docs"; only files below it match.
+    std::optional<std::filesystem::path> PathPrefix;
+  };
+
+  /// @brief One version reported by Database::FindVersionsByProperty.
+  /// RelativePath points into the statement's row buffer and is only valid inside the visitor call.
+  struct PropertyMatch
+  {
+    ID FileId{};
+    std::int64_t VersionNumber{};
+    std::string_view RelativePath;
+    VersionProperty Property;
+  };
+
+  /// @brief Options for Database::SearchText.
+  struct TextSearchOptions
+  {
+    /// @brief Skip properties of superseded versions; file-name hits always report the current version.
+    bool CurrentOnly{true};
+    std::size_t Limit{100};
+  };
+
+  /// @brief One string property or file name reported by Database::SearchText.
+  /// The views point into the statement's row buffer and are only valid inside the visitor call.
+  struct TextSearchHit
+  {
+    ID FileId{};
+    std::int64_t VersionNumber{};
+    std::string_view RelativePath;
+    /// @brief Matching property name; empty when the file name matched.
+    std::string_view PropertyName;
+    std::string_view Text;
+    /// @brief FTS5 bm25 score, lower is better; only comparable among hits of the same kind (property or file name).
+    /// 0 when the archive has no full-text index.
+    double Rank{};
+  };
+
+  /// @brief A version that depends on the queried one, as reported by Database::ForEachWhereUsed.
+  /// RelativePath points into the statement's row buffer and is only valid inside the visitor call.
+  struct WhereUsedRow
+  {
+    ID VersionId{};
+    ID FileId{};
+    std::int64_t VersionNumber{};
+    std::string_view RelativePath;
+    /// @brief Relation steps from the queried version; 1 for direct users.
+    std::size_t Depth{};
+    /// @brief Strongest relation type from this version to the one that led to it.
+    RelationType Type{RelationType::Strong};
+    bool IsCurrent{};
+  };
+
+  /// @brief A named snapshot of the current version of every file, as created by Database::CreateBaseline.
+  struct Baseline
+  {
+    ID Id{};
+    std::string Name;
+    /// @brief Unix time in seconds.
+    std::int64_t CreatedAt{};
+    std::uint64_t FileCount{};
+  };
+
+  /// @brief A file whose version differs between two baselines, as reported by Database::DiffBaselines.
+  /// RelativePath points into the statement's row buffer and is only valid inside the visitor call.
+  struct BaselineDifference
+  {
+    ID FileId{};
+    std::string_view RelativePath;
+    /// @brief Version in the first baseline; empty when the file was added after it.
+    std::optional<std::int64_t> FromVersion;
+    /// @brief Version in the second baseline; empty when the file is not part of it.
+    std::optional<std::int64_t> ToVersion;
+  };
+
+  /// @brief One change journal entry, as reported by Database::ForEachChangeSince.
+  /// The views point into the statement's row buffer and are only valid inside the visitor call.
+  struct ChangeRecord
+  {
+    std::int64_t Sequence{};
+    ChangeKind Kind{ChangeKind::VersionCreated};
+    ID FileId{};
+    /// @brief Version created, made current, given or stripped of a property, relation source or locked version.
+    std::optional<ID> VersionId;
+    std::optional<std::int64_t> VersionNumber;
+    /// @brief Path of the file today; empty if the file no longer exists.
+    std::string_view RelativePath;
+    /// @brief Relation target; only set for RelationAdded and RelationRemoved.
+    std::optional<ID> TargetVersionId;
+    std::optional<std::int64_t> TargetVersionNumber;
+    std::string_view TargetRelativePath;
+    /// @brief Property name, relation type, or "user@environment" for lock events.
+    std::string_view Detail;
+    /// @brief Unix time in seconds.
+    std::int64_t RecordedAt{};
+  };
+
+  /// @brief Where Database::Open keeps the archive database.
+  enum class StorageMode : std::uint8_t
+  {
+    /// @brief The database file itself, in WAL mode.
+    File,
+    /// @brief A private in-memory database without WAL or fsync traffic, loaded from the database file when one exists.
+    /// Nothing reaches the file until Database::SaveSnapshot; read sessions are not available.
+    Memory
+  };
+
+  /// @brief How Database::Maintain checkpoints the WAL; only Passive never waits for readers or the writer.
+  enum class CheckpointMode : std::uint8_t
+  {
+    None,
+    Passive,
+    Full,
+    Truncate
+  };
+
+  /// @brief Steps run by Database::Maintain, in order: statistics, vacuum, checkpoint.
+  struct MaintenanceOptions
+  {
+    /// @brief PRAGMA optimize: refreshes planner statistics that SQLite considers stale.
+    bool Optimize{true};
+    /// @brief Full ANALYZE of every table and index.
+    bool Analyze{false};
+    /// @brief Free pages returned by incremental vacuum; 0 returns all of them. Needs auto_vacuum=INCREMENTAL.
+    std::optional<std::uint64_t> VacuumPages{0};
+    /// @brief Rebuilds the file with VACUUM and switches it to auto_vacuum=INCREMENTAL. Blocks writers while it runs.
+    bool FullVacuum{false};
+    CheckpointMode Checkpoint{CheckpointMode::Passive};
+  };
+
+  /// @brief Size and free-space figures of the archive database file.
+  struct DatabaseMetrics
+  {
+    std::uint64_t PageSize{};
+    std::uint64_t PageCount{};
+    std::uint64_t FreePages{};
+    std::uint64_t DatabaseBytes{};
+    std::uint64_t WalBytes{};
+    bool IncrementalVacuum{};
+
+    /// @brief Share of the file's pages that hold no data.
+    [[nodiscard]] double FreeFraction() const noexcept { return PageCount ? static_cast<double>(FreePages) / static_cast<double>(PageCount) : 0.0; }
+  };
+
+  /// @brief Outcome of Database::Maintain.
+  struct MaintenanceReport
+  {
+    DatabaseMetrics Before;
+    DatabaseMetrics After;
+    /// @brief WAL frames before the checkpoint and frames copied into the database by it.
+    int WalFrames{};
+    int CheckpointedFrames{};
+    /// @brief The checkpoint could not finish because of active readers or a writer; Passive never reports this.
+    bool CheckpointBusy{};
+  };
+
+  /// @brief Prepared-statement activity on this connection since it was opened.
+  struct StatementStatistics
+  {
+    std::uint64_t Prepares{};
+    std::uint64_t CacheHits{};
+    std::uint64_t Steps{};
+  };
+
+  /// @brief Metadata access for one archive.
+  /// A Database returned by Open owns the writer connection and must be used by one thread at a time.
+  /// Other threads read through OpenReadSession, which is the only member that may be called concurrently.
   class Database
   {
   public:
-    [[nodiscard]] static std::unique_ptr<Database> Open(const std::filesystem::path &databaseFile, const std::filesystem::path &localVaultRoot)
+    /// @brief Groups several Database calls into one SQLite transaction; transactions opened inside it become savepoints.
+    /// Rolls back on destruction unless committed.
+    class Transaction
+    {
+    public:
+      explicit Transaction(Database &database);
+      ~Transaction();
+      Transaction(const Transaction &) = delete;
+      Transaction &operator=(const Transaction &) = delete;
+
+      void Commit();
+
+    private:
+      Database &m_Database;
+      bool m_Done{false};
+    };
+
+    /// @brief Read-only WAL connection leased from the pool of the Database that opened it.
+    /// A session belongs to one thread at a time; it sees the writer's committed state as of each query,
+    /// and returns its connection to the pool when destroyed. End all sessions before destroying the pool owner.
+    class ReadSession
     {
-      return std::unique_ptr<Database>(new Database(databaseFile, localVaultRoot));
+    public:
+      ReadSession(ReadSession &&other) noexcept = default;
+      ReadSession &operator=(ReadSession &&) = delete;
+      ~ReadSession();
+
+      /// @brief Read-only view; write calls fail with a SQLite read-only error.
+      [[nodiscard]] Database &operator*() const noexcept { return *m_Reader; }
+      [[nodiscard]] Database *operator->() const noexcept { return m_Reader.get(); }
+
+    private:
+      friend class Database;
+      ReadSession(Database &owner, std::unique_ptr<Database> reader) : m_Owner(&owner), m_Reader(std::move(reader)) {}
+
+      Database *m_Owner;
+      std::unique_ptr<Database> m_Reader;
+    };
+
+    [[nodiscard]] static std::unique_ptr<Database> Open(const std::filesystem::path &databaseFile, const std::filesystem::path &localVaultRoot,
+                                                        StorageMode storage = StorageMode::File)
+    {
+      return std::unique_ptr<Database>(new Database(databaseFile, localVaultRoot, storage));
     }
 
     ~Database();
@@ -30,8 +276,19 @@ namespace Docmasys::DB
     [[nodiscard]] inline const std::filesystem::path &VaultRoot() const noexcept { return m_LocalVaultRoot; }
 
     ImportResult Import(const std::filesystem::path &file, const Identity &blobHash);
+    /// @brief Import of content whose blob row is already known, skipping the blob insert and lookup.
+    ImportResult Import(const std::filesystem::path &file, const KnownBlob &blob);
+    /// @brief Hash, id and status of every blob from one table scan, for resolving duplicate content without per-file lookups.
+    BlobIndex LoadBlobIndex();
+    /// @brief Adds a pending blob for each new hash of @p hashes with multi-row INSERTs and returns every blob of @p hashes once,
+    /// including those that already existed.
+    std::vector<KnownBlob> InsertBlobs(const std::vector<Identity> &hashes);
     std::shared_ptr<Blob> UpdateBlobStatus(const std::shared_ptr<Blob> &blob, const BlobStatus &newStatus);
+    std::shared_ptr<Blob> MarkBlobStored(const std::shared_ptr<Blob> &blob, const BlobStorageInfo &info);
     std::shared_ptr<Blob> GetBlob(ID blobId);
+    std::vector<std::shared_ptr<Blob>> ListBlobsMissingSizes();
+    void SetBlobSizes(const std::shared_ptr<Blob> &blob, std::uint64_t rawSize, std::uint64_t storedSize);
+    std::uint64_t GetCurrentContentSize();
     std::vector<std::shared_ptr<Folder>> GetFolders(const std::shared_ptr<Folder> &folder);
     std::vector<MaterializedFile> GetMaterializedFiles(const std::shared_ptr<Folder> &folder);
     std::shared_ptr<File> GetFileByRelativePath(const std::filesystem::path &relativeFilePath);
@@ -39,14 +296,52 @@ namespace Docmasys::DB
     std::shared_ptr<FileVersion> GetFileVersion(const std::shared_ptr<File> &file, const std::optional<std::int64_t> &versionNumber);
     std::vector<std::shared_ptr<FileVersion>> GetFileVersions(const std::shared_ptr<File> &file);
     std::vector<VersionRelationView> GetOutgoingRelations(const std::shared_ptr<FileVersion> &from, std::optional<RelationType> typeFilter);
+    std::vector<VersionRelationView> GetIncomingRelations(const std::shared_ptr<FileVersion> &to, std::optional<RelationType> typeFilter);
+    /// @brief Streams every version that reaches @p versionId through relations allowed by @p scope, breadth-first,
+    /// each once at its shortest distance, up to @p maxDepth steps. Each step is one indexed lookup on to_version_id.
+    void ForEachWhereUsed(ID versionId, RelationScope scope, std::optional<std::size_t> maxDepth, const std::function<void(const WhereUsedRow &)> &visitor);
     std::vector<MaterializedFile> ResolveMaterialization(const std::shared_ptr<FileVersion> &rootVersion, RelationScope scope);
+    /// @brief Union of the closures of all @p roots from one recursive query, each version once, ordered by file id.
+    /// Throws when two roots select different versions of the same file.
+    std::vector<MaterializedFile> ResolveMaterialization(const std::vector<MaterializationRoot> &roots);
+    /// @brief ResolveMaterialization as value rows, without per-row heap objects.
+    MaterializedRows ResolveMaterializationRows(ID rootVersionId, RelationScope scope);
+    /// @brief Streams ResolveMaterialization rows; throws on a materialization conflict once it is reached.
+    void ForEachMaterialization(ID rootVersionId, RelationScope scope, const std::function<void(const MaterializedRow &)> &visitor);
+    /// @brief Adds an edge unless it closes a cycle. Checking it only searches and reorders the versions that lie
+    /// between the two endpoints in the maintained topological order (Pearce-Kelly).
     void AddRelation(const std::shared_ptr<FileVersion> &from, const std::shared_ptr<FileVersion> &to, RelationType type);
     std::filesystem::path BuildRelativePath(const std::shared_ptr<File> &file);
     std::vector<MaterializedFile> InspectCurrentFiles();
+    /// @brief InspectCurrentFiles as value rows, without per-row heap objects.
+    MaterializedRows InspectCurrentFileRows();
+    /// @brief Streams every current file ordered by file id.
+    /// Visitors may call other members; row views are only valid during the call.
+    void ForEachCurrentFile(const std::function<void(const MaterializedRow &)> &visitor);
+    /// @brief Streams every current file with its property and outgoing relation counts from one query, ordered by file id.
+    void InspectFiles(const std::function<void(const InspectionRow &)> &visitor);
     void SetVersionProperty(const std::shared_ptr<FileVersion> &version, const std::string &name, const PropertyValue &value);
     std::optional<VersionProperty> GetVersionProperty(const std::shared_ptr<FileVersion> &version, const std::string &name);
     std::vector<VersionProperty> ListVersionProperties(const std::shared_ptr<FileVersion> &version);
     bool RemoveVersionProperty(const std::shared_ptr<FileVersion> &version, const std::string &name);
+    /// @brief Streams the versions matching @p query ordered by path and version number, seeking the property value indexes.
+    void FindVersionsByProperty(const PropertyQuery &query, const std::function<void(const PropertyMatch &)> &visitor);
+    /// @brief Streams string properties and file names containing every whitespace-separated term of @p terms.
+    /// Property hits and file-name hits are each ranked best first by their own index and then interleaved, since bm25 scores
+    /// of different indexes are not comparable. A trailing '*' makes a term a prefix. Without FTS5 this falls back to an unranked substring scan, ordered by path.
+    void SearchText(const std::string &terms, const TextSearchOptions &options, const std::function<void(const TextSearchHit &)> &visitor);
+    /// @brief Whether SearchText uses the FTS5 index on this connection.
+    [[nodiscard]] bool HasFullTextIndex() const noexcept;
+
+    /// @brief Records the current version of every file under @p name with one INSERT...SELECT; names are unique, case-insensitively.
+    Baseline CreateBaseline(const std::string &name);
+    std::optional<Baseline> GetBaseline(const std::string &name);
+    std::vector<Baseline> ListBaselines();
+    bool RemoveBaseline(const std::string &name);
+    /// @brief Every file of baseline @p name at its recorded version, ordered by file id, from one primary-key range scan.
+    std::vector<MaterializedFile> ResolveBaseline(const std::string &name);
+    /// @brief Streams the files added, removed or changed from baseline @p from to baseline @p to, ordered by path.
+    void DiffBaselines(const std::string &from, const std::string &to, const std::function<void(const BaselineDifference &)> &visitor);
 
     void UpsertWorkspaceEntry(const std::filesystem::path &workspaceRoot,
                               const std::shared_ptr<File> &file,
@@ -56,6 +351,10 @@ namespace Docmasys::DB
     std::optional<WorkspaceEntry> GetWorkspaceEntry(const std::filesystem::path &workspaceRoot,
                                                     const std::shared_ptr<File> &file);
     std::vector<WorkspaceEntry> ListWorkspaceEntries(const std::filesystem::path &workspaceRoot);
+    /// @brief ListWorkspaceEntries as value rows, without per-row heap objects.
+    WorkspaceRows ListWorkspaceEntryRows(const std::filesystem::path &workspaceRoot);
+    /// @brief Streams the entries of @p workspaceRoot ordered by workspace path.
+    void ForEachWorkspaceEntry(const std::filesystem::path &workspaceRoot, const std::function<void(const WorkspaceRow &)> &visitor);
     void AcquireCheckoutLock(const std::shared_ptr<File> &file,
                              const std::shared_ptr<FileVersion> &version,
                              const std::string &user,
@@ -63,25 +362,57 @@ namespace Docmasys::DB
                              const std::filesystem::path &workspaceRoot);
     std::optional<CheckoutLock> GetCheckoutLock(const std::shared_ptr<File> &file);
     std::vector<CheckoutLock> ListCheckoutLocks();
+    void ForEachCheckoutLock(const std::function<void(const CheckoutLock &)> &visitor);
     bool ReleaseCheckoutLock(const std::shared_ptr<File> &file,
                              const std::string &user,
                              const std::string &environment,
                              const std::filesystem::path &workspaceRoot);
     bool ForceReleaseCheckoutLock(const std::shared_ptr<File> &file);
-    std::vector<WorkspaceEntryStatus> GetWorkspaceStatus(const std::filesystem::path &workspaceRoot);
+    std::vector<WorkspaceEntryStatus> GetWorkspaceStatus(const std::filesystem::path &workspaceRoot,
+                                                         CAS::IoEngine engine = CAS::IoEngine::Synchronous,
+                                                         CAS::IoMode mode = CAS::IoMode::Cached);
+    /// @brief Streams GetWorkspaceStatus in workspace-path order, holding at most one hashing batch in memory.
+    void ForEachWorkspaceStatus(const std::filesystem::path &workspaceRoot,
+                                CAS::IoEngine engine,
+                                CAS::IoMode mode,
+                                const std::function<void(const WorkspaceEntryStatus &)> &visitor);
+    /// @brief Sequence number of the newest journal entry, 0 for an empty journal. Read it in the same read session
+    /// as a full scan to know where following ForEachChangeSince calls should continue.
+    std::int64_t GetLastChangeSequence();
+    /// @brief Streams journal entries with a sequence number above @p sequence in order, at most @p limit of them.
+    /// Costs one range scan of the journal's primary key, independent of the archive's size.
+    void ForEachChangeSince(std::int64_t sequence, std::optional<std::size_t> limit, const std::function<void(const ChangeRecord &)> &visitor);
+    DatabaseMetrics GetDatabaseMetrics();
+    /// @brief Refreshes statistics, returns free pages and checkpoints the WAL as @p options asks, measuring the file
+    /// before and after. Readers in other connections keep working; only FullVacuum holds the write lock for long.
+    MaintenanceReport Maintain(const MaintenanceOptions &options);
+    [[nodiscard]] StatementStatistics GetStatementStatistics() const noexcept;
+    [[nodiscard]] StorageMode GetStorageMode() const noexcept;
+    /// @brief Copies the committed database to @p target with the SQLite online backup API and leaves it in WAL mode.
+    /// This is how a StorageMode::Memory archive is persisted; on a file archive it takes a consistent online copy.
+    void SaveSnapshot(const std::filesystem::path &target);
+    /// @brief Leases a pooled read connection, opening a new one when none is idle. Thread-safe.
+    [[nodiscard]] ReadSession OpenReadSession();
 
   private:
-    Database(const std::filesystem::path &databaseFile, const std::filesystem::path &localVaultRoot);
-    void ExecSQL(const char *sql); void OpenTransaction(); void Commit(); void Rollback(); void EnsureSchema(); void MigrateSchemaIfNeeded(int version);
+    Database(const std::filesystem::path &databaseFile, const std::filesystem::path &localVaultRoot, StorageMode storage);
+    struct ReadOnlyTag
+    {
+    };
+    Database(const std::filesystem::path &databaseFile, const std::filesystem::path &localVaultRoot, ReadOnlyTag);
+    void ExecSQL(const char *sql); void OpenTransaction(); void Commit(); void Rollback(); void EnsureSchema(); void EnsureFullTextSchema(); void MigrateSchemaIfNeeded(int version);
+    void PlaceRelation(ID from, ID to);
+    void RebuildRelationOrder();
     std::shared_ptr<Blob> GetBlobByHashOrId(const std::optional<ID> &id, const std::optional<Identity> &blobHash);
     std::shared_ptr<Folder> GetOrCreateFolder(const std::string &name, const std::shared_ptr<Folder> &parent);
     std::shared_ptr<Blob> GetOrCreateBlob(const Identity &blobHash);
-    std::shared_ptr<File> GetOrCreateFile(const std::string &name, const std::shared_ptr<Folder> &folder);
+    ID GetOrCreateWorkspace(const std::filesystem::path &workspaceRoot);
+    std::shared_ptr<File> GetOrCreateFile(const std::string &name, const std::shared_ptr<Folder> &folder, const std::string &relativePath);
     std::shared_ptr<FileVersion> CreateFileVersion(const std::shared_ptr<File> &file, const std::shared_ptr<Blob> &blob);
     std::shared_ptr<File> SetCurrentVersion(const std::shared_ptr<File> &file, const std::shared_ptr<FileVersion> &version);
-    std::shared_ptr<Folder> GetFolderById(ID folderId);
     bool TryGetRelativePath(const std::filesystem::path &file, std::filesystem::path &outRelative) const;
-    ImportResult InsertToDB(const std::filesystem::path &relativeFilePath, const Identity &blobHash);
+    /// @brief Creates the version unless the file already holds the content; a null @p knownBlob gets or creates the blob row first.
+    ImportResult InsertToDB(const std::filesystem::path &relativeFilePath, const Identity &blobHash, const KnownBlob *knownBlob);
 
     Database(const Database &) = delete; Database &operator=(const Database &) = delete; Database(Database &&) = delete; Database &operator=(Database &&) = delete;
     const std::filesystem::path m_DatabaseFile; const std::filesystem::path m_LocalVaultRoot; struct Impl; std::unique_ptr<Impl> m_Database;
@@ -0,0 +1,107 @@
+#include "DatabaseInternal.hpp"
+
+using namespace Docmasys;
+using namespace Docmasys::DB;
+
+namespace
+{
+  Baseline ReadBaseline(sqlite3_stmt *statement)
+  {
+    return Baseline{
+        .Id = sqlite3_column_int64(statement, 0),
+        .Name = std::string(Detail::TextView(statement, 1)),
+        .CreatedAt = sqlite3_column_int64(statement, 2),
+        .FileCount = static_cast<std::uint64_t>(sqlite3_column_int64(statement, 3))};
+  }
+
+  std::optional<std::int64_t> OptInt64(sqlite3_stmt *statement, int column)
+  {
+    if (sqlite3_column_type(statement, column) == SQLITE_NULL)
+      return std::nullopt;
+    return sqlite3_column_int64(statement, column);
+  }
+}
+
+Baseline Database::CreateBaseline(const std::string &name)
+{
+  if (name.empty())
+    throw std::runtime_error("baseline requires a name");
+
+  Transaction transaction(*this);
+  if (GetBaseline(name))
+    throw std::runtime_error("baseline already exists: " + name);
+  {
+    auto statement = m_Database->Prepare(StatementId::InsertBaseline);
+    statement.BindText(1, name);
+    statement.ExpectDone();
+  }
+  {
+    auto statement = m_Database->Prepare(StatementId::CaptureBaselineEntries);
+    statement.BindInt64(1, sqlite3_last_insert_rowid(m_Database->m_db));
+    statement.ExpectDone();
+  }
+  auto baseline = GetBaseline(name);
+  transaction.Commit();
+  return *baseline;
+}
+
+std::optional<Baseline> Database::GetBaseline(const std::string &name)
+{
+  auto statement = m_Database->Prepare(StatementId::SelectBaselineByName);
+  statement.BindText(1, name);
+  if (statement.Step() != SQLITE_ROW)
+    return std::nullopt;
+  return ReadBaseline(statement.get());
+}
+
+std::vector<Baseline> Database::ListBaselines()
+{
+  auto statement = m_Database->Prepare(StatementId::SelectBaselines);
+  std::vector<Baseline> baselines;
+  while (statement.Step() == SQLITE_ROW)
+    baselines.push_back(ReadBaseline(statement.get()));
+  return baselines;
+}
+
+bool Database::RemoveBaseline(const std::string &name)
+{
+  auto statement = m_Database->Prepare(StatementId::DeleteBaseline);
+  statement.BindText(1, name);
+  statement.ExpectDone();
+  return sqlite3_changes(m_Database->m_db) > 0;
+}
+
+std::vector<MaterializedFile> Database::ResolveBaseline(const std::string &name)
+{
+  const auto baseline = GetBaseline(name);
+  if (!baseline)
+    throw std::runtime_error("baseline not found: " + name);
+
+  auto statement = m_Database->Prepare(StatementId::SelectBaselineFiles);
+  statement.BindInt64(1, baseline->Id);
+  std::vector<MaterializedFile> files;
+  files.reserve(baseline->FileCount);
+  while (statement.Step() == SQLITE_ROW)
+    files.push_back(Detail::ReadMaterializedFile(statement.get()));
+  return files;
+}
+
+void Database::DiffBaselines(const std::string &from, const std::string &to, const std::function<void(const BaselineDifference &)> &visitor)
+{
+  const auto fromBaseline = GetBaseline(from);
+  if (!fromBaseline)
+    throw std::runtime_error("baseline not found: " + from);
+  const auto toBaseline = GetBaseline(to);
+  if (!toBaseline)
+    throw std::runtime_error("baseline not found: " + to);
+
+  auto statement = m_Database->Prepare(StatementId::DiffBaselines);
+  statement.BindInt64(1, fromBaseline->Id);
+  statement.BindInt64(2, toBaseline->Id);
+  while (statement.Step() == SQLITE_ROW)
+    visitor(BaselineDifference{
+        .FileId = sqlite3_column_int64(statement.get(), 0),
+        .RelativePath = Detail::TextView(statement.get(), 1),
+        .FromVersion = OptInt64(statement.get(), 2),
+        .ToVersion = OptInt64(statement.get(), 3)});
+}
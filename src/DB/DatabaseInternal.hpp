@@ -1,27 +1,108 @@
 #pragma once
 
 #include "Database.hpp"
+#include "DatabaseStatements.hpp"
 #include "SqliteHelpers.hpp"
 #include "../CAS/CAS.hpp"
 #include "../Common/PathUtils.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cctype>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <sqlite3.h>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace Docmasys::DB
 {
   struct Database::Impl
   {
     sqlite3 *m_db = nullptr;
+    Sqlite::StatementCounters m_Counters;
+    /// @brief Open transaction levels; level 1 is BEGIN IMMEDIATE, deeper levels are savepoints.
+    int m_TransactionDepth{};
+
+    /// @brief Folders seen by this connection, keyed on parent id (0 for top level) and ASCII-lowercased name,
+    /// which matches the NOCASE collation of folders.name. Folders are never deleted, so entries only go stale
+    /// when the transaction that created them rolls back; Rollback clears the map.
+    struct FolderKey
+    {
+      ID Parent{};
+      std::string Name;
+      bool operator==(const FolderKey &) const = default;
+    };
+    struct FolderKeyHash
+    {
+      std::size_t operator()(const FolderKey &key) const noexcept
+      {
+        return std::hash<std::string>{}(key.Name) ^ (std::hash<ID>{}(key.Parent) * 0x9E3779B97F4A7C15ull);
+      }
+    };
+    std::unordered_map<FolderKey, std::shared_ptr<Folder>, FolderKeyHash> m_Folders;
+
+    static FolderKey MakeFolderKey(const std::shared_ptr<Folder> &parent, std::string_view name)
+    {
+      FolderKey key{parent ? parent->Id : 0, std::string(name)};
+      std::transform(key.Name.begin(), key.Name.end(), key.Name.begin(), [](unsigned char ch)
+                     { return static_cast<char>(ch < 0x80 ? std::tolower(ch) : ch); });
+      return key;
+    }
+
+    /// @brief Workspace ids keyed on canonical root. Workspaces are never deleted; Rollback clears the map.
+    std::unordered_map<std::string, ID> m_Workspaces;
+
+    /// @brief SQLite has FTS5 and the archive's full-text indexes are in place; see DB_FULL_TEXT_SCHEMA.
+    bool m_FullTextSearch{};
+
+    StorageMode m_Storage{StorageMode::File};
+
+    /// @brief Idle read connections of a writer; see Database::OpenReadSession.
+    std::mutex m_ReaderMutex;
+    std::vector<std::unique_ptr<Database>> m_IdleReaders;
+
     explicit Impl(sqlite3 *db) : m_db(db) {}
     ~Impl()
     {
+      m_IdleReaders.clear();
+      for (auto &slot : m_Statements)
+        if (slot.Statement)
+          sqlite3_finalize(slot.Statement);
       if (m_db)
         sqlite3_close(m_db);
     }
+
+    /// @brief Leases the cached statement for @p id, preparing it on first use.
+    /// A statement already leased further up the stack is prepared afresh instead of being shared.
+    Sqlite::Statement Prepare(StatementId id)
+    {
+      auto &slot = m_Statements[static_cast<std::size_t>(id)];
+      if (slot.InUse)
+        return Sqlite::Statement(m_db, StatementSql(id), &m_Counters);
+      if (!slot.Statement)
+      {
+        if (sqlite3_prepare_v3(m_db, StatementSql(id), -1, SQLITE_PREPARE_PERSISTENT, &slot.Statement, nullptr) != SQLITE_OK)
+          throw std::runtime_error(sqlite3_errmsg(m_db));
+        ++m_Counters.Prepares;
+      }
+      else
+        ++m_Counters.CacheHits;
+      return Sqlite::Statement(m_db, slot.Statement, &slot.InUse, &m_Counters);
+    }
+
+  private:
+    struct CachedStatement
+    {
+      sqlite3_stmt *Statement{};
+      bool InUse{};
+    };
+    std::array<CachedStatement, StatementCount> m_Statements{};
   };
 
   namespace Detail
@@ -44,6 +125,19 @@ namespace Docmasys::DB
                  : std::optional<ID>(sqlite3_column_int64(statement, column));
     }
 
+    /// @brief Reads id,hash,status,compression_level,raw_size,stored_size starting at @p first.
+    inline std::shared_ptr<Blob> ReadBlobRecord(sqlite3_stmt *statement, int first)
+    {
+      auto blob = std::make_shared<Blob>(sqlite3_column_int64(statement, first), ReadBlob(statement, first + 1), static_cast<BlobStatus>(sqlite3_column_int64(statement, first + 2)));
+      if (sqlite3_column_type(statement, first + 3) != SQLITE_NULL)
+        blob->CompressionLevel = sqlite3_column_int(statement, first + 3);
+      if (sqlite3_column_type(statement, first + 4) != SQLITE_NULL)
+        blob->RawSize = static_cast<std::uint64_t>(sqlite3_column_int64(statement, first + 4));
+      if (sqlite3_column_type(statement, first + 5) != SQLITE_NULL)
+        blob->StoredSize = static_cast<std::uint64_t>(sqlite3_column_int64(statement, first + 5));
+      return blob;
+    }
+
     inline bool HasColumn(sqlite3 *db, const char *table, const char *column)
     {
       sqlite3_stmt *statement = nullptr;
@@ -122,17 +216,75 @@ namespace Docmasys::DB
       return VersionProperty{sqlite3_column_int64(statement, 0), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement, 1))), type, value};
     }
 
-    inline MaterializedFile ReadMaterializedFile(sqlite3_stmt *statement)
+    /// @brief SELECT of Database::FindVersionsByProperty over the tables of @p schema, without ORDER BY; an empty schema leaves them unqualified.
+    /// Columns are those of ReadVersionProperty followed by file_id, version_number and relative_path.
+    std::string PropertyQuerySelect(const PropertyQuery &query, std::string_view schema);
+    /// @brief Binds the parameters of PropertyQuerySelect.
+    void BindPropertyQuery(Sqlite::Statement &statement, const PropertyQuery &query);
+
+    /// @brief Text column as a view into the current row; valid until the statement steps or resets.
+    inline std::string_view TextView(sqlite3_stmt *statement, int column)
+    {
+      const auto *text = reinterpret_cast<const char *>(sqlite3_column_text(statement, column));
+      return text ? std::string_view(text, static_cast<std::size_t>(sqlite3_column_bytes(statement, column))) : std::string_view{};
+    }
+
+    /// @brief Row layout of ReadMaterializedFile, read by value.
+    inline MaterializedRow ReadMaterializedRow(sqlite3_stmt *statement)
+    {
+      MaterializedRow row{
+          .FileId = sqlite3_column_int64(statement, 0),
+          .ParentId = OptId(statement, 1),
+          .VersionId = sqlite3_column_int64(statement, 4),
+          .VersionNumber = sqlite3_column_int64(statement, 7),
+          .BlobId = sqlite3_column_int64(statement, 8),
+          .Hash = ReadBlob(statement, 9),
+          .Status = static_cast<BlobStatus>(sqlite3_column_int64(statement, 10)),
+          .CompressionLevel = std::nullopt,
+          .RawSize = std::nullopt,
+          .StoredSize = std::nullopt,
+          .RelativePath = TextView(statement, 14)};
+      if (sqlite3_column_type(statement, 11) != SQLITE_NULL)
+        row.CompressionLevel = sqlite3_column_int(statement, 11);
+      if (sqlite3_column_type(statement, 12) != SQLITE_NULL)
+        row.RawSize = static_cast<std::uint64_t>(sqlite3_column_int64(statement, 12));
+      if (sqlite3_column_type(statement, 13) != SQLITE_NULL)
+        row.StoredSize = static_cast<std::uint64_t>(sqlite3_column_int64(statement, 13));
+      return row;
+    }
+
+    /// @brief Row layout of ReadWorkspaceEntry, read by value.
+    inline WorkspaceRow ReadWorkspaceRow(sqlite3_stmt *statement)
+    {
+      return WorkspaceRow{
+          .FileId = sqlite3_column_int64(statement, 0),
+          .VersionId = sqlite3_column_int64(statement, 4),
+          .VersionNumber = sqlite3_column_int64(statement, 7),
+          .BlobId = sqlite3_column_int64(statement, 6),
+          .Kind = static_cast<MaterializationKind>(sqlite3_column_int(statement, 9)),
+          .RelativePath = TextView(statement, 8),
+          .LogicalPath = TextView(statement, 10)};
+    }
+
+    /// @brief Reads id,parent_id,name,current_version_id from columns 0-3 and relative_path from @p pathColumn.
+    inline std::shared_ptr<File> ReadFileRecord(sqlite3_stmt *statement, int pathColumn)
     {
       auto file = std::make_shared<File>(sqlite3_column_int64(statement, 0), OptId(statement, 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement, 2))), OptId(statement, 3));
+      if (const auto *path = reinterpret_cast<const char *>(sqlite3_column_text(statement, pathColumn)))
+        file->RelativePath = path;
+      return file;
+    }
+
+    inline MaterializedFile ReadMaterializedFile(sqlite3_stmt *statement)
+    {
+      auto file = ReadFileRecord(statement, 14);
       auto version = std::make_shared<FileVersion>(sqlite3_column_int64(statement, 4), sqlite3_column_int64(statement, 5), sqlite3_column_int64(statement, 6), sqlite3_column_int64(statement, 7));
-      auto blob = std::make_shared<Blob>(sqlite3_column_int64(statement, 8), ReadBlob(statement, 9), static_cast<BlobStatus>(sqlite3_column_int64(statement, 10)));
-      return MaterializedFile{file, version, blob, {}};
+      return MaterializedFile{file, version, ReadBlobRecord(statement, 8), file->RelativePath};
     }
 
     inline WorkspaceEntry ReadWorkspaceEntry(sqlite3_stmt *statement)
     {
-      auto file = std::make_shared<File>(sqlite3_column_int64(statement, 0), OptId(statement, 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement, 2))), OptId(statement, 3));
+      auto file = ReadFileRecord(statement, 10);
       auto version = std::make_shared<FileVersion>(sqlite3_column_int64(statement, 4), sqlite3_column_int64(statement, 5), sqlite3_column_int64(statement, 6), sqlite3_column_int64(statement, 7));
       return WorkspaceEntry{
           std::filesystem::path(reinterpret_cast<const char *>(sqlite3_column_text(statement, 8))),
@@ -143,7 +295,7 @@ namespace Docmasys::DB
 
     inline CheckoutLock ReadCheckoutLock(sqlite3_stmt *statement)
     {
-      auto file = std::make_shared<File>(sqlite3_column_int64(statement, 0), OptId(statement, 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement, 2))), OptId(statement, 3));
+      auto file = ReadFileRecord(statement, 7);
       return CheckoutLock{
           file,
           std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement, 4))),
@@ -151,10 +303,11 @@ namespace Docmasys::DB
           std::filesystem::path(reinterpret_cast<const char *>(sqlite3_column_text(statement, 6)))};
     }
 
-    inline WorkspaceEntryState DetectWorkspaceState(const std::filesystem::path &workspaceRoot,
-                                                    const std::filesystem::path &archiveRoot,
-                                                    const WorkspaceEntry &entry,
-                                                    const Identity &expectedHash)
+    /// @brief State decided from metadata alone; std::nullopt when the content hash must be compared.
+    inline std::optional<WorkspaceEntryState> PrecheckWorkspaceState(const std::filesystem::path &workspaceRoot,
+                                                                     const std::filesystem::path &archiveRoot,
+                                                                     const WorkspaceEntry &entry,
+                                                                     const Identity &expectedHash)
     {
       const auto fullPath = workspaceRoot / entry.RelativePath;
       std::error_code ec;
@@ -187,10 +340,7 @@ namespace Docmasys::DB
           return WorkspaceEntryState::Modified;
       }
 
-      const auto actualHash = CAS::Identify(fullPath);
-      if (actualHash != expectedHash)
-        return WorkspaceEntryState::Modified;
-      return WorkspaceEntryState::Ok;
+      return std::nullopt;
     }
   }
 }
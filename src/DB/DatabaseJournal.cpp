@@ -0,0 +1,35 @@
+#include "DatabaseInternal.hpp"
+
+using namespace Docmasys;
+using namespace Docmasys::DB;
+
+std::int64_t Database::GetLastChangeSequence()
+{
+  auto statement = m_Database->Prepare(StatementId::SelectLastChangeSequence);
+  if (statement.Step() != SQLITE_ROW)
+    throw std::runtime_error("change sequence select failed");
+  return sqlite3_column_int64(statement.get(), 0);
+}
+
+void Database::ForEachChangeSince(std::int64_t sequence, std::optional<std::size_t> limit, const std::function<void(const ChangeRecord &)> &visitor)
+{
+  auto statement = m_Database->Prepare(StatementId::SelectChangesSince);
+  statement.BindInt64(1, sequence);
+  statement.BindInt64(2, limit ? static_cast<sqlite3_int64>(*limit) : -1);
+  while (statement.Step() == SQLITE_ROW)
+  {
+    auto *row = statement.get();
+    visitor(ChangeRecord{
+        .Sequence = sqlite3_column_int64(row, 0),
+        .Kind = static_cast<ChangeKind>(sqlite3_column_int(row, 1)),
+        .FileId = sqlite3_column_int64(row, 2),
+        .VersionId = Detail::OptId(row, 3),
+        .VersionNumber = Detail::OptId(row, 4),
+        .RelativePath = Detail::TextView(row, 5),
+        .TargetVersionId = Detail::OptId(row, 6),
+        .TargetVersionNumber = Detail::OptId(row, 7),
+        .TargetRelativePath = Detail::TextView(row, 8),
+        .Detail = Detail::TextView(row, 9),
+        .RecordedAt = sqlite3_column_int64(row, 10)});
+  }
+}
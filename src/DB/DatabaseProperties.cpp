@@ -6,16 +6,7 @@ using namespace Docmasys::DB;
 void Database::SetVersionProperty(const std::shared_ptr<FileVersion> &version, const std::string &name, const PropertyValue &value)
 {
   const auto normalizedName = Detail::NormalizePropertyName(name);
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    INSERT INTO version_properties(version_id,name,normalized_name,value_type,string_value,int_value,bool_value)
-    VALUES(?1,?2,?3,?4,?5,?6,?7)
-    ON CONFLICT(version_id, normalized_name) DO UPDATE SET
-      name=excluded.name,
-      value_type=excluded.value_type,
-      string_value=excluded.string_value,
-      int_value=excluded.int_value,
-      bool_value=excluded.bool_value;
-  )SQL");
+  auto statement = m_Database->Prepare(StatementId::UpsertProperty);
   statement.BindInt64(1, version->Id);
   statement.BindText(2, name);
   statement.BindText(3, normalizedName);
@@ -45,7 +36,7 @@ void Database::SetVersionProperty(const std::shared_ptr<FileVersion> &version, c
 
 std::optional<VersionProperty> Database::GetVersionProperty(const std::shared_ptr<FileVersion> &version, const std::string &name)
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT version_id,name,value_type,string_value,int_value,bool_value FROM version_properties WHERE version_id=?1 AND normalized_name=?2;");
+  auto statement = m_Database->Prepare(StatementId::SelectProperty);
   statement.BindInt64(1, version->Id);
   statement.BindText(2, Detail::NormalizePropertyName(name));
   if (statement.Step() != SQLITE_ROW)
@@ -55,7 +46,7 @@ std::optional<VersionProperty> Database::GetVersionProperty(const std::shared_pt
 
 std::vector<VersionProperty> Database::ListVersionProperties(const std::shared_ptr<FileVersion> &version)
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT version_id,name,value_type,string_value,int_value,bool_value FROM version_properties WHERE version_id=?1 ORDER BY normalized_name;");
+  auto statement = m_Database->Prepare(StatementId::SelectProperties);
   statement.BindInt64(1, version->Id);
 
   std::vector<VersionProperty> properties;
@@ -66,9 +57,205 @@ std::vector<VersionProperty> Database::ListVersionProperties(const std::shared_p
 
 bool Database::RemoveVersionProperty(const std::shared_ptr<FileVersion> &version, const std::string &name)
 {
-  Sqlite::Statement statement(m_Database->m_db, "DELETE FROM version_properties WHERE version_id=?1 AND normalized_name=?2;");
+  auto statement = m_Database->Prepare(StatementId::DeleteProperty);
   statement.BindInt64(1, version->Id);
   statement.BindText(2, Detail::NormalizePropertyName(name));
   statement.ExpectDone();
   return sqlite3_changes(m_Database->m_db) > 0;
 }
+
+namespace
+{
+  const char *ComparisonOperator(PropertyComparison comparison)
+  {
+    switch (comparison)
+    {
+    case PropertyComparison::Equal: return "=";
+    case PropertyComparison::NotEqual: return "<>";
+    case PropertyComparison::Less: return "<";
+    case PropertyComparison::LessOrEqual: return "<=";
+    case PropertyComparison::Greater: return ">";
+    case PropertyComparison::GreaterOrEqual: return ">=";
+    }
+    throw std::runtime_error("unknown property comparison");
+  }
+
+  /// @brief LIKE pattern matching every path below @p folder, escaping wildcards with '\'.
+  std::string FolderLikePattern(const std::filesystem::path &folder)
+  {
+    auto text = folder.generic_string();
+    while (!text.empty() && text.back() == '/')
+      text.pop_back();
+
+    std::string pattern;
+    pattern.reserve(text.size() + 2);
+    for (const char c : text)
+    {
+      if (c == '%' || c == '_' || c == '\\')
+        pattern.push_back('\\');
+      pattern.push_back(c);
+    }
+    pattern += "/%";
+    return pattern;
+  }
+}
+
+std::string Detail::PropertyQuerySelect(const PropertyQuery &query, std::string_view schema)
+{
+  const auto type = PropertyTypeOf(query.Value);
+  if (type == PropertyValueType::Bool && query.Comparison != PropertyComparison::Equal && query.Comparison != PropertyComparison::NotEqual)
+    throw std::runtime_error("bool properties support only equality comparisons");
+
+  std::string prefix(schema);
+  if (!prefix.empty())
+    prefix.push_back('.');
+
+  // The value column follows the query type, so the (normalized_name, value) indexes turn the comparison into a range seek.
+  const char *valueColumn = type == PropertyValueType::String ? "vp.string_value" : type == PropertyValueType::Int ? "vp.int_value" : "vp.bool_value";
+  std::string sql =
+      "SELECT vp.version_id, vp.name, vp.value_type, vp.string_value, vp.int_value, vp.bool_value, fv.file_id, fv.version_number, f.relative_path "
+      "FROM " + prefix + "version_properties vp JOIN " + prefix + "file_versions fv ON fv.id = vp.version_id JOIN " + prefix + "files f ON f.id = fv.file_id "
+      "WHERE vp.normalized_name = ?1 AND ";
+  sql += valueColumn;
+  sql += ' ';
+  sql += ComparisonOperator(query.Comparison);
+  sql += " ?2";
+  if (query.CurrentOnly)
+    sql += " AND f.current_version_id = fv.id";
+  if (query.PathPrefix)
+    sql += " AND f.relative_path LIKE ?3 ESCAPE '\\'";
+  return sql;
+}
+
+void Detail::BindPropertyQuery(Sqlite::Statement &statement, const PropertyQuery &query)
+{
+  statement.BindText(1, NormalizePropertyName(query.Name));
+  switch (PropertyTypeOf(query.Value))
+  {
+  case PropertyValueType::String:
+    statement.BindText(2, std::get<std::string>(query.Value));
+    break;
+  case PropertyValueType::Int:
+    statement.BindInt64(2, std::get<std::int64_t>(query.Value));
+    break;
+  case PropertyValueType::Bool:
+    statement.BindInt(2, std::get<bool>(query.Value) ? 1 : 0);
+    break;
+  }
+  if (query.PathPrefix)
+    statement.BindText(3, FolderLikePattern(*query.PathPrefix));
+}
+
+void Database::FindVersionsByProperty(const PropertyQuery &query, const std::function<void(const PropertyMatch &)> &visitor)
+{
+  const auto sql = Detail::PropertyQuerySelect(query, {}) + " ORDER BY f.relative_path, fv.version_number;";
+  Sqlite::Statement statement(m_Database->m_db, sql.c_str(), &m_Database->m_Counters);
+  Detail::BindPropertyQuery(statement, query);
+
+  while (statement.Step() == SQLITE_ROW)
+  {
+    visitor(PropertyMatch{
+        .FileId = sqlite3_column_int64(statement.get(), 6),
+        .VersionNumber = sqlite3_column_int64(statement.get(), 7),
+        .RelativePath = Detail::TextView(statement.get(), 8),
+        .Property = Detail::ReadVersionProperty(statement.get())});
+  }
+}
+
+namespace
+{
+  struct SearchTerm
+  {
+    std::string Text;
+    bool Prefix{};
+  };
+
+  std::vector<SearchTerm> SplitSearchTerms(const std::string &terms)
+  {
+    std::vector<SearchTerm> result;
+    std::size_t position = 0;
+    while (position < terms.size())
+    {
+      const auto start = terms.find_first_not_of(" \t\r\n", position);
+      if (start == std::string::npos)
+        break;
+      const auto end = std::min(terms.find_first_of(" \t\r\n", start), terms.size());
+      SearchTerm term{terms.substr(start, end - start)};
+      while (!term.Text.empty() && term.Text.back() == '*')
+      {
+        term.Text.pop_back();
+        term.Prefix = true;
+      }
+      if (!term.Text.empty())
+        result.push_back(std::move(term));
+      position = end;
+    }
+    if (result.empty())
+      throw std::runtime_error("search terms are required");
+    return result;
+  }
+
+  /// @brief FTS5 query requiring every term, each quoted so punctuation is tokenized rather than parsed as syntax.
+  std::string FullTextQuery(const std::vector<SearchTerm> &terms)
+  {
+    std::string query;
+    for (const auto &term : terms)
+    {
+      if (!query.empty())
+        query.push_back(' ');
+      query.push_back('"');
+      for (const char c : term.Text)
+      {
+        if (c == '"')
+          query.push_back('"');
+        query.push_back(c);
+      }
+      query.push_back('"');
+      if (term.Prefix)
+        query.push_back('*');
+    }
+    return query;
+  }
+
+  /// @brief LIKE pattern matching the terms in order anywhere in the text.
+  std::string SubstringPattern(const std::vector<SearchTerm> &terms)
+  {
+    std::string pattern = "%";
+    for (const auto &term : terms)
+    {
+      for (const char c : term.Text)
+      {
+        if (c == '%' || c == '_' || c == '\\')
+          pattern.push_back('\\');
+        pattern.push_back(c);
+      }
+      pattern.push_back('%');
+    }
+    return pattern;
+  }
+}
+
+void Database::SearchText(const std::string &terms, const TextSearchOptions &options, const std::function<void(const TextSearchHit &)> &visitor)
+{
+  const auto parsed = SplitSearchTerms(terms);
+  auto statement = m_Database->Prepare(m_Database->m_FullTextSearch ? StatementId::SearchText : StatementId::ScanText);
+  statement.BindText(1, m_Database->m_FullTextSearch ? FullTextQuery(parsed) : SubstringPattern(parsed));
+  statement.BindInt(2, options.CurrentOnly ? 1 : 0);
+  statement.BindInt64(3, static_cast<sqlite3_int64>(std::min<std::size_t>(options.Limit, INT64_MAX)));
+
+  while (statement.Step() == SQLITE_ROW)
+  {
+    visitor(TextSearchHit{
+        .FileId = sqlite3_column_int64(statement.get(), 0),
+        .VersionNumber = sqlite3_column_int64(statement.get(), 1),
+        .RelativePath = Detail::TextView(statement.get(), 2),
+        .PropertyName = Detail::TextView(statement.get(), 3),
+        .Text = Detail::TextView(statement.get(), 4),
+        .Rank = sqlite3_column_double(statement.get(), 5)});
+  }
+}
+
+bool Database::HasFullTextIndex() const noexcept
+{
+  return m_Database->m_FullTextSearch;
+}
@@ -6,7 +6,7 @@ using namespace Docmasys::DB;
 
 std::shared_ptr<Blob> Database::GetBlobByHashOrId(const std::optional<ID> &id, const std::optional<Identity> &hash)
 {
-  Sqlite::Statement statement(m_Database->m_db, id ? "SELECT id,hash,status FROM blobs WHERE id=?1;" : "SELECT id,hash,status FROM blobs WHERE hash=?1;");
+  auto statement = m_Database->Prepare(id ? StatementId::SelectBlobById : StatementId::SelectBlobByHash);
   if (id)
     statement.BindInt64(1, *id);
   else
@@ -15,14 +15,18 @@ std::shared_ptr<Blob> Database::GetBlobByHashOrId(const std::optional<ID> &id, c
   if (statement.Step() != SQLITE_ROW)
     throw std::runtime_error("blob select failed");
 
-  return std::make_shared<Blob>(sqlite3_column_int64(statement.get(), 0), Detail::ReadBlob(statement.get(), 1), static_cast<BlobStatus>(sqlite3_column_int64(statement.get(), 2)));
+  return Detail::ReadBlobRecord(statement.get(), 0);
 }
 
 std::shared_ptr<Blob> Database::GetBlob(ID blobId) { return GetBlobByHashOrId(blobId, std::nullopt); }
 
 std::shared_ptr<Folder> Database::GetOrCreateFolder(const std::string &name, const std::shared_ptr<Folder> &parent)
 {
-  Sqlite::Statement insert(m_Database->m_db, "INSERT INTO folders(parent_id,name) VALUES(?1,?2) ON CONFLICT DO NOTHING;");
+  auto key = Impl::MakeFolderKey(parent, name);
+  if (const auto cached = m_Database->m_Folders.find(key); cached != m_Database->m_Folders.end())
+    return cached->second;
+
+  auto insert = m_Database->Prepare(StatementId::InsertFolder);
   if (parent)
     insert.BindInt64(1, parent->Id);
   else
@@ -30,7 +34,7 @@ std::shared_ptr<Folder> Database::GetOrCreateFolder(const std::string &name, con
   insert.BindText(2, name);
   insert.ExpectDone();
 
-  Sqlite::Statement select(m_Database->m_db, "SELECT id,parent_id,name FROM folders WHERE parent_id IS ?1 AND name=?2;");
+  auto select = m_Database->Prepare(StatementId::SelectFolderByName);
   if (parent)
     select.BindInt64(1, parent->Id);
   else
@@ -39,60 +43,54 @@ std::shared_ptr<Folder> Database::GetOrCreateFolder(const std::string &name, con
   if (select.Step() != SQLITE_ROW)
     throw std::runtime_error("folder select failed");
 
-  return std::make_shared<Folder>(sqlite3_column_int64(select.get(), 0), Detail::OptId(select.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(select.get(), 2))));
+  auto folder = std::make_shared<Folder>(sqlite3_column_int64(select.get(), 0), Detail::OptId(select.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(select.get(), 2))));
+  m_Database->m_Folders.emplace(std::move(key), folder);
+  return folder;
 }
 
 std::shared_ptr<Blob> Database::GetOrCreateBlob(const Identity &hash)
 {
-  Sqlite::Statement statement(m_Database->m_db, "INSERT INTO blobs(hash,status) VALUES(?1,?2) ON CONFLICT(hash) DO NOTHING;");
+  auto statement = m_Database->Prepare(StatementId::InsertBlob);
   statement.BindBlob(1, hash.data(), 32);
   statement.BindInt(2, static_cast<int>(BlobStatus::Pending));
   statement.ExpectDone();
   return GetBlobByHashOrId(std::nullopt, hash);
 }
 
-std::shared_ptr<File> Database::GetOrCreateFile(const std::string &name, const std::shared_ptr<Folder> &folder)
+std::shared_ptr<File> Database::GetOrCreateFile(const std::string &name, const std::shared_ptr<Folder> &folder, const std::string &relativePath)
 {
-  Sqlite::Statement insert(m_Database->m_db, "INSERT INTO files(parent_id,name,current_version_id) VALUES(?1,?2,NULL) ON CONFLICT(parent_id,name) DO NOTHING;");
+  auto insert = m_Database->Prepare(StatementId::InsertFile);
   insert.BindInt64(1, folder->Id);
   insert.BindText(2, name);
+  insert.BindText(3, relativePath);
   insert.ExpectDone();
 
-  Sqlite::Statement select(m_Database->m_db, "SELECT id,parent_id,name,current_version_id FROM files WHERE parent_id IS ?1 AND name=?2;");
+  auto select = m_Database->Prepare(StatementId::SelectFileByName);
   select.BindInt64(1, folder->Id);
   select.BindText(2, name);
   if (select.Step() != SQLITE_ROW)
     throw std::runtime_error("file select failed");
 
-  return std::make_shared<File>(sqlite3_column_int64(select.get(), 0), Detail::OptId(select.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(select.get(), 2))), Detail::OptId(select.get(), 3));
+  return Detail::ReadFileRecord(select.get(), 4);
 }
 
 std::shared_ptr<File> Database::GetFileById(ID id)
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT id,parent_id,name,current_version_id FROM files WHERE id=?1;");
+  auto statement = m_Database->Prepare(StatementId::SelectFileById);
   statement.BindInt64(1, id);
   if (statement.Step() != SQLITE_ROW)
     throw std::runtime_error("file not found");
-  return std::make_shared<File>(sqlite3_column_int64(statement.get(), 0), Detail::OptId(statement.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement.get(), 2))), Detail::OptId(statement.get(), 3));
-}
-
-std::shared_ptr<Folder> Database::GetFolderById(ID id)
-{
-  Sqlite::Statement statement(m_Database->m_db, "SELECT id,parent_id,name FROM folders WHERE id=?1;");
-  statement.BindInt64(1, id);
-  if (statement.Step() != SQLITE_ROW)
-    throw std::runtime_error("folder not found");
-  return std::make_shared<Folder>(sqlite3_column_int64(statement.get(), 0), Detail::OptId(statement.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement.get(), 2))));
+  return Detail::ReadFileRecord(statement.get(), 4);
 }
 
 std::shared_ptr<FileVersion> Database::CreateFileVersion(const std::shared_ptr<File> &file, const std::shared_ptr<Blob> &blob)
 {
-  Sqlite::Statement insert(m_Database->m_db, "INSERT INTO file_versions(file_id,version_number,blob_id) VALUES(?1, COALESCE((SELECT MAX(version_number)+1 FROM file_versions WHERE file_id=?1),1), ?2);");
+  auto insert = m_Database->Prepare(StatementId::InsertFileVersion);
   insert.BindInt64(1, file->Id);
   insert.BindInt64(2, blob->Id);
   insert.ExpectDone();
 
-  Sqlite::Statement select(m_Database->m_db, "SELECT id,file_id,blob_id,version_number FROM file_versions WHERE file_id=?1 ORDER BY version_number DESC LIMIT 1;");
+  auto select = m_Database->Prepare(StatementId::SelectLatestFileVersion);
   select.BindInt64(1, file->Id);
   if (select.Step() != SQLITE_ROW)
     throw std::runtime_error("version select failed");
@@ -102,7 +100,7 @@ std::shared_ptr<FileVersion> Database::CreateFileVersion(const std::shared_ptr<F
 
 std::shared_ptr<File> Database::SetCurrentVersion(const std::shared_ptr<File> &file, const std::shared_ptr<FileVersion> &version)
 {
-  Sqlite::Statement statement(m_Database->m_db, "UPDATE files SET current_version_id=?2 WHERE id=?1;");
+  auto statement = m_Database->Prepare(StatementId::UpdateCurrentVersion);
   statement.BindInt64(1, file->Id);
   statement.BindInt64(2, version->Id);
   statement.ExpectDone();
@@ -114,10 +112,81 @@ ImportResult Database::Import(const fs::path &file, const Identity &hash)
   fs::path relative;
   if (!TryGetRelativePath(file, relative))
     throw std::runtime_error("File is outside vault");
-  return InsertToDB(relative, hash);
+  return InsertToDB(relative, hash, nullptr);
+}
+
+ImportResult Database::Import(const fs::path &file, const KnownBlob &blob)
+{
+  fs::path relative;
+  if (!TryGetRelativePath(file, relative))
+    throw std::runtime_error("File is outside vault");
+  return InsertToDB(relative, blob.Hash, &blob);
+}
+
+BlobIndex Database::LoadBlobIndex()
+{
+  auto statement = m_Database->Prepare(StatementId::SelectBlobIndex);
+  std::vector<KnownBlob> blobs;
+  while (statement.Step() == SQLITE_ROW)
+    blobs.push_back(KnownBlob{
+        .Hash = Detail::ReadBlob(statement.get(), 0),
+        .Id = sqlite3_column_int64(statement.get(), 1),
+        .Status = static_cast<BlobStatus>(sqlite3_column_int(statement.get(), 2))});
+  return BlobIndex(std::move(blobs));
+}
+
+std::vector<KnownBlob> Database::InsertBlobs(const std::vector<Identity> &hashes)
+{
+  // Rows per INSERT, well below SQLite's default limit of 32766 bound parameters.
+  constexpr std::size_t ROWS_PER_INSERT = 500;
+
+  auto pending = hashes;
+  std::sort(pending.begin(), pending.end());
+  pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+  std::vector<KnownBlob> blobs;
+  blobs.reserve(pending.size());
+  Transaction transaction(*this);
+  for (std::size_t first = 0; first < pending.size(); first += ROWS_PER_INSERT)
+  {
+    const auto count = std::min(ROWS_PER_INSERT, pending.size() - first);
+    std::string sql = "INSERT INTO blobs(hash,status) VALUES";
+    for (std::size_t i = 0; i < count; ++i)
+      sql += (i ? ",(?" : "(?") + std::to_string(i + 1) + ',' + std::to_string(static_cast<int>(BlobStatus::Pending)) + ')';
+    sql += " ON CONFLICT(hash) DO NOTHING RETURNING id,hash,status;";
+
+    Sqlite::Statement statement(m_Database->m_db, sql.c_str(), &m_Database->m_Counters);
+    for (std::size_t i = 0; i < count; ++i)
+      statement.BindBlob(static_cast<int>(i + 1), pending[first + i].data(), 32);
+
+    // RETURNING skips rows that already existed; those are looked up by hash.
+    std::vector<Identity> inserted;
+    int result;
+    while ((result = statement.Step()) == SQLITE_ROW)
+    {
+      blobs.push_back(KnownBlob{
+          .Hash = Detail::ReadBlob(statement.get(), 1),
+          .Id = sqlite3_column_int64(statement.get(), 0),
+          .Status = static_cast<BlobStatus>(sqlite3_column_int(statement.get(), 2))});
+      inserted.push_back(blobs.back().Hash);
+    }
+    if (result != SQLITE_DONE)
+      throw std::runtime_error(sqlite3_errmsg(m_Database->m_db));
+    if (inserted.size() == count)
+      continue;
+    std::sort(inserted.begin(), inserted.end());
+    for (std::size_t i = first; i < first + count; ++i)
+      if (!std::binary_search(inserted.begin(), inserted.end(), pending[i]))
+      {
+        const auto existing = GetBlobByHashOrId(std::nullopt, pending[i]);
+        blobs.push_back(KnownBlob{.Hash = existing->Hash, .Id = existing->Id, .Status = existing->Status});
+      }
+  }
+  transaction.Commit();
+  return blobs;
 }
 
-ImportResult Database::InsertToDB(const fs::path &relativeFilePath, const Identity &hash)
+ImportResult Database::InsertToDB(const fs::path &relativeFilePath, const Identity &hash, const KnownBlob *knownBlob)
 {
   std::vector<std::string> parts;
   for (const auto &part : relativeFilePath.parent_path().lexically_normal())
@@ -127,12 +196,17 @@ ImportResult Database::InsertToDB(const fs::path &relativeFilePath, const Identi
   OpenTransaction();
   try
   {
-    const auto blob = GetOrCreateBlob(hash);
+    const auto blob = knownBlob ? std::make_shared<Blob>(knownBlob->Id, hash, knownBlob->Status) : GetOrCreateBlob(hash);
     std::shared_ptr<Folder> leaf;
+    std::string path;
     for (const auto &name : parts)
+    {
       leaf = GetOrCreateFolder(name, leaf);
+      path += leaf->Name + '/';
+    }
 
-    const auto file = GetOrCreateFile(relativeFilePath.filename().generic_string(), leaf);
+    const auto name = relativeFilePath.filename().generic_string();
+    const auto file = GetOrCreateFile(name, leaf, path + name);
     if (file->CurrentVersionId)
     {
       const auto current = GetFileVersion(file, std::nullopt);
@@ -160,7 +234,7 @@ std::shared_ptr<Blob> Database::UpdateBlobStatus(const std::shared_ptr<Blob> &bl
   OpenTransaction();
   try
   {
-    Sqlite::Statement statement(m_Database->m_db, "UPDATE blobs SET status=?2 WHERE id=?1;");
+    auto statement = m_Database->Prepare(StatementId::UpdateBlobStatus);
     statement.BindInt64(1, blob->Id);
     statement.BindInt64(2, static_cast<int>(status));
     statement.ExpectDone();
@@ -175,9 +249,58 @@ std::shared_ptr<Blob> Database::UpdateBlobStatus(const std::shared_ptr<Blob> &bl
   }
 }
 
+std::shared_ptr<Blob> Database::MarkBlobStored(const std::shared_ptr<Blob> &blob, const BlobStorageInfo &info)
+{
+  OpenTransaction();
+  try
+  {
+    auto statement = m_Database->Prepare(StatementId::MarkBlobStored);
+    statement.BindInt64(1, blob->Id);
+    statement.BindInt(2, static_cast<int>(BlobStatus::Ready));
+    statement.BindInt(3, info.CompressionLevel);
+    statement.BindInt64(4, static_cast<sqlite3_int64>(info.RawSize));
+    statement.BindInt64(5, static_cast<sqlite3_int64>(info.StoredSize));
+    statement.ExpectDone();
+    const auto updated = GetBlob(blob->Id);
+    Commit();
+    return updated;
+  }
+  catch (...)
+  {
+    Rollback();
+    throw;
+  }
+}
+
+std::vector<std::shared_ptr<Blob>> Database::ListBlobsMissingSizes()
+{
+  auto statement = m_Database->Prepare(StatementId::SelectBlobsMissingSizes);
+
+  std::vector<std::shared_ptr<Blob>> blobs;
+  while (statement.Step() == SQLITE_ROW)
+    blobs.push_back(Detail::ReadBlobRecord(statement.get(), 0));
+  return blobs;
+}
+
+void Database::SetBlobSizes(const std::shared_ptr<Blob> &blob, std::uint64_t rawSize, std::uint64_t storedSize)
+{
+  auto statement = m_Database->Prepare(StatementId::UpdateBlobSizes);
+  statement.BindInt64(1, blob->Id);
+  statement.BindInt64(2, static_cast<sqlite3_int64>(rawSize));
+  statement.BindInt64(3, static_cast<sqlite3_int64>(storedSize));
+  statement.ExpectDone();
+}
+
+std::uint64_t Database::GetCurrentContentSize()
+{
+  auto statement = m_Database->Prepare(StatementId::SelectCurrentContentSize);
+  statement.ExpectRow();
+  return static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 0));
+}
+
 std::vector<std::shared_ptr<Folder>> Database::GetFolders(const std::shared_ptr<Folder> &folder)
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT id,parent_id,name FROM folders WHERE parent_id IS ?1 ORDER BY name;");
+  auto statement = m_Database->Prepare(StatementId::SelectChildFolders);
   if (folder)
     statement.BindInt64(1, folder->Id);
   else
@@ -191,58 +314,39 @@ std::vector<std::shared_ptr<Folder>> Database::GetFolders(const std::shared_ptr<
 
 std::vector<MaterializedFile> Database::GetMaterializedFiles(const std::shared_ptr<Folder> &folder)
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT f.id,f.parent_id,f.name,f.current_version_id,fv.id,fv.file_id,fv.blob_id,fv.version_number,b.id,b.hash,b.status FROM files f JOIN file_versions fv ON fv.id=f.current_version_id JOIN blobs b ON b.id=fv.blob_id WHERE f.parent_id=?1 ORDER BY f.name;");
+  auto statement = m_Database->Prepare(StatementId::SelectMaterializedFilesInFolder);
   statement.BindInt64(1, folder->Id);
 
   std::vector<MaterializedFile> files;
   while (statement.Step() == SQLITE_ROW)
   {
-    auto item = Detail::ReadMaterializedFile(statement.get());
-    item.RelativePath = BuildRelativePath(item.LogicalFile);
-    files.push_back(item);
+    files.push_back(Detail::ReadMaterializedFile(statement.get()));
   }
   return files;
 }
 
 std::shared_ptr<File> Database::GetFileByRelativePath(const fs::path &path)
 {
-  std::shared_ptr<Folder> folder;
-  for (const auto &part : path.lexically_normal().parent_path())
+  std::string key;
+  for (const auto &part : path.lexically_normal())
   {
     if (part == "." || part == "/" || part.empty())
       continue;
-
-    Sqlite::Statement statement(m_Database->m_db, "SELECT id,parent_id,name FROM folders WHERE parent_id IS ?1 AND name=?2;");
-    if (folder)
-      statement.BindInt64(1, folder->Id);
-    else
-      statement.BindNull(1);
-    statement.BindText(2, part.generic_string());
-    if (statement.Step() != SQLITE_ROW)
-      throw std::runtime_error("folder path not found");
-
-    folder = std::make_shared<Folder>(sqlite3_column_int64(statement.get(), 0), Detail::OptId(statement.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement.get(), 2))));
+    if (!key.empty())
+      key += '/';
+    key += part.generic_string();
   }
 
-  Sqlite::Statement statement(m_Database->m_db, "SELECT id,parent_id,name,current_version_id FROM files WHERE parent_id IS ?1 AND name=?2;");
-  if (folder)
-    statement.BindInt64(1, folder->Id);
-  else
-    statement.BindNull(1);
-  statement.BindText(2, path.lexically_normal().filename().generic_string());
+  auto statement = m_Database->Prepare(StatementId::SelectFileByPath);
+  statement.BindText(1, key);
   if (statement.Step() != SQLITE_ROW)
     throw std::runtime_error("file path not found");
-
-  return std::make_shared<File>(sqlite3_column_int64(statement.get(), 0), Detail::OptId(statement.get(), 1), std::string(reinterpret_cast<const char *>(sqlite3_column_text(statement.get(), 2))), Detail::OptId(statement.get(), 3));
+  return Detail::ReadFileRecord(statement.get(), 4);
 }
 
 std::shared_ptr<FileVersion> Database::GetFileVersion(const std::shared_ptr<File> &file, const std::optional<std::int64_t> &versionNumber)
 {
-  Sqlite::Statement statement(
-      m_Database->m_db,
-      versionNumber
-          ? "SELECT id,file_id,blob_id,version_number FROM file_versions WHERE file_id=?1 AND version_number=?2;"
-          : "SELECT fv.id,fv.file_id,fv.blob_id,fv.version_number FROM file_versions fv JOIN files f ON f.current_version_id=fv.id WHERE f.id=?1;");
+  auto statement = m_Database->Prepare(versionNumber ? StatementId::SelectFileVersionByNumber : StatementId::SelectCurrentFileVersion);
   statement.BindInt64(1, file->Id);
   if (versionNumber)
     statement.BindInt64(2, *versionNumber);
@@ -254,7 +358,7 @@ std::shared_ptr<FileVersion> Database::GetFileVersion(const std::shared_ptr<File
 
 std::vector<std::shared_ptr<FileVersion>> Database::GetFileVersions(const std::shared_ptr<File> &file)
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT id,file_id,blob_id,version_number FROM file_versions WHERE file_id=?1 ORDER BY version_number;");
+  auto statement = m_Database->Prepare(StatementId::SelectFileVersions);
   statement.BindInt64(1, file->Id);
 
   std::vector<std::shared_ptr<FileVersion>> versions;
@@ -265,31 +369,49 @@ std::vector<std::shared_ptr<FileVersion>> Database::GetFileVersions(const std::s
 
 fs::path Database::BuildRelativePath(const std::shared_ptr<File> &file)
 {
-  std::vector<std::string> parts{file->Name};
-  auto parentId = file->ParentId;
-  while (parentId)
-  {
-    const auto folder = GetFolderById(*parentId);
-    parts.push_back(folder->Name);
-    parentId = folder->ParentId;
-  }
-
-  fs::path relative;
-  for (auto it = parts.rbegin(); it != parts.rend(); ++it)
-    relative /= *it;
-  return relative;
+  if (!file->RelativePath.empty())
+    return file->RelativePath;
+  return GetFileById(file->Id)->RelativePath;
 }
 
 std::vector<MaterializedFile> Database::InspectCurrentFiles()
 {
-  Sqlite::Statement statement(m_Database->m_db, "SELECT f.id,f.parent_id,f.name,f.current_version_id,fv.id,fv.file_id,fv.blob_id,fv.version_number,b.id,b.hash,b.status FROM files f JOIN file_versions fv ON fv.id=f.current_version_id JOIN blobs b ON b.id=fv.blob_id ORDER BY f.id;");
+  auto statement = m_Database->Prepare(StatementId::SelectCurrentFiles);
 
   std::vector<MaterializedFile> files;
   while (statement.Step() == SQLITE_ROW)
   {
-    auto item = Detail::ReadMaterializedFile(statement.get());
-    item.RelativePath = BuildRelativePath(item.LogicalFile);
-    files.push_back(item);
+    files.push_back(Detail::ReadMaterializedFile(statement.get()));
   }
   return files;
 }
+
+MaterializedRows Database::InspectCurrentFileRows()
+{
+  MaterializedRows rows;
+  ForEachCurrentFile([&](const MaterializedRow &row)
+                     { rows.Add(row); });
+  return rows;
+}
+
+void Database::ForEachCurrentFile(const std::function<void(const MaterializedRow &)> &visitor)
+{
+  auto statement = m_Database->Prepare(StatementId::SelectCurrentFiles);
+  while (statement.Step() == SQLITE_ROW)
+    visitor(Detail::ReadMaterializedRow(statement.get()));
+}
+
+void Database::InspectFiles(const std::function<void(const InspectionRow &)> &visitor)
+{
+  auto statement = m_Database->Prepare(StatementId::InspectCurrentFiles);
+  while (statement.Step() == SQLITE_ROW)
+  {
+    const auto *path = reinterpret_cast<const char *>(sqlite3_column_text(statement.get(), 0));
+    visitor(InspectionRow{
+        .RelativePath = std::string_view(path, static_cast<std::size_t>(sqlite3_column_bytes(statement.get(), 0))),
+        .VersionNumber = sqlite3_column_int64(statement.get(), 1),
+        .Status = static_cast<BlobStatus>(sqlite3_column_int(statement.get(), 2)),
+        .PropertyCount = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 3)),
+        .OutgoingRelationCount = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 4))});
+  }
+}
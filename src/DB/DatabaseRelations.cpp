@@ -1,31 +1,14 @@
 #include "DatabaseInternal.hpp"
 
+#include <unordered_set>
+
 namespace fs = std::filesystem;
 using namespace Docmasys;
 using namespace Docmasys::DB;
 
 std::vector<MaterializedFile> Database::ResolveMaterialization(const std::shared_ptr<FileVersion> &rootVersion, RelationScope scope)
 {
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    WITH RECURSIVE selected(version_id) AS (
-      SELECT ?1
-      UNION
-      SELECT vr.to_version_id
-      FROM version_relations vr
-      JOIN selected s ON s.version_id=vr.from_version_id
-      WHERE (?2=1 AND vr.relation_type=0)
-         OR (?2=2 AND vr.relation_type IN (0,1))
-         OR (?2=3 AND vr.relation_type IN (0,1,2))
-    )
-    SELECT f.id,f.parent_id,f.name,f.current_version_id,
-           fv.id,fv.file_id,fv.blob_id,fv.version_number,
-           b.id,b.hash,b.status
-    FROM selected s
-    JOIN file_versions fv ON fv.id=s.version_id
-    JOIN files f ON f.id=fv.file_id
-    JOIN blobs b ON b.id=fv.blob_id
-    ORDER BY f.id,fv.version_number;
-  )SQL");
+  auto statement = m_Database->Prepare(StatementId::ResolveMaterialization);
   statement.BindInt64(1, rootVersion->Id);
   statement.BindInt64(2, static_cast<int>(scope));
 
@@ -34,7 +17,6 @@ std::vector<MaterializedFile> Database::ResolveMaterialization(const std::shared
   while (statement.Step() == SQLITE_ROW)
   {
     auto item = Detail::ReadMaterializedFile(statement.get());
-    item.RelativePath = BuildRelativePath(item.LogicalFile);
     const auto [it, inserted] = seenByLogicalFile.emplace(item.LogicalFile->Id, item.Version->Id);
     if (!inserted && it->second != item.Version->Id)
       throw std::runtime_error("materialization conflict: multiple versions selected for logical path '" + item.RelativePath.generic_string() + "'");
@@ -43,22 +25,224 @@ std::vector<MaterializedFile> Database::ResolveMaterialization(const std::shared
   return files;
 }
 
+std::vector<MaterializedFile> Database::ResolveMaterialization(const std::vector<MaterializationRoot> &roots)
+{
+  ExecSQL(DB_TEMP_MATERIALIZATION_ROOTS);
+  m_Database->Prepare(StatementId::ClearMaterializationRoots).ExpectDone();
+  for (const auto &root : roots)
+  {
+    auto insert = m_Database->Prepare(StatementId::InsertMaterializationRoot);
+    insert.BindInt64(1, root.VersionId);
+    insert.BindInt(2, static_cast<int>(root.Scope));
+    insert.ExpectDone();
+  }
+
+  std::vector<MaterializedFile> files;
+  {
+    auto statement = m_Database->Prepare(StatementId::ResolveMaterializationOfRoots);
+    ID previousFile{};
+    while (statement.Step() == SQLITE_ROW)
+    {
+      auto item = Detail::ReadMaterializedFile(statement.get());
+      // Rows are ordered by file id, so a second version of one file follows the first directly.
+      if (!files.empty() && previousFile == item.LogicalFile->Id)
+        throw std::runtime_error("materialization conflict: multiple versions selected for logical path '" + item.RelativePath.generic_string() + "'");
+      previousFile = item.LogicalFile->Id;
+      files.push_back(std::move(item));
+    }
+  }
+  m_Database->Prepare(StatementId::ClearMaterializationRoots).ExpectDone();
+  return files;
+}
+
+MaterializedRows Database::ResolveMaterializationRows(ID rootVersionId, RelationScope scope)
+{
+  MaterializedRows rows;
+  ForEachMaterialization(rootVersionId, scope, [&](const MaterializedRow &row)
+                         { rows.Add(row); });
+  return rows;
+}
+
+void Database::ForEachMaterialization(ID rootVersionId, RelationScope scope, const std::function<void(const MaterializedRow &)> &visitor)
+{
+  auto statement = m_Database->Prepare(StatementId::ResolveMaterialization);
+  statement.BindInt64(1, rootVersionId);
+  statement.BindInt64(2, static_cast<int>(scope));
+
+  std::unordered_map<ID, ID> seenByLogicalFile;
+  while (statement.Step() == SQLITE_ROW)
+  {
+    const auto row = Detail::ReadMaterializedRow(statement.get());
+    const auto [it, inserted] = seenByLogicalFile.emplace(row.FileId, row.VersionId);
+    if (!inserted && it->second != row.VersionId)
+      throw std::runtime_error("materialization conflict: multiple versions selected for logical path '" + std::string(row.RelativePath) + "'");
+    visitor(row);
+  }
+}
+
 void Database::AddRelation(const std::shared_ptr<FileVersion> &from, const std::shared_ptr<FileVersion> &to, RelationType type)
 {
-  Sqlite::Statement statement(m_Database->m_db, "INSERT OR IGNORE INTO version_relations(from_version_id,to_version_id,relation_type) VALUES(?1,?2,?3);");
-  statement.BindInt64(1, from->Id);
-  statement.BindInt64(2, to->Id);
-  statement.BindInt64(3, static_cast<int>(type));
-  statement.ExpectDone();
+  Transaction transaction(*this);
+  PlaceRelation(from->Id, to->Id);
+  {
+    auto statement = m_Database->Prepare(StatementId::InsertRelation);
+    statement.BindInt64(1, from->Id);
+    statement.BindInt64(2, to->Id);
+    statement.BindInt64(3, static_cast<int>(type));
+    statement.ExpectDone();
+  }
+  transaction.Commit();
+}
+
+namespace
+{
+  struct OrderedVersion
+  {
+    ID Version{};
+    std::int64_t Position{};
+  };
+}
+
+void Database::PlaceRelation(ID from, ID to)
+{
+  if (from == to)
+    throw std::runtime_error("version relation cycle detected");
+
+  const auto positionOf = [this](ID version) -> std::optional<std::int64_t>
+  {
+    auto statement = m_Database->Prepare(StatementId::SelectVersionPosition);
+    statement.BindInt64(1, version);
+    if (statement.Step() != SQLITE_ROW)
+      return std::nullopt;
+    return sqlite3_column_int64(statement.get(), 0);
+  };
+  const auto setPosition = [this](ID version, std::int64_t position)
+  {
+    auto statement = m_Database->Prepare(StatementId::UpsertVersionPosition);
+    statement.BindInt64(1, version);
+    statement.BindInt64(2, position);
+    statement.ExpectDone();
+  };
+
+  const auto fromPosition = positionOf(from);
+  const auto toPosition = positionOf(to);
+  if (!fromPosition || !toPosition)
+  {
+    // A version without a position has no relations yet, so it can go to either end of the order.
+    std::int64_t low = 0;
+    std::int64_t high = 0;
+    {
+      auto bounds = m_Database->Prepare(StatementId::SelectPositionBounds);
+      bounds.ExpectRow();
+      low = sqlite3_column_int64(bounds.get(), 0);
+      high = sqlite3_column_int64(bounds.get(), 1);
+    }
+    if (!fromPosition && !toPosition)
+    {
+      setPosition(from, high + 1);
+      setPosition(to, high + 2);
+    }
+    else if (!fromPosition)
+      setPosition(from, low - 1);
+    else
+      setPosition(to, high + 1);
+    return;
+  }
+  if (*fromPosition < *toPosition)
+    return;
+
+  // Versions reachable from `start` whose positions stay within `bound`; reaching `forbidden` closes a cycle.
+  const auto reachWithin = [this](OrderedVersion start, std::int64_t bound, StatementId neighbours, ID forbidden)
+  {
+    std::vector<OrderedVersion> reached{start};
+    std::unordered_set<ID> seen{start.Version};
+    for (std::size_t next = 0; next < reached.size(); ++next)
+    {
+      auto statement = m_Database->Prepare(neighbours);
+      statement.BindInt64(1, reached[next].Version);
+      statement.BindInt64(2, bound);
+      while (statement.Step() == SQLITE_ROW)
+      {
+        const OrderedVersion neighbour{sqlite3_column_int64(statement.get(), 0), sqlite3_column_int64(statement.get(), 1)};
+        if (neighbour.Version == forbidden)
+          throw std::runtime_error("version relation cycle detected");
+        if (seen.insert(neighbour.Version).second)
+          reached.push_back(neighbour);
+      }
+    }
+    return reached;
+  };
+
+  // The edge points backwards in the order. Everything that reaches `from` (down to `to`'s position) must move
+  // ahead of everything reachable from `to` (up to `from`'s position); both sets lie between the two endpoints,
+  // so only that region is searched and only its positions are reassigned.
+  auto forward = reachWithin({to, *toPosition}, *fromPosition, StatementId::SelectSuccessorsUpTo, from);
+  auto backward = reachWithin({from, *fromPosition}, *toPosition, StatementId::SelectPredecessorsDownTo, to);
+
+  const auto byPosition = [](const OrderedVersion &a, const OrderedVersion &b)
+  { return a.Position < b.Position; };
+  std::sort(forward.begin(), forward.end(), byPosition);
+  std::sort(backward.begin(), backward.end(), byPosition);
+
+  std::vector<std::int64_t> positions;
+  positions.reserve(forward.size() + backward.size());
+  for (const auto &version : backward)
+    positions.push_back(version.Position);
+  for (const auto &version : forward)
+    positions.push_back(version.Position);
+  std::sort(positions.begin(), positions.end());
+
+  std::size_t next = 0;
+  for (const auto &version : backward)
+    setPosition(version.Version, positions[next++]);
+  for (const auto &version : forward)
+    setPosition(version.Version, positions[next++]);
+}
+
+void Database::RebuildRelationOrder()
+{
+  std::unordered_map<ID, std::vector<ID>> successors;
+  std::unordered_map<ID, std::size_t> incoming;
+  {
+    Sqlite::Statement edges(m_Database->m_db, "SELECT DISTINCT from_version_id, to_version_id FROM version_relations;", &m_Database->m_Counters);
+    while (edges.Step() == SQLITE_ROW)
+    {
+      const ID from = sqlite3_column_int64(edges.get(), 0);
+      const ID to = sqlite3_column_int64(edges.get(), 1);
+      successors[from].push_back(to);
+      incoming.try_emplace(from, 0);
+      ++incoming[to];
+    }
+  }
+
+  std::vector<ID> ready;
+  for (const auto &[version, count] : incoming)
+    if (count == 0)
+      ready.push_back(version);
+
+  Transaction transaction(*this);
+  ExecSQL("DELETE FROM version_order;");
+  std::int64_t position = 0;
+  while (!ready.empty())
+  {
+    const auto version = ready.back();
+    ready.pop_back();
+    auto statement = m_Database->Prepare(StatementId::UpsertVersionPosition);
+    statement.BindInt64(1, version);
+    statement.BindInt64(2, position++);
+    statement.ExpectDone();
+    for (const auto successor : successors[version])
+      if (--incoming[successor] == 0)
+        ready.push_back(successor);
+  }
+  if (static_cast<std::size_t>(position) != incoming.size())
+    throw std::runtime_error("version relation cycle detected");
+  transaction.Commit();
 }
 
 std::vector<VersionRelationView> Database::GetOutgoingRelations(const std::shared_ptr<FileVersion> &from, std::optional<RelationType> typeFilter)
 {
-  Sqlite::Statement statement(
-      m_Database->m_db,
-      typeFilter
-          ? "SELECT vr.from_version_id, vr.to_version_id, vr.relation_type, fv.file_id, fv.blob_id, fv.version_number FROM version_relations vr JOIN file_versions fv ON fv.id=vr.to_version_id WHERE vr.from_version_id=?1 AND vr.relation_type=?2 ORDER BY vr.relation_type, fv.file_id, fv.version_number;"
-          : "SELECT vr.from_version_id, vr.to_version_id, vr.relation_type, fv.file_id, fv.blob_id, fv.version_number FROM version_relations vr JOIN file_versions fv ON fv.id=vr.to_version_id WHERE vr.from_version_id=?1 ORDER BY vr.relation_type, fv.file_id, fv.version_number;");
+  auto statement = m_Database->Prepare(typeFilter ? StatementId::SelectOutgoingRelationsOfType : StatementId::SelectOutgoingRelations);
   statement.BindInt64(1, from->Id);
   if (typeFilter)
     statement.BindInt64(2, static_cast<int>(*typeFilter));
@@ -71,3 +255,54 @@ std::vector<VersionRelationView> Database::GetOutgoingRelations(const std::share
   }
   return relations;
 }
+
+std::vector<VersionRelationView> Database::GetIncomingRelations(const std::shared_ptr<FileVersion> &to, std::optional<RelationType> typeFilter)
+{
+  auto statement = m_Database->Prepare(typeFilter ? StatementId::SelectIncomingRelationsOfType : StatementId::SelectIncomingRelations);
+  statement.BindInt64(1, to->Id);
+  if (typeFilter)
+    statement.BindInt64(2, static_cast<int>(*typeFilter));
+
+  std::vector<VersionRelationView> relations;
+  while (statement.Step() == SQLITE_ROW)
+  {
+    auto from = std::make_shared<FileVersion>(sqlite3_column_int64(statement.get(), 0), sqlite3_column_int64(statement.get(), 3), sqlite3_column_int64(statement.get(), 4), sqlite3_column_int64(statement.get(), 5));
+    relations.push_back(VersionRelationView{from, to, static_cast<RelationType>(sqlite3_column_int64(statement.get(), 2))});
+  }
+  return relations;
+}
+
+void Database::ForEachWhereUsed(ID versionId, RelationScope scope, std::optional<std::size_t> maxDepth, const std::function<void(const WhereUsedRow &)> &visitor)
+{
+  // Relation types are ordered strong < weak < optional and each scope admits the types below its own value.
+  const auto admittedTypes = static_cast<int>(scope);
+  std::unordered_set<ID> seen{versionId};
+  std::vector<ID> frontier{versionId};
+  std::vector<ID> next;
+  for (std::size_t depth = 1; !frontier.empty() && (!maxDepth || depth <= *maxDepth); ++depth)
+  {
+    for (const auto used : frontier)
+    {
+      auto statement = m_Database->Prepare(StatementId::SelectVersionUsers);
+      statement.BindInt64(1, used);
+      statement.BindInt(2, admittedTypes);
+      while (statement.Step() == SQLITE_ROW)
+      {
+        const ID user = sqlite3_column_int64(statement.get(), 0);
+        if (!seen.insert(user).second)
+          continue;
+        next.push_back(user);
+        visitor(WhereUsedRow{
+            .VersionId = user,
+            .FileId = sqlite3_column_int64(statement.get(), 2),
+            .VersionNumber = sqlite3_column_int64(statement.get(), 3),
+            .RelativePath = Detail::TextView(statement.get(), 4),
+            .Depth = depth,
+            .Type = static_cast<RelationType>(sqlite3_column_int(statement.get(), 1)),
+            .IsCurrent = sqlite3_column_int(statement.get(), 5) != 0});
+      }
+    }
+    frontier.swap(next);
+    next.clear();
+  }
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Docmasys::DB
+{
+  /// @brief Every SQL statement the Database runs repeatedly; each one is prepared once per connection and cached.
+  enum class StatementId : std::uint8_t
+  {
+    BeginTransaction,
+    CommitTransaction,
+    RollbackTransaction,
+    Savepoint,
+    ReleaseSavepoint,
+    RollbackToSavepoint,
+    SelectBlobById,
+    SelectBlobByHash,
+    SelectBlobIndex,
+    InsertFolder,
+    SelectFolderByName,
+    InsertBlob,
+    InsertFile,
+    SelectFileByName,
+    SelectFileById,
+    SelectFileByPath,
+    InsertFileVersion,
+    SelectLatestFileVersion,
+    UpdateCurrentVersion,
+    UpdateBlobStatus,
+    MarkBlobStored,
+    SelectBlobsMissingSizes,
+    UpdateBlobSizes,
+    SelectCurrentContentSize,
+    SelectChildFolders,
+    SelectMaterializedFilesInFolder,
+    SelectFileVersionByNumber,
+    SelectCurrentFileVersion,
+    SelectFileVersions,
+    SelectCurrentFiles,
+    InspectCurrentFiles,
+    UpsertProperty,
+    SelectProperty,
+    SelectProperties,
+    DeleteProperty,
+    SearchText,
+    ScanText,
+    ResolveMaterialization,
+    InsertMaterializationRoot,
+    ClearMaterializationRoots,
+    ResolveMaterializationOfRoots,
+    InsertRelation,
+    SelectVersionPosition,
+    SelectPositionBounds,
+    UpsertVersionPosition,
+    SelectSuccessorsUpTo,
+    SelectPredecessorsDownTo,
+    SelectOutgoingRelationsOfType,
+    SelectOutgoingRelations,
+    SelectIncomingRelationsOfType,
+    SelectIncomingRelations,
+    SelectVersionUsers,
+    InsertBaseline,
+    CaptureBaselineEntries,
+    SelectBaselineByName,
+    SelectBaselines,
+    DeleteBaseline,
+    SelectBaselineFiles,
+    DiffBaselines,
+    SelectLastChangeSequence,
+    SelectChangesSince,
+    InsertWorkspace,
+    SelectWorkspaceId,
+    UpsertWorkspaceEntry,
+    SelectWorkspaceEntry,
+    SelectWorkspaceEntries,
+    UpsertCheckoutLock,
+    SelectCheckoutLock,
+    SelectCheckoutLocks,
+    DeleteOwnCheckoutLock,
+    DeleteCheckoutLock,
+  };
+
+  inline constexpr std::size_t StatementCount = static_cast<std::size_t>(StatementId::DeleteCheckoutLock) + 1;
+
+  constexpr const char *StatementSql(StatementId id) noexcept
+  {
+    switch (id)
+    {
+    case StatementId::BeginTransaction:
+      return "BEGIN IMMEDIATE;";
+    case StatementId::CommitTransaction:
+      return "COMMIT;";
+    case StatementId::RollbackTransaction:
+      return "ROLLBACK;";
+    case StatementId::Savepoint:
+      return "SAVEPOINT nested;";
+    case StatementId::ReleaseSavepoint:
+      return "RELEASE nested;";
+    case StatementId::RollbackToSavepoint:
+      return "ROLLBACK TO nested;";
+    case StatementId::SelectBlobById:
+      return "SELECT id,hash,status,compression_level,raw_size,stored_size FROM blobs WHERE id=?1;";
+    case StatementId::SelectBlobByHash:
+      return "SELECT id,hash,status,compression_level,raw_size,stored_size FROM blobs WHERE hash=?1;";
+    case StatementId::SelectBlobIndex:
+      return "SELECT hash,id,status FROM blobs;";
+    case StatementId::InsertFolder:
+      return "INSERT INTO folders(parent_id,name) VALUES(?1,?2) ON CONFLICT DO NOTHING;";
+    case StatementId::SelectFolderByName:
+      return "SELECT id,parent_id,name FROM folders WHERE parent_id IS ?1 AND name=?2;";
+    case StatementId::InsertBlob:
+      return "INSERT INTO blobs(hash,status) VALUES(?1,?2) ON CONFLICT(hash) DO NOTHING;";
+    case StatementId::InsertFile:
+      return "INSERT INTO files(parent_id,name,current_version_id,relative_path) VALUES(?1,?2,NULL,?3) ON CONFLICT(parent_id,name) DO NOTHING;";
+    case StatementId::SelectFileByName:
+      return "SELECT id,parent_id,name,current_version_id,relative_path FROM files WHERE parent_id IS ?1 AND name=?2;";
+    case StatementId::SelectFileById:
+      return "SELECT id,parent_id,name,current_version_id,relative_path FROM files WHERE id=?1;";
+    case StatementId::SelectFileByPath:
+      return "SELECT id,parent_id,name,current_version_id,relative_path FROM files WHERE relative_path=?1;";
+    case StatementId::InsertFileVersion:
+      return "INSERT INTO file_versions(file_id,version_number,blob_id) VALUES(?1, COALESCE((SELECT MAX(version_number)+1 FROM file_versions WHERE file_id=?1),1), ?2);";
+    case StatementId::SelectLatestFileVersion:
+      return "SELECT id,file_id,blob_id,version_number FROM file_versions WHERE file_id=?1 ORDER BY version_number DESC LIMIT 1;";
+    case StatementId::UpdateCurrentVersion:
+      return "UPDATE files SET current_version_id=?2 WHERE id=?1;";
+    case StatementId::UpdateBlobStatus:
+      return "UPDATE blobs SET status=?2 WHERE id=?1;";
+    case StatementId::MarkBlobStored:
+      return "UPDATE blobs SET status=?2, compression_level=?3, raw_size=?4, stored_size=?5 WHERE id=?1;";
+    case StatementId::SelectBlobsMissingSizes:
+      return "SELECT id,hash,status,compression_level,raw_size,stored_size FROM blobs WHERE status=1 AND (raw_size IS NULL OR stored_size IS NULL) ORDER BY id;";
+    case StatementId::UpdateBlobSizes:
+      return "UPDATE blobs SET raw_size=?2, stored_size=?3 WHERE id=?1;";
+    case StatementId::SelectCurrentContentSize:
+      return "SELECT COALESCE(SUM(b.raw_size),0) FROM files f JOIN file_versions fv ON fv.id=f.current_version_id JOIN blobs b ON b.id=fv.blob_id WHERE b.status=1;";
+    case StatementId::SelectChildFolders:
+      return "SELECT id,parent_id,name FROM folders WHERE parent_id IS ?1 ORDER BY name;";
+    case StatementId::SelectMaterializedFilesInFolder:
+      return "SELECT f.id,f.parent_id,f.name,f.current_version_id,fv.id,fv.file_id,fv.blob_id,fv.version_number,b.id,b.hash,b.status,b.compression_level,b.raw_size,b.stored_size,f.relative_path FROM files f JOIN file_versions fv ON fv.id=f.current_version_id JOIN blobs b ON b.id=fv.blob_id WHERE f.parent_id=?1 ORDER BY f.name;";
+    case StatementId::SelectFileVersionByNumber:
+      return "SELECT id,file_id,blob_id,version_number FROM file_versions WHERE file_id=?1 AND version_number=?2;";
+    case StatementId::SelectCurrentFileVersion:
+      return "SELECT fv.id,fv.file_id,fv.blob_id,fv.version_number FROM file_versions fv JOIN files f ON f.current_version_id=fv.id WHERE f.id=?1;";
+    case StatementId::SelectFileVersions:
+      return "SELECT id,file_id,blob_id,version_number FROM file_versions WHERE file_id=?1 ORDER BY version_number;";
+    case StatementId::SelectCurrentFiles:
+      return "SELECT f.id,f.parent_id,f.name,f.current_version_id,fv.id,fv.file_id,fv.blob_id,fv.version_number,b.id,b.hash,b.status,b.compression_level,b.raw_size,b.stored_size,f.relative_path FROM files f JOIN file_versions fv ON fv.id=f.current_version_id JOIN blobs b ON b.id=fv.blob_id ORDER BY f.id;";
+    case StatementId::InspectCurrentFiles:
+      return R"SQL(
+      SELECT f.relative_path, fv.version_number, b.status,
+             (SELECT COUNT(*) FROM version_properties vp WHERE vp.version_id=fv.id),
+             (SELECT COUNT(*) FROM version_relations vr WHERE vr.from_version_id=fv.id)
+      FROM files f
+      JOIN file_versions fv ON fv.id=f.current_version_id
+      JOIN blobs b ON b.id=fv.blob_id
+      ORDER BY f.id;
+  )SQL";
+    case StatementId::UpsertProperty:
+      return R"SQL(
+      INSERT INTO version_properties(version_id,name,normalized_name,value_type,string_value,int_value,bool_value)
+      VALUES(?1,?2,?3,?4,?5,?6,?7)
+      ON CONFLICT(version_id, normalized_name) DO UPDATE SET
+        name=excluded.name,
+        value_type=excluded.value_type,
+        string_value=excluded.string_value,
+        int_value=excluded.int_value,
+        bool_value=excluded.bool_value;
+  )SQL";
+    case StatementId::SelectProperty:
+      return "SELECT version_id,name,value_type,string_value,int_value,bool_value FROM version_properties WHERE version_id=?1 AND normalized_name=?2;";
+    case StatementId::SelectProperties:
+      return "SELECT version_id,name,value_type,string_value,int_value,bool_value FROM version_properties WHERE version_id=?1 ORDER BY normalized_name;";
+    case StatementId::DeleteProperty:
+      return "DELETE FROM version_properties WHERE version_id=?1 AND normalized_name=?2;";
+    case StatementId::SearchText:
+      // bm25 values of the two indexes are not on one scale, so each source is ranked on its own and the two are interleaved.
+      return R"SQL(
+      WITH property_hits AS (
+        SELECT f.id AS file_id, fv.version_number, f.relative_path, vp.name, vp.string_value AS text, bm25(property_text_index) AS score
+        FROM property_text_index
+        JOIN version_properties vp ON vp.rowid=property_text_index.rowid
+        JOIN file_versions fv ON fv.id=vp.version_id
+        JOIN files f ON f.id=fv.file_id
+        WHERE property_text_index MATCH ?1 AND (?2=0 OR f.current_version_id=fv.id)),
+      name_hits AS (
+        SELECT f.id AS file_id, fv.version_number, f.relative_path, NULL AS name, f.name AS text, bm25(file_name_index) AS score
+        FROM file_name_index
+        JOIN files f ON f.id=file_name_index.rowid
+        JOIN file_versions fv ON fv.id=f.current_version_id
+        WHERE file_name_index MATCH ?1)
+      SELECT file_id, version_number, relative_path, name, text, score FROM (
+        SELECT *, ROW_NUMBER() OVER (ORDER BY score, relative_path) AS position, 0 AS source FROM property_hits
+        UNION ALL
+        SELECT *, ROW_NUMBER() OVER (ORDER BY score, relative_path) AS position, 1 AS source FROM name_hits)
+      ORDER BY position, source
+      LIMIT ?3;
+  )SQL";
+    case StatementId::ScanText:
+      return R"SQL(
+      SELECT f.id, fv.version_number, f.relative_path, vp.name, vp.string_value, 0.0 AS score
+      FROM version_properties vp
+      JOIN file_versions fv ON fv.id=vp.version_id
+      JOIN files f ON f.id=fv.file_id
+      WHERE vp.value_type=0 AND vp.string_value LIKE ?1 ESCAPE '\' AND (?2=0 OR f.current_version_id=fv.id)
+      UNION ALL
+      SELECT f.id, fv.version_number, f.relative_path, NULL, f.name, 0.0
+      FROM files f
+      JOIN file_versions fv ON fv.id=f.current_version_id
+      WHERE f.name LIKE ?1 ESCAPE '\'
+      ORDER BY score, relative_path
+      LIMIT ?3;
+  )SQL";
+    case StatementId::ResolveMaterialization:
+      return R"SQL(
+      WITH RECURSIVE selected(version_id) AS (
+        SELECT ?1
+        UNION
+        SELECT vr.to_version_id
+        FROM version_relations vr
+        JOIN selected s ON s.version_id=vr.from_version_id
+        WHERE (?2=1 AND vr.relation_type=0)
+           OR (?2=2 AND vr.relation_type IN (0,1))
+           OR (?2=3 AND vr.relation_type IN (0,1,2))
+      )
+      SELECT f.id,f.parent_id,f.name,f.current_version_id,
+             fv.id,fv.file_id,fv.blob_id,fv.version_number,
+             b.id,b.hash,b.status,b.compression_level,b.raw_size,b.stored_size,f.relative_path
+      FROM selected s
+      JOIN file_versions fv ON fv.id=s.version_id
+      JOIN files f ON f.id=fv.file_id
+      JOIN blobs b ON b.id=fv.blob_id
+      ORDER BY f.id,fv.version_number;
+  )SQL";
+    case StatementId::InsertMaterializationRoot:
+      return "INSERT OR IGNORE INTO temp.materialization_roots(version_id,scope) VALUES(?1,?2);";
+    case StatementId::ClearMaterializationRoots:
+      return "DELETE FROM temp.materialization_roots;";
+    case StatementId::ResolveMaterializationOfRoots:
+      return R"SQL(
+      WITH RECURSIVE selected(version_id, scope) AS (
+        SELECT version_id, scope FROM temp.materialization_roots
+        UNION
+        SELECT vr.to_version_id, s.scope
+        FROM version_relations vr
+        JOIN selected s ON s.version_id=vr.from_version_id
+        WHERE vr.relation_type<s.scope
+      )
+      SELECT f.id,f.parent_id,f.name,f.current_version_id,
+             fv.id,fv.file_id,fv.blob_id,fv.version_number,
+             b.id,b.hash,b.status,b.compression_level,b.raw_size,b.stored_size,f.relative_path
+      FROM (SELECT DISTINCT version_id FROM selected) s
+      JOIN file_versions fv ON fv.id=s.version_id
+      JOIN files f ON f.id=fv.file_id
+      JOIN blobs b ON b.id=fv.blob_id
+      ORDER BY f.id,fv.version_number;
+  )SQL";
+    case StatementId::InsertRelation:
+      return "INSERT OR IGNORE INTO version_relations(from_version_id,to_version_id,relation_type) VALUES(?1,?2,?3);";
+    case StatementId::SelectVersionPosition:
+      return "SELECT position FROM version_order WHERE version_id=?1;";
+    case StatementId::SelectPositionBounds:
+      return "SELECT MIN(position), MAX(position) FROM version_order;";
+    case StatementId::UpsertVersionPosition:
+      return "INSERT INTO version_order(version_id,position) VALUES(?1,?2) ON CONFLICT(version_id) DO UPDATE SET position=excluded.position;";
+    case StatementId::SelectSuccessorsUpTo:
+      return "SELECT vr.to_version_id, o.position FROM version_relations vr JOIN version_order o ON o.version_id=vr.to_version_id WHERE vr.from_version_id=?1 AND o.position<=?2;";
+    case StatementId::SelectPredecessorsDownTo:
+      return "SELECT vr.from_version_id, o.position FROM version_relations vr JOIN version_order o ON o.version_id=vr.from_version_id WHERE vr.to_version_id=?1 AND o.position>=?2;";
+    case StatementId::SelectOutgoingRelationsOfType:
+      return "SELECT vr.from_version_id, vr.to_version_id, vr.relation_type, fv.file_id, fv.blob_id, fv.version_number FROM version_relations vr JOIN file_versions fv ON fv.id=vr.to_version_id WHERE vr.from_version_id=?1 AND vr.relation_type=?2 ORDER BY vr.relation_type, fv.file_id, fv.version_number;";
+    case StatementId::SelectOutgoingRelations:
+      return "SELECT vr.from_version_id, vr.to_version_id, vr.relation_type, fv.file_id, fv.blob_id, fv.version_number FROM version_relations vr JOIN file_versions fv ON fv.id=vr.to_version_id WHERE vr.from_version_id=?1 ORDER BY vr.relation_type, fv.file_id, fv.version_number;";
+    case StatementId::SelectIncomingRelationsOfType:
+      return "SELECT vr.from_version_id, vr.to_version_id, vr.relation_type, fv.file_id, fv.blob_id, fv.version_number FROM version_relations vr JOIN file_versions fv ON fv.id=vr.from_version_id WHERE vr.to_version_id=?1 AND vr.relation_type=?2 ORDER BY vr.relation_type, fv.file_id, fv.version_number;";
+    case StatementId::SelectIncomingRelations:
+      return "SELECT vr.from_version_id, vr.to_version_id, vr.relation_type, fv.file_id, fv.blob_id, fv.version_number FROM version_relations vr JOIN file_versions fv ON fv.id=vr.from_version_id WHERE vr.to_version_id=?1 ORDER BY vr.relation_type, fv.file_id, fv.version_number;";
+    case StatementId::SelectVersionUsers:
+      return R"SQL(
+      SELECT vr.from_version_id, MIN(vr.relation_type), fv.file_id, fv.version_number, f.relative_path, f.current_version_id=fv.id
+      FROM version_relations vr
+      JOIN file_versions fv ON fv.id=vr.from_version_id
+      JOIN files f ON f.id=fv.file_id
+      WHERE vr.to_version_id=?1 AND vr.relation_type<?2
+      GROUP BY vr.from_version_id;
+  )SQL";
+    case StatementId::InsertBaseline:
+      return "INSERT INTO baselines(name,created_at) VALUES(?1,CAST(strftime('%s','now') AS INTEGER));";
+    case StatementId::CaptureBaselineEntries:
+      return "INSERT INTO baseline_entries(baseline_id,file_id,version_id) SELECT ?1,id,current_version_id FROM files WHERE current_version_id IS NOT NULL;";
+    case StatementId::SelectBaselineByName:
+      return "SELECT b.id,b.name,b.created_at,(SELECT COUNT(*) FROM baseline_entries be WHERE be.baseline_id=b.id) FROM baselines b WHERE b.name=?1;";
+    case StatementId::SelectBaselines:
+      return "SELECT b.id,b.name,b.created_at,(SELECT COUNT(*) FROM baseline_entries be WHERE be.baseline_id=b.id) FROM baselines b ORDER BY b.name;";
+    case StatementId::DeleteBaseline:
+      return "DELETE FROM baselines WHERE name=?1;";
+    case StatementId::SelectBaselineFiles:
+      return "SELECT f.id,f.parent_id,f.name,f.current_version_id,fv.id,fv.file_id,fv.blob_id,fv.version_number,b.id,b.hash,b.status,b.compression_level,b.raw_size,b.stored_size,f.relative_path FROM baseline_entries be JOIN files f ON f.id=be.file_id JOIN file_versions fv ON fv.id=be.version_id JOIN blobs b ON b.id=fv.blob_id WHERE be.baseline_id=?1 ORDER BY be.file_id;";
+    case StatementId::DiffBaselines:
+      // Both halves walk one baseline's primary-key range and probe the other by (baseline_id, file_id).
+      return R"SQL(
+      SELECT f.id, f.relative_path, av.version_number, bv.version_number
+      FROM (SELECT a.file_id, a.version_id AS from_version, b.version_id AS to_version
+            FROM baseline_entries a LEFT JOIN baseline_entries b ON b.baseline_id=?2 AND b.file_id=a.file_id
+            WHERE a.baseline_id=?1 AND b.version_id IS NOT a.version_id
+            UNION ALL
+            SELECT b.file_id, NULL, b.version_id
+            FROM baseline_entries b
+            WHERE b.baseline_id=?2 AND NOT EXISTS (SELECT 1 FROM baseline_entries a WHERE a.baseline_id=?1 AND a.file_id=b.file_id)) d
+      JOIN files f ON f.id=d.file_id
+      LEFT JOIN file_versions av ON av.id=d.from_version
+      LEFT JOIN file_versions bv ON bv.id=d.to_version
+      ORDER BY f.relative_path;
+      )SQL";
+    case StatementId::SelectLastChangeSequence:
+      return "SELECT COALESCE(MAX(sequence),0) FROM change_journal;";
+    case StatementId::SelectChangesSince:
+      return R"SQL(
+      SELECT c.sequence, c.kind, c.file_id, c.version_id, fv.version_number, f.relative_path,
+             c.target_version_id, tv.version_number, tf.relative_path, c.detail, c.recorded_at
+      FROM change_journal c
+      LEFT JOIN files f ON f.id=c.file_id
+      LEFT JOIN file_versions fv ON fv.id=c.version_id
+      LEFT JOIN file_versions tv ON tv.id=c.target_version_id
+      LEFT JOIN files tf ON tf.id=tv.file_id
+      WHERE c.sequence>?1
+      ORDER BY c.sequence
+      LIMIT ?2;
+      )SQL";
+    case StatementId::InsertWorkspace:
+      return "INSERT INTO workspaces(root) VALUES(?1) ON CONFLICT(root) DO NOTHING;";
+    case StatementId::SelectWorkspaceId:
+      return "SELECT id FROM workspaces WHERE root=?1;";
+    case StatementId::UpsertWorkspaceEntry:
+      return R"SQL(
+      INSERT INTO workspace_entries(workspace_id,file_id,version_id,relative_path,materialization_kind)
+      VALUES(?1,?2,?3,?4,?5)
+      ON CONFLICT(workspace_id, file_id) DO UPDATE SET
+        version_id=excluded.version_id,
+        relative_path=excluded.relative_path,
+        materialization_kind=excluded.materialization_kind;
+  )SQL";
+    case StatementId::SelectWorkspaceEntry:
+      return R"SQL(
+      SELECT f.id,f.parent_id,f.name,f.current_version_id,
+             fv.id,fv.file_id,fv.blob_id,fv.version_number,
+             we.relative_path,we.materialization_kind,f.relative_path
+      FROM workspace_entries we
+      JOIN files f ON f.id=we.file_id
+      JOIN file_versions fv ON fv.id=we.version_id
+      WHERE we.workspace_id=(SELECT id FROM workspaces WHERE root=?1) AND we.file_id=?2;
+  )SQL";
+    case StatementId::SelectWorkspaceEntries:
+      return R"SQL(
+      SELECT f.id,f.parent_id,f.name,f.current_version_id,
+             fv.id,fv.file_id,fv.blob_id,fv.version_number,
+             we.relative_path,we.materialization_kind,f.relative_path,b.hash
+      FROM workspace_entries we
+      JOIN files f ON f.id=we.file_id
+      JOIN file_versions fv ON fv.id=we.version_id
+      JOIN blobs b ON b.id=fv.blob_id
+      WHERE we.workspace_id=(SELECT id FROM workspaces WHERE root=?1)
+      ORDER BY we.relative_path;
+  )SQL";
+    case StatementId::UpsertCheckoutLock:
+      return R"SQL(
+      INSERT INTO checkout_locks(file_id,version_id,user_name,environment_name,workspace_id)
+      VALUES(?1,?2,?3,?4,?5)
+      ON CONFLICT(file_id) DO UPDATE SET
+        version_id=excluded.version_id,
+        user_name=excluded.user_name,
+        environment_name=excluded.environment_name,
+        workspace_id=excluded.workspace_id
+      WHERE checkout_locks.user_name=excluded.user_name
+        AND checkout_locks.environment_name=excluded.environment_name
+        AND checkout_locks.workspace_id=excluded.workspace_id;
+  )SQL";
+    case StatementId::SelectCheckoutLock:
+      return R"SQL(
+      SELECT f.id,f.parent_id,f.name,f.current_version_id,
+             cl.user_name,cl.environment_name,w.root,f.relative_path
+      FROM checkout_locks cl
+      JOIN files f ON f.id=cl.file_id
+      JOIN workspaces w ON w.id=cl.workspace_id
+      WHERE cl.file_id=?1;
+  )SQL";
+    case StatementId::SelectCheckoutLocks:
+      return R"SQL(
+      SELECT f.id,f.parent_id,f.name,f.current_version_id,
+             cl.user_name,cl.environment_name,w.root,f.relative_path
+      FROM checkout_locks cl
+      JOIN files f ON f.id=cl.file_id
+      JOIN workspaces w ON w.id=cl.workspace_id
+      ORDER BY cl.file_id;
+  )SQL";
+    case StatementId::DeleteOwnCheckoutLock:
+      return "DELETE FROM checkout_locks WHERE file_id=?1 AND user_name=?2 AND environment_name=?3 AND workspace_id=(SELECT id FROM workspaces WHERE root=?4);";
+    case StatementId::DeleteCheckoutLock:
+      return "DELETE FROM checkout_locks WHERE file_id=?1;";
+    }
+    return nullptr;
+  }
+}
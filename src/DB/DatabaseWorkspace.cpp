@@ -4,21 +4,40 @@ namespace fs = std::filesystem;
 using namespace Docmasys;
 using namespace Docmasys::DB;
 
+namespace
+{
+  /// @brief Workspace entries checked per hashing batch by ForEachWorkspaceStatus.
+  constexpr size_t STATUS_BATCH_ENTRIES = 256;
+}
+
+ID Database::GetOrCreateWorkspace(const fs::path &workspaceRoot)
+{
+  auto root = Common::CanonicalWorkspaceRoot(workspaceRoot);
+  if (const auto cached = m_Database->m_Workspaces.find(root); cached != m_Database->m_Workspaces.end())
+    return cached->second;
+
+  auto insert = m_Database->Prepare(StatementId::InsertWorkspace);
+  insert.BindText(1, root);
+  insert.ExpectDone();
+
+  auto select = m_Database->Prepare(StatementId::SelectWorkspaceId);
+  select.BindText(1, root);
+  if (select.Step() != SQLITE_ROW)
+    throw std::runtime_error("workspace select failed");
+  const ID id = sqlite3_column_int64(select.get(), 0);
+  m_Database->m_Workspaces.emplace(std::move(root), id);
+  return id;
+}
+
 void Database::UpsertWorkspaceEntry(const fs::path &workspaceRoot,
                                     const std::shared_ptr<File> &file,
                                     const std::shared_ptr<FileVersion> &version,
                                     const fs::path &relativePath,
                                     MaterializationKind kind)
 {
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    INSERT INTO workspace_entries(workspace_root,file_id,version_id,relative_path,materialization_kind)
-    VALUES(?1,?2,?3,?4,?5)
-    ON CONFLICT(workspace_root, file_id) DO UPDATE SET
-      version_id=excluded.version_id,
-      relative_path=excluded.relative_path,
-      materialization_kind=excluded.materialization_kind;
-  )SQL");
-  statement.BindText(1, Common::CanonicalWorkspaceRoot(workspaceRoot));
+  const auto workspaceId = GetOrCreateWorkspace(workspaceRoot);
+  auto statement = m_Database->Prepare(StatementId::UpsertWorkspaceEntry);
+  statement.BindInt64(1, workspaceId);
   statement.BindInt64(2, file->Id);
   statement.BindInt64(3, version->Id);
   statement.BindText(4, relativePath.generic_string());
@@ -28,15 +47,7 @@ void Database::UpsertWorkspaceEntry(const fs::path &workspaceRoot,
 
 std::optional<WorkspaceEntry> Database::GetWorkspaceEntry(const fs::path &workspaceRoot, const std::shared_ptr<File> &file)
 {
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    SELECT f.id,f.parent_id,f.name,f.current_version_id,
-           fv.id,fv.file_id,fv.blob_id,fv.version_number,
-           we.relative_path,we.materialization_kind
-    FROM workspace_entries we
-    JOIN files f ON f.id=we.file_id
-    JOIN file_versions fv ON fv.id=we.version_id
-    WHERE we.workspace_root=?1 AND we.file_id=?2;
-  )SQL");
+  auto statement = m_Database->Prepare(StatementId::SelectWorkspaceEntry);
   statement.BindText(1, Common::CanonicalWorkspaceRoot(workspaceRoot));
   statement.BindInt64(2, file->Id);
   if (statement.Step() != SQLITE_ROW)
@@ -46,16 +57,7 @@ std::optional<WorkspaceEntry> Database::GetWorkspaceEntry(const fs::path &worksp
 
 std::vector<WorkspaceEntry> Database::ListWorkspaceEntries(const fs::path &workspaceRoot)
 {
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    SELECT f.id,f.parent_id,f.name,f.current_version_id,
-           fv.id,fv.file_id,fv.blob_id,fv.version_number,
-           we.relative_path,we.materialization_kind
-    FROM workspace_entries we
-    JOIN files f ON f.id=we.file_id
-    JOIN file_versions fv ON fv.id=we.version_id
-    WHERE we.workspace_root=?1
-    ORDER BY we.relative_path;
-  )SQL");
+  auto statement = m_Database->Prepare(StatementId::SelectWorkspaceEntries);
   statement.BindText(1, Common::CanonicalWorkspaceRoot(workspaceRoot));
 
   std::vector<WorkspaceEntry> entries;
@@ -64,6 +66,22 @@ std::vector<WorkspaceEntry> Database::ListWorkspaceEntries(const fs::path &works
   return entries;
 }
 
+WorkspaceRows Database::ListWorkspaceEntryRows(const fs::path &workspaceRoot)
+{
+  WorkspaceRows rows;
+  ForEachWorkspaceEntry(workspaceRoot, [&](const WorkspaceRow &row)
+                        { rows.Add(row); });
+  return rows;
+}
+
+void Database::ForEachWorkspaceEntry(const fs::path &workspaceRoot, const std::function<void(const WorkspaceRow &)> &visitor)
+{
+  auto statement = m_Database->Prepare(StatementId::SelectWorkspaceEntries);
+  statement.BindText(1, Common::CanonicalWorkspaceRoot(workspaceRoot));
+  while (statement.Step() == SQLITE_ROW)
+    visitor(Detail::ReadWorkspaceRow(statement.get()));
+}
+
 void Database::AcquireCheckoutLock(const std::shared_ptr<File> &file,
                                    const std::shared_ptr<FileVersion> &version,
                                    const std::string &user,
@@ -75,23 +93,13 @@ void Database::AcquireCheckoutLock(const std::shared_ptr<File> &file,
   if (environment.empty())
     throw std::runtime_error("checkout lock requires environment");
 
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    INSERT INTO checkout_locks(file_id,version_id,user_name,environment_name,workspace_root)
-    VALUES(?1,?2,?3,?4,?5)
-    ON CONFLICT(file_id) DO UPDATE SET
-      version_id=excluded.version_id,
-      user_name=excluded.user_name,
-      environment_name=excluded.environment_name,
-      workspace_root=excluded.workspace_root
-    WHERE checkout_locks.user_name=excluded.user_name
-      AND checkout_locks.environment_name=excluded.environment_name
-      AND checkout_locks.workspace_root=excluded.workspace_root;
-  )SQL");
+  const auto workspaceId = GetOrCreateWorkspace(workspaceRoot);
+  auto statement = m_Database->Prepare(StatementId::UpsertCheckoutLock);
   statement.BindInt64(1, file->Id);
   statement.BindInt64(2, version->Id);
   statement.BindText(3, user);
   statement.BindText(4, environment);
-  statement.BindText(5, Common::CanonicalWorkspaceRoot(workspaceRoot));
+  statement.BindInt64(5, workspaceId);
   statement.ExpectDone();
 
   if (sqlite3_changes(m_Database->m_db) == 0)
@@ -103,13 +111,7 @@ void Database::AcquireCheckoutLock(const std::shared_ptr<File> &file,
 
 std::optional<CheckoutLock> Database::GetCheckoutLock(const std::shared_ptr<File> &file)
 {
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    SELECT f.id,f.parent_id,f.name,f.current_version_id,
-           cl.user_name,cl.environment_name,cl.workspace_root
-    FROM checkout_locks cl
-    JOIN files f ON f.id=cl.file_id
-    WHERE cl.file_id=?1;
-  )SQL");
+  auto statement = m_Database->Prepare(StatementId::SelectCheckoutLock);
   statement.BindInt64(1, file->Id);
   if (statement.Step() != SQLITE_ROW)
     return std::nullopt;
@@ -118,26 +120,25 @@ std::optional<CheckoutLock> Database::GetCheckoutLock(const std::shared_ptr<File
 
 std::vector<CheckoutLock> Database::ListCheckoutLocks()
 {
-  Sqlite::Statement statement(m_Database->m_db, R"SQL(
-    SELECT f.id,f.parent_id,f.name,f.current_version_id,
-           cl.user_name,cl.environment_name,cl.workspace_root
-    FROM checkout_locks cl
-    JOIN files f ON f.id=cl.file_id
-    ORDER BY cl.file_id;
-  )SQL");
-
   std::vector<CheckoutLock> locks;
-  while (statement.Step() == SQLITE_ROW)
-    locks.push_back(Detail::ReadCheckoutLock(statement.get()));
+  ForEachCheckoutLock([&](const CheckoutLock &lock)
+                      { locks.push_back(lock); });
   return locks;
 }
 
+void Database::ForEachCheckoutLock(const std::function<void(const CheckoutLock &)> &visitor)
+{
+  auto statement = m_Database->Prepare(StatementId::SelectCheckoutLocks);
+  while (statement.Step() == SQLITE_ROW)
+    visitor(Detail::ReadCheckoutLock(statement.get()));
+}
+
 bool Database::ReleaseCheckoutLock(const std::shared_ptr<File> &file,
                                    const std::string &user,
                                    const std::string &environment,
                                    const fs::path &workspaceRoot)
 {
-  Sqlite::Statement statement(m_Database->m_db, "DELETE FROM checkout_locks WHERE file_id=?1 AND user_name=?2 AND environment_name=?3 AND workspace_root=?4;");
+  auto statement = m_Database->Prepare(StatementId::DeleteOwnCheckoutLock);
   statement.BindInt64(1, file->Id);
   statement.BindText(2, user);
   statement.BindText(3, environment);
@@ -148,20 +149,61 @@ bool Database::ReleaseCheckoutLock(const std::shared_ptr<File> &file,
 
 bool Database::ForceReleaseCheckoutLock(const std::shared_ptr<File> &file)
 {
-  Sqlite::Statement statement(m_Database->m_db, "DELETE FROM checkout_locks WHERE file_id=?1;");
+  auto statement = m_Database->Prepare(StatementId::DeleteCheckoutLock);
   statement.BindInt64(1, file->Id);
   statement.ExpectDone();
   return sqlite3_changes(m_Database->m_db) > 0;
 }
 
-std::vector<WorkspaceEntryStatus> Database::GetWorkspaceStatus(const fs::path &workspaceRoot)
+std::vector<WorkspaceEntryStatus> Database::GetWorkspaceStatus(const fs::path &workspaceRoot, CAS::IoEngine engine, CAS::IoMode mode)
 {
   std::vector<WorkspaceEntryStatus> statuses;
+  ForEachWorkspaceStatus(workspaceRoot, engine, mode, [&](const WorkspaceEntryStatus &status)
+                         { statuses.push_back(status); });
+  return statuses;
+}
+
+void Database::ForEachWorkspaceStatus(const fs::path &workspaceRoot,
+                                      CAS::IoEngine engine,
+                                      CAS::IoMode mode,
+                                      const std::function<void(const WorkspaceEntryStatus &)> &visitor)
+{
+  std::vector<WorkspaceEntryStatus> pending;
+  std::vector<size_t> toHash;
+  std::vector<fs::path> hashPaths;
+  std::vector<Identity> expectedHashes;
+  // Content comparison is the expensive part; hash the undecided files of each batch together.
+  const auto flush = [&]
+  {
+    const auto actualHashes = CAS::IdentifyMany(hashPaths, engine, mode);
+    for (size_t i = 0; i < toHash.size(); ++i)
+      if (actualHashes[i] != expectedHashes[i])
+        pending[toHash[i]].State = WorkspaceEntryState::Modified;
+    for (const auto &status : pending)
+      visitor(status);
+    pending.clear();
+    toHash.clear();
+    hashPaths.clear();
+    expectedHashes.clear();
+  };
+
   const auto archiveRoot = m_DatabaseFile.parent_path();
-  for (const auto &entry : ListWorkspaceEntries(workspaceRoot))
+  auto statement = m_Database->Prepare(StatementId::SelectWorkspaceEntries);
+  statement.BindText(1, Common::CanonicalWorkspaceRoot(workspaceRoot));
+  while (statement.Step() == SQLITE_ROW)
   {
-    const auto blob = GetBlob(entry.Version->BlobId);
-    statuses.push_back(WorkspaceEntryStatus{entry, Detail::DetectWorkspaceState(workspaceRoot, archiveRoot, entry, blob->Hash)});
+    auto entry = Detail::ReadWorkspaceEntry(statement.get());
+    const auto hash = Detail::ReadBlob(statement.get(), 11);
+    const auto state = Detail::PrecheckWorkspaceState(workspaceRoot, archiveRoot, entry, hash);
+    if (!state)
+    {
+      toHash.push_back(pending.size());
+      hashPaths.push_back(workspaceRoot / entry.RelativePath);
+      expectedHashes.push_back(hash);
+    }
+    pending.push_back(WorkspaceEntryStatus{std::move(entry), state.value_or(WorkspaceEntryState::Ok)});
+    if (pending.size() >= STATUS_BATCH_ENTRIES)
+      flush();
   }
-  return statuses;
+  flush();
 }
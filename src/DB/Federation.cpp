@@ -0,0 +1,188 @@
+#include "Federation.hpp"
+#include "DatabaseInternal.hpp"
+
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+using namespace Docmasys::DB;
+
+namespace
+{
+  /// @brief Read-only SQLite URI for @p file; '%', '?' and '#' are percent-encoded so they stay part of the path.
+  std::string ReadOnlyUri(const fs::path &file)
+  {
+    auto path = fs::absolute(file).generic_string();
+    std::string uri = "file:";
+    if (path.empty() || path.front() != '/')
+      uri.push_back('/');
+    for (const char c : path)
+    {
+      if (c == '%' || c == '?' || c == '#')
+      {
+        constexpr char digits[] = "0123456789ABCDEF";
+        uri.push_back('%');
+        uri.push_back(digits[static_cast<unsigned char>(c) >> 4]);
+        uri.push_back(digits[static_cast<unsigned char>(c) & 0xF]);
+      }
+      else
+        uri.push_back(c);
+    }
+    return uri + "?mode=ro";
+  }
+
+  std::string SchemaName(std::size_t index)
+  {
+    return "a" + std::to_string(index);
+  }
+
+  void Exec(sqlite3 *db, const std::string &sql)
+  {
+    char *error = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK)
+    {
+      const std::string message = error ? error : "sql error";
+      sqlite3_free(error);
+      throw std::runtime_error(message);
+    }
+  }
+}
+
+Federation::Federation(const std::vector<FederatedArchive> &archives) : m_Archives(archives)
+{
+  if (m_Archives.empty())
+    throw std::runtime_error("federation requires at least one archive");
+  std::unordered_set<std::string> names;
+  for (const auto &archive : m_Archives)
+    if (!names.insert(archive.Name).second)
+      throw std::runtime_error("duplicate federated archive name: " + archive.Name);
+
+  if (sqlite3_open_v2(":memory:", &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK || !m_db)
+  {
+    sqlite3_close(m_db);
+    throw std::runtime_error("SQLite open failed");
+  }
+
+  try
+  {
+    const auto limit = static_cast<std::size_t>(sqlite3_limit(m_db, SQLITE_LIMIT_ATTACHED, -1));
+    if (m_Archives.size() > limit)
+      throw std::runtime_error("at most " + std::to_string(limit) + " archives can be federated");
+    sqlite3_busy_timeout(m_db, 5000);
+
+    for (std::size_t i = 0; i < m_Archives.size(); ++i)
+    {
+      const auto &archive = m_Archives[i];
+      if (!fs::is_regular_file(archive.DatabaseFile))
+        throw std::runtime_error("archive database not found: " + archive.DatabaseFile.string());
+
+      const auto schema = SchemaName(i);
+      {
+        Sqlite::Statement attach(m_db, ("ATTACH DATABASE ?1 AS " + schema + ";").c_str());
+        attach.BindText(1, ReadOnlyUri(archive.DatabaseFile));
+        attach.ExpectDone();
+      }
+      Exec(m_db, "PRAGMA " + schema + ".cache_size = -16384;");
+
+      // Attached archives are never migrated here; the UNION arms assume every archive has the current schema.
+      Sqlite::Statement version(m_db, ("PRAGMA " + schema + ".user_version;").c_str());
+      const int userVersion = version.Step() == SQLITE_ROW ? sqlite3_column_int(version.get(), 0) : 0;
+      if (userVersion != DB_SCHEMA_VERSION)
+        throw std::runtime_error("archive '" + archive.Name + "' has schema version " + std::to_string(userVersion) +
+                                 ", expected " + std::to_string(DB_SCHEMA_VERSION) + "; open it once without federation to migrate it");
+    }
+  }
+  catch (...)
+  {
+    sqlite3_close(m_db);
+    throw;
+  }
+}
+
+Federation::~Federation()
+{
+  if (m_db)
+    sqlite3_close(m_db);
+}
+
+void Federation::InspectFiles(const std::function<void(std::string_view archive, const InspectionRow &)> &visitor)
+{
+  std::string sql;
+  for (std::size_t i = 0; i < m_Archives.size(); ++i)
+  {
+    const auto schema = SchemaName(i);
+    if (i)
+      sql += " UNION ALL ";
+    sql += "SELECT f.relative_path, fv.version_number, b.status, "
+           "(SELECT COUNT(*) FROM " + schema + ".version_properties vp WHERE vp.version_id=fv.id), "
+           "(SELECT COUNT(*) FROM " + schema + ".version_relations vr WHERE vr.from_version_id=fv.id), " +
+           std::to_string(i) + ", f.id "
+           "FROM " + schema + ".files f JOIN " + schema + ".file_versions fv ON fv.id=f.current_version_id JOIN " + schema + ".blobs b ON b.id=fv.blob_id";
+  }
+  sql += " ORDER BY 6, 7;";
+
+  Sqlite::Statement statement(m_db, sql.c_str());
+  while (statement.Step() == SQLITE_ROW)
+    visitor(m_Archives[static_cast<std::size_t>(sqlite3_column_int64(statement.get(), 5))].Name,
+            InspectionRow{
+                .RelativePath = Detail::TextView(statement.get(), 0),
+                .VersionNumber = sqlite3_column_int64(statement.get(), 1),
+                .Status = static_cast<BlobStatus>(sqlite3_column_int(statement.get(), 2)),
+                .PropertyCount = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 3)),
+                .OutgoingRelationCount = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 4))});
+}
+
+void Federation::FindVersionsByProperty(const PropertyQuery &query, const std::function<void(std::string_view archive, const PropertyMatch &)> &visitor)
+{
+  // Each arm is the single-archive query, so it keeps its index seek; the ORDER BY then merges the sorted arms.
+  std::string sql;
+  for (std::size_t i = 0; i < m_Archives.size(); ++i)
+  {
+    if (i)
+      sql += " UNION ALL ";
+    sql += "SELECT q.*, " + std::to_string(i) + " FROM (" + Detail::PropertyQuerySelect(query, SchemaName(i)) + ") q";
+  }
+  sql += " ORDER BY 9, 8, 10;";
+
+  Sqlite::Statement statement(m_db, sql.c_str());
+  Detail::BindPropertyQuery(statement, query);
+  while (statement.Step() == SQLITE_ROW)
+    visitor(m_Archives[static_cast<std::size_t>(sqlite3_column_int64(statement.get(), 9))].Name,
+            PropertyMatch{
+                .FileId = sqlite3_column_int64(statement.get(), 6),
+                .VersionNumber = sqlite3_column_int64(statement.get(), 7),
+                .RelativePath = Detail::TextView(statement.get(), 8),
+                .Property = Detail::ReadVersionProperty(statement.get())});
+}
+
+void Federation::FindBlob(const Identity &hash, const std::function<void(std::string_view archive, const BlobUsage &)> &visitor)
+{
+  std::string sql;
+  for (std::size_t i = 0; i < m_Archives.size(); ++i)
+  {
+    const auto schema = SchemaName(i);
+    if (i)
+      sql += " UNION ALL ";
+    sql += "SELECT b.id, b.status, b.raw_size, b.stored_size, "
+           "(SELECT COUNT(*) FROM " + schema + ".file_versions fv WHERE fv.blob_id=b.id), " + std::to_string(i) +
+           " FROM " + schema + ".blobs b WHERE b.hash=?1";
+  }
+  sql += " ORDER BY 6;";
+
+  Sqlite::Statement statement(m_db, sql.c_str());
+  statement.BindBlob(1, hash.data(), static_cast<int>(hash.size()));
+  while (statement.Step() == SQLITE_ROW)
+  {
+    BlobUsage usage{
+        .BlobId = sqlite3_column_int64(statement.get(), 0),
+        .Status = static_cast<BlobStatus>(sqlite3_column_int(statement.get(), 1)),
+        .RawSize = std::nullopt,
+        .StoredSize = std::nullopt,
+        .VersionCount = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 4))};
+    if (sqlite3_column_type(statement.get(), 2) != SQLITE_NULL)
+      usage.RawSize = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 2));
+    if (sqlite3_column_type(statement.get(), 3) != SQLITE_NULL)
+      usage.StoredSize = static_cast<std::uint64_t>(sqlite3_column_int64(statement.get(), 3));
+    visitor(m_Archives[static_cast<std::size_t>(sqlite3_column_int64(statement.get(), 5))].Name, usage);
+  }
+}
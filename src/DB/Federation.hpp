@@ -0,0 +1,64 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Database.hpp"
+
+struct sqlite3;
+
+namespace Docmasys::DB
+{
+  /// @brief One archive of a Federation; @c Name labels its rows in every result.
+  struct FederatedArchive
+  {
+    std::string Name;
+    std::filesystem::path DatabaseFile;
+  };
+
+  /// @brief A blob of one federated archive, as reported by Federation::FindBlob.
+  struct BlobUsage
+  {
+    ID BlobId{};
+    BlobStatus Status{BlobStatus::Pending};
+    std::optional<std::uint64_t> RawSize;
+    std::optional<std::uint64_t> StoredSize;
+    /// @brief File versions of that archive whose content is the blob.
+    std::uint64_t VersionCount{};
+  };
+
+  /// @brief Read-only queries over several archive databases ATTACHed to one connection.
+  /// Every query is a single UNION ALL statement with one arm per archive, so it sees one snapshot of each archive;
+  /// visitors receive the name of the archive each row came from. SQLite limits how many databases can be attached (10 by default).
+  class Federation
+  {
+  public:
+    [[nodiscard]] static std::unique_ptr<Federation> Open(const std::vector<FederatedArchive> &archives)
+    {
+      return std::unique_ptr<Federation>(new Federation(archives));
+    }
+    ~Federation();
+
+    Federation(const Federation &) = delete;
+    Federation &operator=(const Federation &) = delete;
+
+    [[nodiscard]] const std::vector<FederatedArchive> &Archives() const noexcept { return m_Archives; }
+
+    /// @brief Database::InspectFiles across every archive, ordered by archive and file id.
+    void InspectFiles(const std::function<void(std::string_view archive, const InspectionRow &)> &visitor);
+    /// @brief Database::FindVersionsByProperty across every archive, ordered by path, version number and archive.
+    void FindVersionsByProperty(const PropertyQuery &query, const std::function<void(std::string_view archive, const PropertyMatch &)> &visitor);
+    /// @brief Reports every archive that stores @p hash, in archive order, from one unique-index probe per archive.
+    void FindBlob(const Identity &hash, const std::function<void(std::string_view archive, const BlobUsage &)> &visitor);
+
+  private:
+    explicit Federation(const std::vector<FederatedArchive> &archives);
+
+    sqlite3 *m_db = nullptr;
+    std::vector<FederatedArchive> m_Archives;
+  };
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "DB_Schema.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Docmasys::DB
+{
+  /// @brief Current or selected file with its version and blob, held by value.
+  /// RelativePath views text owned by the RowSet (or, in a streaming visitor, by the statement row).
+  struct MaterializedRow
+  {
+    ID FileId{};
+    std::optional<ID> ParentId;
+    ID VersionId{};
+    std::int64_t VersionNumber{};
+    ID BlobId{};
+    Identity Hash{};
+    BlobStatus Status{BlobStatus::Pending};
+    std::optional<int> CompressionLevel;
+    std::optional<std::uint64_t> RawSize;
+    std::optional<std::uint64_t> StoredSize;
+    std::string_view RelativePath;
+  };
+
+  /// @brief Workspace entry held by value; RelativePath is the workspace path, LogicalPath the vault path.
+  struct WorkspaceRow
+  {
+    ID FileId{};
+    ID VersionId{};
+    std::int64_t VersionNumber{};
+    ID BlobId{};
+    MaterializationKind Kind{MaterializationKind::ReadOnlyCopy};
+    std::string_view RelativePath;
+    std::string_view LogicalPath;
+  };
+
+  /// @brief Append-only text storage in 64 KiB blocks; stored views stay valid while the arena lives, including across moves.
+  class TextArena
+  {
+  public:
+    std::string_view Store(std::string_view text)
+    {
+      if (text.empty())
+        return {};
+      if (m_Blocks.empty() || m_Used + text.size() > m_BlockSize)
+      {
+        m_BlockSize = std::max(BLOCK_SIZE, text.size());
+        m_Blocks.push_back(std::make_unique_for_overwrite<char[]>(m_BlockSize));
+        m_Used = 0;
+      }
+      auto *target = m_Blocks.back().get() + m_Used;
+      std::memcpy(target, text.data(), text.size());
+      m_Used += text.size();
+      return {target, text.size()};
+    }
+
+  private:
+    static constexpr std::size_t BLOCK_SIZE = 64u << 10;
+    std::vector<std::unique_ptr<char[]>> m_Blocks;
+    std::size_t m_BlockSize{};
+    std::size_t m_Used{};
+  };
+
+  /// @brief Rows of a bulk query plus the arena their string views point into.
+  template <typename Row>
+  class RowSet
+  {
+  public:
+    [[nodiscard]] std::size_t size() const noexcept { return m_Rows.size(); }
+    [[nodiscard]] bool empty() const noexcept { return m_Rows.empty(); }
+    [[nodiscard]] const Row &operator[](std::size_t index) const noexcept { return m_Rows[index]; }
+    [[nodiscard]] auto begin() const noexcept { return m_Rows.begin(); }
+    [[nodiscard]] auto end() const noexcept { return m_Rows.end(); }
+
+    /// @brief Appends @p row, copying its string views into the arena.
+    void Add(Row row)
+    {
+      if constexpr (requires { row.LogicalPath; })
+        row.LogicalPath = m_Text.Store(row.LogicalPath);
+      row.RelativePath = m_Text.Store(row.RelativePath);
+      m_Rows.push_back(row);
+    }
+
+  private:
+    std::vector<Row> m_Rows;
+    TextArena m_Text;
+  };
+
+  /// @brief Hash, id and status of one blob, as held by a BlobIndex.
+  struct KnownBlob
+  {
+    Identity Hash{};
+    ID Id{};
+    BlobStatus Status{BlobStatus::Pending};
+  };
+
+  /// @brief Blobs of an archive keyed on hash, as loaded by Database::LoadBlobIndex.
+  /// Loaded blobs sit in one hash-sorted vector (48 bytes each) and are binary-searched; blobs added later go to a side map.
+  /// Pointers returned by Find stay valid while the index lives.
+  class BlobIndex
+  {
+  public:
+    BlobIndex() = default;
+    explicit BlobIndex(std::vector<KnownBlob> blobs) : m_Sorted(std::move(blobs))
+    {
+      std::sort(m_Sorted.begin(), m_Sorted.end(), [](const KnownBlob &left, const KnownBlob &right)
+                { return left.Hash < right.Hash; });
+    }
+
+    [[nodiscard]] KnownBlob *Find(const Identity &hash)
+    {
+      const auto it = std::lower_bound(m_Sorted.begin(), m_Sorted.end(), hash, [](const KnownBlob &blob, const Identity &value)
+                                       { return blob.Hash < value; });
+      if (it != m_Sorted.end() && it->Hash == hash)
+        return &*it;
+      const auto added = m_Added.find(hash);
+      return added == m_Added.end() ? nullptr : &added->second;
+    }
+
+    void Add(const KnownBlob &blob) { m_Added.insert_or_assign(blob.Hash, blob); }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_Sorted.size() + m_Added.size(); }
+
+  private:
+    /// @brief The hashes are SHA-256 digests, so their first bytes are already uniformly distributed.
+    struct IdentityHash
+    {
+      std::size_t operator()(const Identity &hash) const noexcept
+      {
+        std::size_t value;
+        std::memcpy(&value, hash.data(), sizeof(value));
+        return value;
+      }
+    };
+
+    std::vector<KnownBlob> m_Sorted;
+    std::unordered_map<Identity, KnownBlob, IdentityHash> m_Added;
+  };
+
+  using MaterializedRows = RowSet<MaterializedRow>;
+  using WorkspaceRows = RowSet<WorkspaceRow>;
+}
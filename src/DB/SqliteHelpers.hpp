@@ -6,41 +6,54 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 
 namespace Docmasys::DB::Sqlite
 {
+  /// @brief Per-connection statement bookkeeping, see Database::GetStatementStatistics.
+  struct StatementCounters
+  {
+    std::uint64_t Prepares{};
+    std::uint64_t CacheHits{};
+    std::uint64_t Steps{};
+  };
+
   class Statement
   {
   public:
-    Statement(sqlite3 *db, const char *sql) : m_Db(db)
+    Statement(sqlite3 *db, const char *sql, StatementCounters *counters = nullptr) : m_Db(db), m_Counters(counters)
     {
       if (sqlite3_prepare_v2(db, sql, -1, &m_Stmt, nullptr) != SQLITE_OK)
         throw std::runtime_error(sqlite3_errmsg(db));
+      if (m_Counters)
+        ++m_Counters->Prepares;
     }
 
-    ~Statement()
+    /// @brief Borrows a cached statement; on destruction it is reset and @p inUse cleared instead of finalized.
+    Statement(sqlite3 *db, sqlite3_stmt *cached, bool *inUse, StatementCounters *counters) noexcept
+        : m_Db(db), m_Stmt(cached), m_InUse(inUse), m_Counters(counters)
     {
-      if (m_Stmt)
-        sqlite3_finalize(m_Stmt);
+      *m_InUse = true;
     }
 
+    ~Statement() { Release(); }
+
     Statement(const Statement &) = delete;
     Statement &operator=(const Statement &) = delete;
-    Statement(Statement &&other) noexcept : m_Db(other.m_Db), m_Stmt(other.m_Stmt)
+    Statement(Statement &&other) noexcept
+        : m_Db(std::exchange(other.m_Db, nullptr)), m_Stmt(std::exchange(other.m_Stmt, nullptr)),
+          m_InUse(std::exchange(other.m_InUse, nullptr)), m_Counters(std::exchange(other.m_Counters, nullptr))
     {
-      other.m_Db = nullptr;
-      other.m_Stmt = nullptr;
     }
     Statement &operator=(Statement &&other) noexcept
     {
       if (this == &other)
         return *this;
-      if (m_Stmt)
-        sqlite3_finalize(m_Stmt);
-      m_Db = other.m_Db;
-      m_Stmt = other.m_Stmt;
-      other.m_Db = nullptr;
-      other.m_Stmt = nullptr;
+      Release();
+      m_Db = std::exchange(other.m_Db, nullptr);
+      m_Stmt = std::exchange(other.m_Stmt, nullptr);
+      m_InUse = std::exchange(other.m_InUse, nullptr);
+      m_Counters = std::exchange(other.m_Counters, nullptr);
       return *this;
     }
 
@@ -76,22 +89,43 @@ namespace Docmasys::DB::Sqlite
         throw std::runtime_error(sqlite3_errmsg(m_Db));
     }
 
-    [[nodiscard]] int Step() const noexcept { return sqlite3_step(m_Stmt); }
+    [[nodiscard]] int Step() const noexcept
+    {
+      if (m_Counters)
+        ++m_Counters->Steps;
+      return sqlite3_step(m_Stmt);
+    }
 
     void ExpectDone() const
     {
-      if (sqlite3_step(m_Stmt) != SQLITE_DONE)
+      if (Step() != SQLITE_DONE)
         throw std::runtime_error(sqlite3_errmsg(m_Db));
     }
 
     void ExpectRow() const
     {
-      if (sqlite3_step(m_Stmt) != SQLITE_ROW)
+      if (Step() != SQLITE_ROW)
         throw std::runtime_error(sqlite3_errmsg(m_Db));
     }
 
   private:
+    void Release() noexcept
+    {
+      if (!m_Stmt)
+        return;
+      if (m_InUse)
+      {
+        sqlite3_reset(m_Stmt);
+        sqlite3_clear_bindings(m_Stmt);
+        *m_InUse = false;
+      }
+      else
+        sqlite3_finalize(m_Stmt);
+    }
+
     sqlite3 *m_Db{};
     sqlite3_stmt *m_Stmt{};
+    bool *m_InUse{};
+    StatementCounters *m_Counters{};
   };
 }
@@ -2,6 +2,7 @@
 #include "CAS/CAS.hpp"
 #include "Common/PathUtils.hpp"
 
+#include <exception>
 #include <fstream>
 #include <regex>
 #include <system_error>
@@ -11,6 +12,16 @@ namespace fs = std::filesystem;
 
 namespace
 {
+/// @brief Files hashed per IdentifyMany call during push.
+constexpr size_t HASH_BATCH_FILES = 256;
+/// @brief Already-archived hashes a push resolves by lookup before it loads the whole blob index instead.
+constexpr size_t BLOB_INDEX_LOAD_HITS = 4 * HASH_BATCH_FILES;
+
+std::uint64_t ReadBytes(const CAS::IoCounters &counters)
+{
+  return counters.CachedReadBytes + counters.DroppedReadBytes + counters.DirectReadBytes;
+}
+
 void RemoveExistingPath(const fs::path &path)
 {
   std::error_code ec;
@@ -111,31 +122,135 @@ bool ShouldImportPath(const fs::path &root, const fs::path &path, const ImportOp
 }
 
 Vault::Vault(const fs::path &root, const fs::path &archive)
-    : m_Database(DB::Database::Open(archive / "content.db", root)),
+    : Vault(root, archive, VaultOptions{})
+{
+}
+
+Vault::Vault(const fs::path &root, const fs::path &archive, const VaultOptions &options)
+    : m_Database(DB::Database::Open(archive / "content.db", root, options.Storage)),
       m_LocalRoot(root),
       m_ArchiveRoot(archive),
-      m_Extensions(Extensions::ImportExtensionRegistry::BuiltIn())
+      m_Extensions(Extensions::ImportExtensionRegistry::BuiltIn()),
+      m_Options(options)
 {
 }
 
-void Vault::Push()
+ImportStatistics Vault::Push()
 {
-  Push(ImportOptions{});
+  return Push(ImportOptions{});
 }
 
-void Vault::Push(const ImportOptions &options)
+ImportStatistics Vault::Push(const ImportOptions &options)
 {
-  const auto statuses = Status();
-  for (const auto &status : statuses)
-  {
+  ForEachStatus([](const DB::WorkspaceEntryStatus &status)
+                {
     if (status.Entry.Kind == DB::MaterializationKind::CheckoutCopy)
-      continue;
+      return;
     if (status.State == DB::WorkspaceEntryState::Ok)
-      continue;
+      return;
     throw std::runtime_error("workspace contains tampered readonly file '" + status.Entry.RelativePath.generic_string() + "' (" +
                              (status.State == DB::WorkspaceEntryState::Missing ? "missing" : status.State == DB::WorkspaceEntryState::Modified ? "modified" : "replaced") +
-                             "); use repair or explicit checkout/checkin flow");
-  }
+                             "); use repair or explicit checkout/checkin flow"); });
+
+  ImportStatistics statistics;
+  CAS::CompressionTuner compression(options.Compression);
+  std::optional<DB::Database::Transaction> transaction;
+  std::size_t transactionFiles = 0;
+  auto transactionStart = std::chrono::steady_clock::now();
+  const auto commitTransaction = [&]
+  {
+    if (!transaction)
+      return;
+    transaction->Commit();
+    transaction.reset();
+    ++statistics.Transactions;
+  };
+
+  const auto finishFile = [&]
+  {
+    if (++transactionFiles >= options.BatchFiles || std::chrono::steady_clock::now() - transactionStart >= options.BatchInterval)
+      commitTransaction();
+  };
+
+  // Hashes of a hashing batch that are not in memory yet are inserted, or looked up when already archived, together
+  // before its files are imported. Only once a push keeps meeting archived content (a re-import) is the whole blob
+  // index loaded, so small pushes never pay for a scan of the archive.
+  DB::BlobIndex blobs;
+  bool blobIndexLoaded = false;
+  std::size_t archivedHits = 0;
+  const auto openTransaction = [&]
+  {
+    if (transaction)
+      return;
+    transaction.emplace(*m_Database);
+    transactionFiles = 0;
+    transactionStart = std::chrono::steady_clock::now();
+  };
+
+  std::vector<fs::path> batch;
+  const auto importBatch = [&]
+  {
+    // Hashing is the first read of each file, so it is what the tuner counts as input I/O; Store reads warm pages.
+    const auto readBefore = ReadBytes(CAS::GetIoCounters());
+    const auto identifyStart = std::chrono::steady_clock::now();
+    const auto identities = CAS::IdentifyMany(batch, m_Options.IoEngine, m_Options.IoMode);
+    compression.ObserveInput(ReadBytes(CAS::GetIoCounters()) - readBefore,
+                             std::chrono::duration<double>(std::chrono::steady_clock::now() - identifyStart).count());
+    if (!blobIndexLoaded && archivedHits >= BLOB_INDEX_LOAD_HITS)
+    {
+      blobs = m_Database->LoadBlobIndex();
+      blobIndexLoaded = true;
+    }
+
+    std::vector<Identity> unknown;
+    for (const auto &identity : identities)
+      if (!blobs.Find(identity))
+        unknown.push_back(identity);
+    if (!unknown.empty())
+    {
+      openTransaction();
+      for (const auto &blob : m_Database->InsertBlobs(unknown))
+      {
+        if (blob.Status != DB::BlobStatus::Pending)
+          ++archivedHits;
+        blobs.Add(blob);
+      }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      openTransaction();
+
+      const auto &path = batch[i];
+      auto &blob = *blobs.Find(identities[i]);
+      const auto import = m_Database->Import(path, blob);
+      if (blob.Status == DB::BlobStatus::Pending)
+      {
+        const auto stored = CAS::Store(m_Database->DatabaseFile().parent_path(), path, CAS::StoreOptions{.CompressionLevel = compression.Level(), .Mode = m_Options.IoMode});
+        compression.Observe(stored);
+        m_Database->MarkBlobStored(std::make_shared<DB::Blob>(blob.Id, blob.Hash, blob.Status),
+                                   DB::BlobStorageInfo{.CompressionLevel = stored.CompressionLevel, .RawSize = stored.RawBytes, .StoredSize = stored.StoredBytes});
+        blob.Status = DB::BlobStatus::Ready;
+        ++statistics.BlobsStored;
+        statistics.RawBytesStored += stored.RawBytes;
+        statistics.CompressedBytesStored += stored.StoredBytes;
+        ++statistics.BlobsByCompressionLevel[stored.CompressionLevel];
+      }
+      if (import.CreatedNewVersion)
+      {
+        ++statistics.VersionsCreated;
+        const auto file = m_Database->GetFileById(import.Version->FileId);
+        m_Extensions.Run(Extensions::ImportedVersionContext{
+            .Database = *m_Database,
+            .File = file,
+            .Version = import.Version,
+            .AbsolutePath = path,
+            .RelativePath = m_Database->BuildRelativePath(file)});
+      }
+      finishFile();
+    }
+    batch.clear();
+  };
 
   for (const auto &entry : fs::recursive_directory_iterator(m_LocalRoot))
   {
@@ -144,29 +259,68 @@ void Vault::Push(const ImportOptions &options)
     if (!ShouldImportPath(m_LocalRoot, entry.path(), options))
       continue;
 
-    const auto identity = CAS::Identify(entry.path());
-    const auto import = m_Database->Import(entry.path(), identity);
-    const auto blob = m_Database->GetBlob(import.Version->BlobId);
-    if (blob->Status == DB::BlobStatus::Pending)
-    {
-      static_cast<void>(CAS::Store(m_Database->DatabaseFile().parent_path(), entry.path()));
-      m_Database->UpdateBlobStatus(blob, DB::BlobStatus::Ready);
-    }
-    if (!import.CreatedNewVersion)
-      continue;
+    ++statistics.FilesScanned;
+    batch.push_back(entry.path());
+    if (batch.size() >= HASH_BATCH_FILES)
+      importBatch();
+  }
+  importBatch();
+  commitTransaction();
+  return statistics;
+}
 
-    const auto file = m_Database->GetFileById(import.Version->FileId);
-    m_Extensions.Run(Extensions::ImportedVersionContext{
-        .Database = *m_Database,
-        .File = file,
-        .Version = import.Version,
-        .AbsolutePath = entry.path(),
-        .RelativePath = m_Database->BuildRelativePath(file)});
+std::uint64_t Vault::PlannedBytes(const std::vector<DB::MaterializedFile> &files, DB::MaterializationKind kind) const
+{
+  if (kind == DB::MaterializationKind::ReadOnlySymlink)
+    return 0;
+
+  // An existing target is replaced by renaming over it, so only growth needs new space. Blobs without a recorded
+  // size (see blobs backfill-sizes) are not counted rather than decompressed up front.
+  std::uint64_t total = 0;
+  for (const auto &entry : files)
+  {
+    if (entry.BlobRef->Status != DB::BlobStatus::Ready || !entry.BlobRef->RawSize)
+      continue;
+    const auto size = *entry.BlobRef->RawSize;
+    const auto target = m_LocalRoot / Common::WorkspacePathFromVaultPath(entry.RelativePath);
+    std::error_code ec;
+    std::uintmax_t existing = 0;
+    if (fs::is_regular_file(target, ec))
+      existing = fs::file_size(target, ec);
+    if (ec)
+      existing = 0;
+    total += existing < size ? size - existing : 0;
   }
+  return total;
+}
+
+void Vault::EnsureDiskSpace(std::uint64_t required) const
+{
+  if (required == 0)
+    return;
+
+  fs::create_directories(m_LocalRoot);
+  std::error_code ec;
+  const auto space = fs::space(m_LocalRoot, ec);
+  if (!ec && space.available < required)
+    throw std::runtime_error("not enough disk space to materialize: " + std::to_string(required) + " bytes required, " + std::to_string(space.available) + " available");
 }
 
 void Vault::MaterializeFiles(const std::vector<DB::MaterializedFile> &files, DB::MaterializationKind kind)
 {
+  EnsureDiskSpace(PlannedBytes(files, kind));
+  const auto track = [&](const DB::MaterializedFile &entry)
+  {
+    const auto relative = Common::WorkspacePathFromVaultPath(entry.RelativePath);
+    if (kind == DB::MaterializationKind::ReadOnlyCopy)
+      SetReadOnly(m_LocalRoot / relative);
+    else if (kind == DB::MaterializationKind::CheckoutCopy)
+      SetWritable(m_LocalRoot / relative);
+    m_Database->UpsertWorkspaceEntry(m_LocalRoot, entry.LogicalFile, entry.Version, relative, kind);
+  };
+
+  std::vector<const DB::MaterializedFile *> copies;
+  std::vector<CAS::RetrieveRequest> retrievals;
   for (const auto &entry : files)
   {
     if (entry.BlobRef->Status != DB::BlobStatus::Ready)
@@ -175,43 +329,67 @@ void Vault::MaterializeFiles(const std::vector<DB::MaterializedFile> &files, DB:
     const auto relative = Common::WorkspacePathFromVaultPath(entry.RelativePath);
     const auto outPath = m_LocalRoot / relative;
     fs::create_directories(outPath.parent_path());
-    RemoveExistingPath(outPath);
 
     if (kind == DB::MaterializationKind::ReadOnlySymlink)
     {
+      RemoveExistingPath(outPath);
       const auto target = CAS::BlobPath(m_ArchiveRoot, entry.BlobRef->Hash);
       std::error_code ec;
       fs::create_symlink(target, outPath, ec);
       if (ec)
         throw std::runtime_error("failed to create symlink materialization for '" + relative.generic_string() + "': " + ec.message());
-    }
-    else
-    {
-      CAS::Retrieve(m_ArchiveRoot, entry.BlobRef->Hash, outPath);
-      if (kind == DB::MaterializationKind::ReadOnlyCopy)
-        SetReadOnly(outPath);
-      else
-        SetWritable(outPath);
+      track(entry);
+      continue;
     }
 
-    m_Database->UpsertWorkspaceEntry(m_LocalRoot, entry.LogicalFile, entry.Version, relative, kind);
+    // Copies replace the existing file only when the retrieved content is renamed over it, so a failed retrieval
+    // leaves the old file in place. Windows refuses to replace a read-only file, so its write bit is restored first.
+#ifdef _WIN32
+    if (fs::is_regular_file(outPath))
+      SetWritable(outPath);
+#endif
+    copies.push_back(&entry);
+    retrievals.push_back(CAS::RetrieveRequest{entry.BlobRef->Hash, outPath, CAS::RetrieveOptions{.ExpectedSize = entry.BlobRef->RawSize, .Mode = m_Options.IoMode, .Verify = m_Options.VerifyOnRead}});
+  }
+
+  // Files installed before a failure are tracked like any other, so the workspace never holds untracked archive content.
+  std::vector<std::size_t> installed;
+  installed.reserve(retrievals.size());
+  std::exception_ptr failure;
+  try
+  {
+    CAS::RetrieveMany(m_ArchiveRoot, retrievals, m_Options.IoEngine, [&](const CAS::RetrieveRequest &request)
+                      { installed.push_back(static_cast<std::size_t>(&request - retrievals.data())); });
   }
+  catch (...)
+  {
+    failure = std::current_exception();
+  }
+
+  for (const auto index : installed)
+    track(*copies[index]);
+  if (failure)
+    std::rethrow_exception(failure);
 }
 
-void Vault::MaterializeFolderTree(const DB::Folder &folder, const fs::path &localFolder, DB::MaterializationKind kind)
+void Vault::CollectFolderTree(const DB::Folder &folder, const fs::path &localFolder, std::vector<DB::MaterializedFile> &files)
 {
   fs::create_directories(localFolder);
   const auto folderRef = std::make_shared<DB::Folder>(folder);
-  MaterializeFiles(m_Database->GetMaterializedFiles(folderRef), kind);
+  auto folderFiles = m_Database->GetMaterializedFiles(folderRef);
+  files.insert(files.end(), std::make_move_iterator(folderFiles.begin()), std::make_move_iterator(folderFiles.end()));
   for (const auto &subfolder : m_Database->GetFolders(folderRef))
-    MaterializeFolderTree(*subfolder, localFolder / subfolder->Name, kind);
+    CollectFolderTree(*subfolder, localFolder / subfolder->Name, files);
 }
 
 void Vault::Pop()
 {
+  // The whole tree is one plan, so free space is checked once and retrievals batch across folders.
+  std::vector<DB::MaterializedFile> files;
   for (const auto &rootFolder : m_Database->GetFolders(nullptr))
     if (rootFolder->Name == "ROOT")
-      MaterializeFolderTree(*rootFolder, m_LocalRoot, DB::MaterializationKind::ReadOnlyCopy);
+      CollectFolderTree(*rootFolder, m_LocalRoot, files);
+  MaterializeFiles(files, DB::MaterializationKind::ReadOnlyCopy);
 }
 
 void Vault::Pop(const MaterializationOptions &options)
@@ -223,6 +401,27 @@ void Vault::Pop(const MaterializationOptions &options)
   MaterializeFiles(m_Database->ResolveMaterialization(version, options.RelationScope), options.Kind);
 }
 
+void Vault::Pop(const std::vector<MaterializationOptions> &requests)
+{
+  if (requests.empty())
+    return;
+
+  std::vector<DB::MaterializationRoot> roots;
+  for (const auto &request : requests)
+  {
+    if (request.Kind != requests.front().Kind)
+      throw std::runtime_error("all materialization requests must use the same kind");
+    const auto file = m_Database->GetFileByRelativePath(Common::RequireRootedVaultPath(request.RelativeFilePath));
+    roots.push_back({m_Database->GetFileVersion(file, request.VersionNumber)->Id, request.RelationScope});
+  }
+  MaterializeFiles(m_Database->ResolveMaterialization(roots), requests.front().Kind);
+}
+
+void Vault::PopBaseline(const std::string &name, DB::MaterializationKind kind)
+{
+  MaterializeFiles(m_Database->ResolveBaseline(name), kind);
+}
+
 void Vault::Checkout(const CheckoutOptions &options)
 {
   if (options.User.empty())
@@ -238,20 +437,53 @@ void Vault::Checkout(const CheckoutOptions &options)
   MaterializeFiles(m_Database->ResolveMaterialization(version, options.RelationScope), DB::MaterializationKind::CheckoutCopy);
 }
 
+void Vault::Checkout(const std::vector<CheckoutOptions> &requests)
+{
+  std::vector<std::pair<std::shared_ptr<DB::File>, std::shared_ptr<DB::FileVersion>>> locked;
+  std::vector<DB::MaterializationRoot> roots;
+  for (const auto &request : requests)
+  {
+    if (request.User.empty())
+      throw std::runtime_error("checkout requires user");
+    if (request.Environment.empty())
+      throw std::runtime_error("checkout requires environment");
+    const auto file = m_Database->GetFileByRelativePath(Common::RequireRootedVaultPath(request.RelativeFilePath));
+    const auto version = m_Database->GetFileVersion(file, request.VersionNumber);
+    locked.emplace_back(file, version);
+    roots.push_back({version->Id, request.RelationScope});
+  }
+
+  const auto plan = m_Database->ResolveMaterialization(roots);
+  {
+    DB::Database::Transaction transaction(*m_Database);
+    for (std::size_t i = 0; i < requests.size(); ++i)
+      m_Database->AcquireCheckoutLock(locked[i].first, locked[i].second, requests[i].User, requests[i].Environment, m_LocalRoot);
+    transaction.Commit();
+  }
+  MaterializeFiles(plan, DB::MaterializationKind::CheckoutCopy);
+}
+
 std::vector<DB::WorkspaceEntryStatus> Vault::Status() const
 {
-  return m_Database->GetWorkspaceStatus(m_LocalRoot);
+  return m_Database->GetWorkspaceStatus(m_LocalRoot, m_Options.IoEngine, m_Options.IoMode);
+}
+
+void Vault::ForEachStatus(const std::function<void(const DB::WorkspaceEntryStatus &)> &visitor) const
+{
+  m_Database->ForEachWorkspaceStatus(m_LocalRoot, m_Options.IoEngine, m_Options.IoMode, visitor);
 }
 
 void Vault::Repair()
 {
-  for (const auto &status : Status())
+  // Only damaged entries are kept; they are repaired after the scan so the workspace table is not rewritten mid-query.
+  std::vector<DB::WorkspaceEntryStatus> damaged;
+  ForEachStatus([&](const DB::WorkspaceEntryStatus &status)
+                {
+    if (status.State != DB::WorkspaceEntryState::Ok && status.Entry.Kind != DB::MaterializationKind::CheckoutCopy)
+      damaged.push_back(status); });
+
+  for (const auto &status : damaged)
   {
-    if (status.State == DB::WorkspaceEntryState::Ok)
-      continue;
-    if (status.Entry.Kind == DB::MaterializationKind::CheckoutCopy)
-      continue;
-
     MaterializeFiles({DB::MaterializedFile{
         .LogicalFile = status.Entry.LogicalFile,
         .Version = status.Entry.Version,
@@ -283,33 +515,31 @@ void Vault::Checkin(const CheckinOptions &options)
   if (lock->User != options.User || lock->Environment != options.Environment || fs::weakly_canonical(lock->WorkspaceRoot) != fs::weakly_canonical(m_LocalRoot))
     throw std::runtime_error("checkout lock is owned by a different user/environment/workspace");
 
-  const auto statuses = Status();
-  for (const auto &status : statuses)
-  {
-    if (status.Entry.LogicalFile->Id == file->Id)
-    {
-      if (status.State == DB::WorkspaceEntryState::Missing)
-        throw std::runtime_error("checked out file is missing from workspace");
-      if (status.State == DB::WorkspaceEntryState::Replaced)
-        throw std::runtime_error("checked out file was replaced unexpectedly");
-      break;
-    }
-  }
+  ForEachStatus([&](const DB::WorkspaceEntryStatus &status)
+                {
+    if (status.Entry.LogicalFile->Id != file->Id)
+      return;
+    if (status.State == DB::WorkspaceEntryState::Missing)
+      throw std::runtime_error("checked out file is missing from workspace");
+    if (status.State == DB::WorkspaceEntryState::Replaced)
+      throw std::runtime_error("checked out file was replaced unexpectedly"); });
 
   const auto fullPath = m_LocalRoot / Common::WorkspacePathFromVaultPath(relative);
-  const auto identity = CAS::Identify(fullPath);
+  const auto identity = CAS::Identify(fullPath, m_Options.IoMode);
+  DB::Database::Transaction transaction(*m_Database);
   const auto import = m_Database->Import(fullPath, identity);
   const auto blob = m_Database->GetBlob(import.Version->BlobId);
   if (blob->Status == DB::BlobStatus::Pending)
   {
-    static_cast<void>(CAS::Store(m_Database->DatabaseFile().parent_path(), fullPath));
-    m_Database->UpdateBlobStatus(blob, DB::BlobStatus::Ready);
+    const auto stored = CAS::Store(m_Database->DatabaseFile().parent_path(), fullPath, CAS::StoreOptions{.Mode = m_Options.IoMode});
+    m_Database->MarkBlobStored(blob, DB::BlobStorageInfo{.CompressionLevel = stored.CompressionLevel, .RawSize = stored.RawBytes, .StoredSize = stored.StoredBytes});
   }
 
   auto currentVersion = m_Database->GetFileVersion(file, std::nullopt);
   m_Database->UpsertWorkspaceEntry(m_LocalRoot, file, currentVersion, Common::WorkspacePathFromVaultPath(relative), DB::MaterializationKind::CheckoutCopy);
   if (options.ReleaseLock)
     m_Database->ReleaseCheckoutLock(file, options.User, options.Environment, m_LocalRoot);
+  transaction.Commit();
 }
 
 void Vault::Unlock(const fs::path &relativeFilePath)
@@ -319,3 +549,9 @@ void Vault::Unlock(const fs::path &relativeFilePath)
   if (!m_Database->ForceReleaseCheckoutLock(file))
     throw std::runtime_error("file was not locked");
 }
+
+void Vault::SaveSnapshot()
+{
+  if (m_Database->GetStorageMode() == DB::StorageMode::Memory)
+    m_Database->SaveSnapshot(m_Database->DatabaseFile());
+}
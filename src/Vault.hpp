@@ -1,7 +1,13 @@
 #pragma once
+#include "CAS/CAS.hpp"
+#include "CAS/IoEngine.hpp"
 #include "DB/Database.hpp"
 #include "Extensions/Extension.hpp"
+#include <chrono>
+#include <cstddef>
 #include <filesystem>
+#include <functional>
+#include <map>
 #include <optional>
 #include <vector>
 
@@ -36,29 +42,74 @@ namespace Docmasys
   {
     std::vector<std::string> IncludePatterns;
     std::vector<std::string> IgnorePatterns;
+    CAS::CompressionOptions Compression;
+    /// @brief Files committed per database transaction; a batch also closes once BatchInterval has passed.
+    /// A failed push keeps every batch committed before the failure, so rerunning it resumes where it stopped.
+    std::size_t BatchFiles{5000};
+    std::chrono::milliseconds BatchInterval{250};
+  };
+
+  struct ImportStatistics
+  {
+    std::size_t FilesScanned{};
+    std::size_t VersionsCreated{};
+    std::size_t BlobsStored{};
+    std::uint64_t RawBytesStored{};
+    std::uint64_t CompressedBytesStored{};
+    std::map<int, std::size_t> BlobsByCompressionLevel;
+    std::size_t Transactions{};
+  };
+
+  struct VaultOptions
+  {
+    /// @brief Engine for bulk hashing (push, status) and bulk retrieval (pop, checkout).
+    CAS::IoEngine IoEngine{CAS::IoEngine::Synchronous};
+    /// @brief Page-cache treatment of CAS reads and writes; Bulk keeps large runs from evicting the cache.
+    CAS::IoMode IoMode{CAS::IoMode::Cached};
+    /// @brief Check every retrieved file against its blob hash before it is installed.
+    bool VerifyOnRead{false};
+    /// @brief Memory keeps content.db in memory for throwaway archives; SaveSnapshot persists it.
+    DB::StorageMode Storage{DB::StorageMode::File};
   };
 
   class Vault
   {
   public:
     Vault(const std::filesystem::path &root, const std::filesystem::path &archive);
-    void Push();
-    void Push(const ImportOptions &options);
+    Vault(const std::filesystem::path &root, const std::filesystem::path &archive, const VaultOptions &options);
+    ImportStatistics Push();
+    ImportStatistics Push(const ImportOptions &options);
     void Pop();
     void Pop(const MaterializationOptions &options);
+    /// @brief Materializes all requests from one deduplicated plan, so shared dependencies are written once.
+    /// Requests must share one Kind; a cross-request version conflict fails before anything is written.
+    void Pop(const std::vector<MaterializationOptions> &requests);
+    /// @brief Materializes every file of a named baseline at its recorded version.
+    void PopBaseline(const std::string &name, DB::MaterializationKind kind);
     void Checkout(const CheckoutOptions &options);
+    /// @brief Locks every requested file, then materializes the union of their closures once; nothing is locked on a conflict.
+    void Checkout(const std::vector<CheckoutOptions> &requests);
     void Checkin(const CheckinOptions &options);
     std::vector<DB::WorkspaceEntryStatus> Status() const;
+    /// @brief Streams Status in workspace-path order without collecting it.
+    void ForEachStatus(const std::function<void(const DB::WorkspaceEntryStatus &)> &visitor) const;
     void Repair();
     void Unlock(const std::filesystem::path &relativeFilePath);
+    /// @brief Writes an in-memory archive database to content.db; file archives are always persisted, so this does nothing for them.
+    void SaveSnapshot();
 
   private:
+    void EnsureDiskSpace(std::uint64_t required) const;
+    /// @brief Free space materializing @p files needs beyond what their existing targets already occupy.
+    std::uint64_t PlannedBytes(const std::vector<DB::MaterializedFile> &files, DB::MaterializationKind kind) const;
     void MaterializeFiles(const std::vector<DB::MaterializedFile> &files, DB::MaterializationKind kind);
-    void MaterializeFolderTree(const DB::Folder &folder, const std::filesystem::path &localFolder, DB::MaterializationKind kind);
+    /// @brief Appends the current files below @p folder and creates its local folders, including empty ones.
+    void CollectFolderTree(const DB::Folder &folder, const std::filesystem::path &localFolder, std::vector<DB::MaterializedFile> &files);
 
     std::unique_ptr<DB::Database> m_Database;
     const std::filesystem::path m_LocalRoot;
     const std::filesystem::path m_ArchiveRoot;
     Extensions::ImportExtensionRegistry m_Extensions;
+    const VaultOptions m_Options;
   };
 }
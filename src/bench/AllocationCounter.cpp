@@ -0,0 +1,35 @@
+#include "Benchmarks.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions of the benchmark binary so runs can report heap allocation counts.
+
+namespace
+{
+  std::atomic<std::uint64_t> g_Allocations{0};
+}
+
+std::uint64_t Docmasys::Bench::AllocationCount() noexcept
+{
+  return g_Allocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size)
+{
+  g_Allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto *memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
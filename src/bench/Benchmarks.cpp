@@ -0,0 +1,73 @@
+#include "Benchmarks.hpp"
+
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+
+using namespace Docmasys::Bench;
+
+namespace
+{
+  using Benchmark = int (*)(const Arguments &);
+
+  const std::map<std::string, Benchmark> &Registry()
+  {
+    static const std::map<std::string, Benchmark> registry{
+        {"db-import", &RunDbImportBenchmark},
+        {"db-readers", &RunDbReadersBenchmark},
+        {"db-relations", &RunDbRelationsBenchmark},
+        {"db-rows", &RunDbRowsBenchmark},
+        {"db-search", &RunDbSearchBenchmark},
+        {"io-engine", &RunIoEngineBenchmark},
+        {"io-mode", &RunIoModeBenchmark},
+        {"verify", &RunVerifyBenchmark},
+    };
+    return registry;
+  }
+
+  void PrintUsage(const std::string &programName)
+  {
+    std::cout << "Usage: " << programName << " <benchmark> [--<name> <value>]...\n\nBenchmarks:\n";
+    for (const auto &[name, _] : Registry())
+      std::cout << "  " << name << "\n";
+  }
+}
+
+std::size_t Docmasys::Bench::SizeArgument(const Arguments &arguments, const std::string &name, std::size_t fallback)
+{
+  const auto it = arguments.find(name);
+  return it == arguments.end() ? fallback : static_cast<std::size_t>(std::stoull(it->second));
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    if (argc < 2)
+    {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+
+    const auto benchmark = Registry().find(argv[1]);
+    if (benchmark == Registry().end())
+      throw std::runtime_error(std::string("unknown benchmark: ") + argv[1]);
+
+    Arguments arguments;
+    for (int i = 2; i < argc; i += 2)
+    {
+      const std::string_view key = argv[i];
+      if (!key.starts_with("--") || i + 1 >= argc)
+        throw std::runtime_error("expected --<name> <value> pairs");
+      arguments[std::string(key.substr(2))] = argv[i + 1];
+    }
+    return benchmark->second(arguments);
+  }
+  catch (const std::exception &ex)
+  {
+    std::cerr << "error: " << ex.what() << "\n";
+    return 1;
+  }
+}
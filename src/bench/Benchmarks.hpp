@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "../Types.hpp"
+
+namespace Docmasys::Bench
+{
+  using Arguments = std::unordered_map<std::string, std::string>;
+
+  /// @brief Integer argument `--name <value>` or @p fallback.
+  std::size_t SizeArgument(const Arguments &arguments, const std::string &name, std::size_t fallback);
+
+  /// @brief Global operator new calls since the benchmark binary started.
+  std::uint64_t AllocationCount() noexcept;
+
+  /// @brief Seconds spent in @p work.
+  inline double Measure(const std::function<void()> &work)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// @brief Distinct content hash for synthetic row @p value: its bytes, little-endian, then zeros.
+  inline Identity IdentityOf(std::size_t value)
+  {
+    Identity hash{};
+    for (std::size_t byte = 0; byte < sizeof(value); ++byte)
+      hash[byte] = static_cast<std::uint8_t>(value >> (8 * byte));
+    return hash;
+  }
+
+  int RunDbImportBenchmark(const Arguments &arguments);
+  int RunDbReadersBenchmark(const Arguments &arguments);
+  int RunDbRelationsBenchmark(const Arguments &arguments);
+  int RunDbRowsBenchmark(const Arguments &arguments);
+  int RunDbSearchBenchmark(const Arguments &arguments);
+  int RunIoEngineBenchmark(const Arguments &arguments);
+  int RunIoModeBenchmark(const Arguments &arguments);
+  int RunVerifyBenchmark(const Arguments &arguments);
+}
@@ -0,0 +1,88 @@
+#include "Benchmarks.hpp"
+
+#include "../DB/Database.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+/// @brief Imports synthetic paths straight into the database, imports them again unchanged, then lists them back
+/// with their paths; reports throughput and statement activity.
+/// Arguments: --files <n> (default 10000), --folders <n> (default 100), --depth <n> folder levels (default 1),
+/// --batch <n> files per transaction (default 1, i.e. one commit per import),
+/// --known-blobs 1 resolves blobs through a preloaded BlobIndex with batched inserts, as Vault::Push does once a re-import is detected,
+/// --in-memory 1 keeps the database in memory; the run ends by saving a snapshot to disk in either mode.
+int Docmasys::Bench::RunDbImportBenchmark(const Arguments &arguments)
+{
+  constexpr std::size_t HASH_BATCH_FILES = 256;
+  const auto files = std::max<std::size_t>(SizeArgument(arguments, "files", 10000), 1);
+  const auto folders = std::max<std::size_t>(SizeArgument(arguments, "folders", 100), 1);
+  const auto batch = std::max<std::size_t>(SizeArgument(arguments, "batch", 1), 1);
+  const auto depth = std::max<std::size_t>(SizeArgument(arguments, "depth", 1), 1);
+  const bool knownBlobs = SizeArgument(arguments, "known-blobs", 0) != 0;
+  const auto storage = SizeArgument(arguments, "in-memory", 0) != 0 ? DB::StorageMode::Memory : DB::StorageMode::File;
+
+  Tests::TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  fs::create_directories(vaultRoot);
+  auto db = DB::Database::Open(td.dir / "content.db", vaultRoot, storage);
+
+  const auto importAll = [&]
+  {
+    std::optional<DB::BlobIndex> blobs;
+    if (knownBlobs)
+      blobs = db->LoadBlobIndex();
+    std::optional<DB::Database::Transaction> transaction;
+    for (std::size_t i = 0; i < files; ++i)
+    {
+      if (batch > 1 && !transaction)
+        transaction.emplace(*db);
+      if (blobs && i % HASH_BATCH_FILES == 0)
+      {
+        std::vector<Identity> unknown;
+        for (std::size_t next = i; next < std::min(files, i + HASH_BATCH_FILES); ++next)
+          if (!blobs->Find(IdentityOf(next)))
+            unknown.push_back(IdentityOf(next));
+        if (!unknown.empty())
+          for (const auto &blob : db->InsertBlobs(unknown))
+            blobs->Add(blob);
+      }
+      auto folder = vaultRoot;
+      for (std::size_t level = 0; level < depth; ++level)
+        folder /= "dir" + std::to_string(i % folders);
+      const auto path = folder / ("file" + std::to_string(i) + ".bin");
+      if (blobs)
+        db->Import(path, *blobs->Find(IdentityOf(i)));
+      else
+        db->Import(path, IdentityOf(i));
+      if (transaction && ((i + 1) % batch == 0 || i + 1 == files))
+      {
+        transaction->Commit();
+        transaction.reset();
+      }
+    }
+  };
+
+  const auto seconds = Measure(importAll);
+  const auto statistics = db->GetStatementStatistics();
+  const auto reimportSeconds = Measure(importAll);
+  std::size_t listed = 0;
+  const auto inspectSeconds = Measure([&]
+                                      { listed = db->InspectCurrentFiles().size(); });
+  const auto snapshotSeconds = Measure([&]
+                                       { db->SaveSnapshot(td.dir / "snapshot.db"); });
+  std::cout << "files\tseconds\tfiles_per_second\tprepares\tcache_hits\tsteps\treimport_seconds\tinspect_seconds\tsnapshot_seconds\n"
+            << files << '\t' << seconds << '\t' << static_cast<double>(files) / seconds << '\t'
+            << statistics.Prepares << '\t' << statistics.CacheHits << '\t' << statistics.Steps << '\t'
+            << reimportSeconds << '\t' << inspectSeconds << '\t' << snapshotSeconds << "\n";
+  if (listed != files)
+    throw std::runtime_error("inspect listed " + std::to_string(listed) + " files");
+  return 0;
+}
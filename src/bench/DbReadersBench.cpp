@@ -0,0 +1,88 @@
+#include "Benchmarks.hpp"
+
+#include "../DB/Database.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+namespace
+{
+  fs::path RelativeOf(std::size_t index)
+  {
+    return fs::path("dir" + std::to_string(index % 100)) / ("file" + std::to_string(index) + ".bin");
+  }
+}
+
+/// @brief Path lookups per second through pooled read sessions at increasing thread counts,
+/// while the writer connection keeps importing in small transactions.
+/// Arguments: --files <n> (default 20000), --lookups <n> per thread (default 20000), --threads <max> (default hardware threads).
+int Docmasys::Bench::RunDbReadersBenchmark(const Arguments &arguments)
+{
+  const auto files = std::max<std::size_t>(SizeArgument(arguments, "files", 20000), 1);
+  const auto lookups = std::max<std::size_t>(SizeArgument(arguments, "lookups", 20000), 1);
+  const auto maxThreads = std::max<std::size_t>(SizeArgument(arguments, "threads", std::max(1u, std::thread::hardware_concurrency())), 1);
+
+  Tests::TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = DB::Database::Open(td.dir / "content.db", vaultRoot);
+  {
+    DB::Database::Transaction transaction(*db);
+    for (std::size_t i = 0; i < files; ++i)
+      db->Import(vaultRoot / RelativeOf(i), IdentityOf(i));
+    transaction.Commit();
+  }
+
+  std::cout << "threads\tseconds\tlookups_per_second\twriter_imports\n";
+  std::size_t nextImport = files;
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    std::atomic<std::size_t> running{threads};
+    std::mutex errorMutex;
+    std::string error;
+    std::size_t imports = 0;
+    const auto seconds = Measure([&]
+                                 {
+      std::vector<std::thread> readers;
+      for (std::size_t t = 0; t < threads; ++t)
+        readers.emplace_back([&, t]
+                             {
+          try
+          {
+            auto session = db->OpenReadSession();
+            for (std::size_t i = 0; i < lookups; ++i)
+              (void)session->GetFileByRelativePath("ROOT" / RelativeOf((i * 7919 + t) % files));
+          }
+          catch (const std::exception &ex)
+          {
+            std::lock_guard lock(errorMutex);
+            error = ex.what();
+          }
+          --running; });
+
+      while (running > 0)
+      {
+        DB::Database::Transaction transaction(*db);
+        db->Import(vaultRoot / RelativeOf(nextImport), IdentityOf(nextImport));
+        transaction.Commit();
+        ++nextImport;
+        ++imports;
+      }
+      for (auto &reader : readers)
+        reader.join(); });
+    if (!error.empty())
+      throw std::runtime_error("reader failed: " + error);
+
+    std::cout << threads << '\t' << seconds << '\t' << static_cast<double>(threads * lookups) / seconds << '\t' << imports << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "Benchmarks.hpp"
+
+#include "../DB/Database.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sqlite3.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+namespace
+{
+  /// @brief The recursive cycle check that guarded version_relations before the maintained topological order.
+  constexpr const char *CYCLE_TRIGGER = R"SQL(
+    CREATE TRIGGER trg_version_relations_no_cycle BEFORE INSERT ON version_relations FOR EACH ROW WHEN EXISTS (WITH RECURSIVE reach(id) AS (SELECT NEW.to_version_id UNION SELECT vr.to_version_id FROM version_relations vr JOIN reach ON vr.from_version_id = reach.id) SELECT 1 FROM reach WHERE id = NEW.from_version_id) BEGIN SELECT RAISE(ABORT, 'version relation cycle detected'); END;
+  )SQL";
+
+  std::vector<std::shared_ptr<DB::FileVersion>> ImportVersions(DB::Database &db, const fs::path &vaultRoot, std::size_t count)
+  {
+    std::vector<std::shared_ptr<DB::FileVersion>> versions;
+    DB::Database::Transaction transaction(db);
+    for (std::size_t i = 0; i < count; ++i)
+      versions.push_back(db.Import(vaultRoot / ("dir" + std::to_string(i % 100)) / ("file" + std::to_string(i) + ".bin"), Bench::IdentityOf(i)).Version);
+    transaction.Commit();
+    return versions;
+  }
+
+  void Exec(sqlite3 *db, const char *sql)
+  {
+    if (sqlite3_exec(db, sql, nullptr, nullptr, nullptr) != SQLITE_OK)
+      throw std::runtime_error(sqlite3_errmsg(db));
+  }
+}
+
+/// @brief Edge inserts per second with the incremental topological order against the old recursive trigger,
+/// plus where-used closures over the resulting graph.
+/// Edges join versions of a hidden random order within a window, so the graph is a deep DAG. They are inserted
+/// shuffled, or bottom-up (dependencies before the versions that use them, as a layered import would).
+/// Arguments: --versions <n> (default 20000), --edges <n> (default 60000), --window <n> (default 50),
+/// --order shuffled|bottom-up (default shuffled).
+int Docmasys::Bench::RunDbRelationsBenchmark(const Arguments &arguments)
+{
+  const auto versionCount = std::max<std::size_t>(SizeArgument(arguments, "versions", 20000), 2);
+  const auto edgeCount = std::max<std::size_t>(SizeArgument(arguments, "edges", 60000), 1);
+  const auto window = std::max<std::size_t>(SizeArgument(arguments, "window", 50), 1);
+  const auto orderArgument = arguments.find("order");
+  const std::string insertOrder = orderArgument == arguments.end() ? "shuffled" : orderArgument->second;
+
+  std::mt19937_64 random(42);
+  std::vector<std::size_t> order(versionCount);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), random);
+  std::vector<std::pair<std::size_t, std::size_t>> ranks;
+  for (std::size_t i = 0; ranks.size() < edgeCount; ++i)
+  {
+    const auto from = i % (versionCount - 1);
+    ranks.emplace_back(from, std::min(versionCount - 1, from + 1 + random() % window));
+  }
+  if (insertOrder == "shuffled")
+    std::shuffle(ranks.begin(), ranks.end(), random);
+  else if (insertOrder == "bottom-up")
+    std::sort(ranks.begin(), ranks.end(), std::greater<>());
+  else
+    throw std::runtime_error("--order must be shuffled or bottom-up");
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  for (const auto &[from, to] : ranks)
+    edges.emplace_back(order[from], order[to]);
+
+  std::cout << "method\tedges\tseconds\tedges_per_second\n";
+  const auto report = [&](const char *method, double seconds)
+  {
+    std::cout << method << '\t' << edges.size() << '\t' << seconds << '\t' << static_cast<double>(edges.size()) / seconds << "\n";
+  };
+
+  {
+    Tests::TempDir td;
+    auto db = DB::Database::Open(td.dir / "content.db", td.dir / "vault");
+    const auto versions = ImportVersions(*db, td.dir / "vault", versionCount);
+    report("topological-order", Measure([&]
+                                        {
+      DB::Database::Transaction transaction(*db);
+      for (const auto &[from, to] : edges)
+        db->AddRelation(versions[from], versions[to], DB::RelationType::Strong);
+      transaction.Commit(); }));
+
+    // Reverse closure from the deepest versions, which every version upstream of them depends on.
+    std::size_t users = 0;
+    const std::size_t queries = 20;
+    const auto seconds = Measure([&]
+                                 {
+      for (std::size_t q = 0; q < queries; ++q)
+        db->ForEachWhereUsed(versions[order[versionCount - 1 - q]]->Id, DB::RelationScope::All, std::nullopt, [&](const DB::WhereUsedRow &) { ++users; }); });
+    std::cout << "where-used\t" << users / queries << " users/query\t" << seconds / queries << '\t' << static_cast<double>(users) / seconds << " users/s\n";
+  }
+
+  {
+    Tests::TempDir td;
+    std::vector<std::shared_ptr<DB::FileVersion>> versions;
+    {
+      auto db = DB::Database::Open(td.dir / "content.db", td.dir / "vault");
+      versions = ImportVersions(*db, td.dir / "vault", versionCount);
+    }
+    sqlite3 *raw = nullptr;
+    sqlite3_stmt *insert = nullptr;
+    if (sqlite3_open((td.dir / "content.db").string().c_str(), &raw) != SQLITE_OK)
+      throw std::runtime_error("SQLite open failed");
+    Exec(raw, CYCLE_TRIGGER);
+    sqlite3_prepare_v2(raw, "INSERT OR IGNORE INTO version_relations(from_version_id,to_version_id,relation_type) VALUES(?1,?2,0);", -1, &insert, nullptr);
+    report("recursive-trigger", Measure([&]
+                                        {
+      Exec(raw, "BEGIN IMMEDIATE;");
+      for (const auto &[from, to] : edges)
+      {
+        sqlite3_bind_int64(insert, 1, versions[from]->Id);
+        sqlite3_bind_int64(insert, 2, versions[to]->Id);
+        if (sqlite3_step(insert) != SQLITE_DONE)
+          throw std::runtime_error(sqlite3_errmsg(raw));
+        sqlite3_reset(insert);
+      }
+      Exec(raw, "COMMIT;"); }));
+    sqlite3_finalize(insert);
+    sqlite3_close(raw);
+  }
+  return 0;
+}
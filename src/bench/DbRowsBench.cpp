@@ -0,0 +1,62 @@
+#include "Benchmarks.hpp"
+
+#include "../DB/Database.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+namespace
+{
+  template <typename Work>
+  void Report(const std::string &name, Work &&work)
+  {
+    std::size_t rows = 0;
+    const auto before = Docmasys::Bench::AllocationCount();
+    const auto seconds = Docmasys::Bench::Measure([&]
+                                                  { rows = work(); });
+    const auto allocations = Docmasys::Bench::AllocationCount() - before;
+    std::cout << name << '\t' << rows << '\t' << seconds << '\t' << allocations << '\t'
+              << static_cast<double>(allocations) / static_cast<double>(std::max<std::size_t>(rows, 1)) << "\n";
+  }
+}
+
+/// @brief Heap allocations and time of the shared_ptr listings against their value-row counterparts.
+/// Arguments: --files <n> (default 50000), --depth <n> folder levels (default 4).
+int Docmasys::Bench::RunDbRowsBenchmark(const Arguments &arguments)
+{
+  const auto files = std::max<std::size_t>(SizeArgument(arguments, "files", 50000), 1);
+  const auto depth = std::max<std::size_t>(SizeArgument(arguments, "depth", 4), 1);
+
+  Tests::TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  const auto workspace = td.dir / "workspace";
+  auto db = DB::Database::Open(td.dir / "content.db", vaultRoot);
+  {
+    DB::Database::Transaction transaction(*db);
+    for (std::size_t i = 0; i < files; ++i)
+    {
+      auto folder = vaultRoot;
+      for (std::size_t level = 0; level < depth; ++level)
+        folder /= "directory" + std::to_string(i % 100);
+      const auto version = db->Import(folder / ("file" + std::to_string(i) + ".bin"), IdentityOf(i)).Version;
+      db->UpsertWorkspaceEntry(workspace, db->GetFileById(version->FileId), version, fs::relative(folder, vaultRoot) / ("file" + std::to_string(i) + ".bin"), DB::MaterializationKind::ReadOnlyCopy);
+    }
+    transaction.Commit();
+  }
+
+  std::cout << "api\trows\tseconds\tallocations\tallocations_per_row\n";
+  Report("InspectCurrentFiles", [&]
+         { return db->InspectCurrentFiles().size(); });
+  Report("InspectCurrentFileRows", [&]
+         { return db->InspectCurrentFileRows().size(); });
+  Report("ListWorkspaceEntries", [&]
+         { return db->ListWorkspaceEntries(workspace).size(); });
+  Report("ListWorkspaceEntryRows", [&]
+         { return db->ListWorkspaceEntryRows(workspace).size(); });
+  return 0;
+}
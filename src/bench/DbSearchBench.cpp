@@ -0,0 +1,98 @@
+#include "Benchmarks.hpp"
+
+#include "../DB/Database.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sqlite3.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+namespace
+{
+  constexpr std::size_t VOCABULARY = 50000;
+
+  std::string WordOf(std::uint64_t seed)
+  {
+    return "w" + std::to_string((seed * 2654435761u) % VOCABULARY);
+  }
+
+  /// @brief Substring scan over the same text, as a search without the index has to do it.
+  std::size_t ScanCount(const fs::path &databaseFile, const std::string &word)
+  {
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *statement = nullptr;
+    if (sqlite3_open_v2(databaseFile.string().c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM version_properties WHERE string_value LIKE ?1;", -1, &statement, nullptr) != SQLITE_OK)
+    {
+      sqlite3_close(db);
+      throw std::runtime_error("scan query failed");
+    }
+    const auto pattern = "% " + word + " %";
+    sqlite3_bind_text(statement, 1, pattern.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_step(statement);
+    const auto count = static_cast<std::size_t>(sqlite3_column_int64(statement, 0));
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    return count;
+  }
+}
+
+/// @brief Full-text search latency against a substring scan on an archive of string properties.
+/// Arguments: --properties <n> (default 1000000), --per-version <n> properties per file (default 10),
+/// --queries <n> (default 20).
+int Docmasys::Bench::RunDbSearchBenchmark(const Arguments &arguments)
+{
+  const auto properties = std::max<std::size_t>(SizeArgument(arguments, "properties", 1000000), 1);
+  const auto perVersion = std::max<std::size_t>(SizeArgument(arguments, "per-version", 10), 1);
+  const auto queries = std::max<std::size_t>(SizeArgument(arguments, "queries", 20), 1);
+
+  Tests::TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  const auto databaseFile = td.dir / "content.db";
+  auto db = DB::Database::Open(databaseFile, vaultRoot);
+  if (!db->HasFullTextIndex())
+    std::cout << "note\tSQLite has no FTS5; search falls back to a scan\n";
+
+  const auto populateSeconds = Measure([&]
+                                       {
+    DB::Database::Transaction transaction(*db);
+    for (std::size_t file = 0; file * perVersion < properties; ++file)
+    {
+      const auto version = db->Import(vaultRoot / ("dir" + std::to_string(file % 100)) / ("file" + std::to_string(file) + ".bin"), IdentityOf(file)).Version;
+      for (std::size_t p = 0; p < perVersion && file * perVersion + p < properties; ++p)
+      {
+        const auto seed = file * perVersion + p;
+        db->SetVersionProperty(version, "field" + std::to_string(p),
+                               "part " + WordOf(seed) + " " + WordOf(seed + properties) + " " + WordOf(seed + 2 * properties) + " rev");
+      }
+    }
+    transaction.Commit(); });
+
+  std::vector<std::string> words;
+  for (std::size_t q = 0; q < queries; ++q)
+    words.push_back(WordOf(q * 7919));
+
+  std::size_t searchHits = 0;
+  const auto searchSeconds = Measure([&]
+                                     {
+    for (const auto &word : words)
+      db->SearchText(word, {.Limit = properties}, [&](const DB::TextSearchHit &) { ++searchHits; }); });
+
+  std::size_t scanHits = 0;
+  const auto scanSeconds = Measure([&]
+                                   {
+    for (const auto &word : words)
+      scanHits += ScanCount(databaseFile, word); });
+
+  std::cout << "properties\tpopulate_seconds\tqueries\tsearch_ms_per_query\tsearch_hits\tscan_ms_per_query\tscan_hits\n"
+            << properties << '\t' << populateSeconds << '\t' << queries << '\t'
+            << searchSeconds * 1000.0 / static_cast<double>(queries) << '\t' << searchHits << '\t'
+            << scanSeconds * 1000.0 / static_cast<double>(queries) << '\t' << scanHits << "\n";
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include "Benchmarks.hpp"
+
+#include "../CAS/CAS.hpp"
+#include "../CAS/IoEngine.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+namespace
+{
+  std::string Content(std::size_t index, std::size_t size)
+  {
+    // Half random, half repeated: compresses roughly like typical documents.
+    std::mt19937_64 rng{index};
+    std::string data(size, '\0');
+    for (std::size_t i = 0; i < size; ++i)
+      data[i] = i < size / 2 ? static_cast<char>(rng() & 0xFF) : static_cast<char>('a' + i % 23);
+    return data;
+  }
+
+  const char *Name(CAS::IoEngine engine)
+  {
+    return engine == CAS::IoEngine::IoUring ? "io_uring" : "sync";
+  }
+}
+
+/// @brief Hashes and retrieves many small files with each engine.
+/// Arguments: --files <count> (default 5000), --size <bytes> (default 8192).
+int Docmasys::Bench::RunIoEngineBenchmark(const Arguments &arguments)
+{
+  const auto fileCount = SizeArgument(arguments, "files", 5000);
+  const auto fileSize = SizeArgument(arguments, "size", 8192);
+
+  Tests::TempDir td;
+  std::vector<fs::path> files;
+  std::vector<CAS::RetrieveRequest> requests;
+  for (std::size_t i = 0; i < fileCount; ++i)
+  {
+    const auto file = td.dir / "source" / std::to_string(i % 64) / (std::to_string(i) + ".bin");
+    Tests::WriteFile(file, Content(i, fileSize));
+    files.push_back(file);
+    const auto stored = CAS::Store(td.dir / "archive", file, CAS::StoreOptions{});
+    requests.push_back({stored.Hash, {}, CAS::RetrieveOptions{.ExpectedSize = stored.RawBytes}});
+  }
+
+  std::cout << "io_uring_available\t" << (CAS::IoUringAvailable() ? "true" : "false") << "\n";
+  std::cout << "engine\toperation\tfiles\tseconds\tfiles_per_second\n";
+  for (const auto engine : {CAS::IoEngine::Synchronous, CAS::IoEngine::IoUring})
+  {
+    const auto identify = Measure([&]
+                                  { static_cast<void>(CAS::IdentifyMany(files, engine)); });
+
+    const auto outDir = td.dir / Name(engine);
+    for (std::size_t i = 0; i < requests.size(); ++i)
+      requests[i].OutFile = outDir / std::to_string(i % 64) / (std::to_string(i) + ".bin");
+    const auto retrieve = Measure([&]
+                                  { CAS::RetrieveMany(td.dir / "archive", requests, engine); });
+
+    std::cout << Name(engine) << "\tidentify\t" << fileCount << '\t' << identify << '\t' << static_cast<double>(fileCount) / identify << "\n";
+    std::cout << Name(engine) << "\tretrieve\t" << fileCount << '\t' << retrieve << '\t' << static_cast<double>(fileCount) / retrieve << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "Benchmarks.hpp"
+
+#include "../CAS/CAS.hpp"
+#include "../tests/TestSupport.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace Docmasys;
+
+namespace
+{
+  /// @brief Share of @p file currently held in the page cache, or -1 where mincore is unavailable.
+  double ResidentFraction(const fs::path &file)
+  {
+#ifdef __linux__
+    const auto size = fs::file_size(file);
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || size == 0)
+    {
+      if (fd >= 0)
+        ::close(fd);
+      return -1;
+    }
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+      return -1;
+
+    const auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> pages((size + pageSize - 1) / pageSize);
+    std::size_t resident = 0;
+    if (::mincore(mapping, size, pages.data()) == 0)
+      for (const auto page : pages)
+        resident += page & 1;
+    ::munmap(mapping, size);
+    return static_cast<double>(resident) / static_cast<double>(pages.size());
+#else
+    static_cast<void>(file);
+    return -1;
+#endif
+  }
+
+  const char *Name(CAS::IoMode mode)
+  {
+    return mode == CAS::IoMode::Direct ? "direct" : mode == CAS::IoMode::Bulk ? "bulk" : "cached";
+  }
+}
+
+/// @brief Stores and retrieves one large file per I/O mode and reports throughput and page-cache residency.
+/// Arguments: --size-mb <MiB> (default 256).
+int Docmasys::Bench::RunIoModeBenchmark(const Arguments &arguments)
+{
+  const auto size = SizeArgument(arguments, "size-mb", 256) << 20;
+
+  Tests::TempDir td;
+  const auto source = td.dir / "source.bin";
+  {
+    std::mt19937_64 rng{42};
+    std::vector<char> block(1u << 20);
+    std::ofstream out(source, std::ios::binary);
+    for (std::size_t written = 0; written < size; written += block.size())
+    {
+      for (std::size_t i = 0; i < block.size(); i += 2)
+        block[i] = static_cast<char>(rng() & 0xFF); // every other byte random: compresses to about 60%
+      out.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), size - written)));
+    }
+  }
+
+  std::cout << "mode\tstore_seconds\tretrieve_seconds\tsource_resident\tobject_resident\toutput_resident\tread_cached\tread_dropped\tread_direct\twrite_cached\twrite_dropped\twrite_direct\n";
+  for (const auto mode : {CAS::IoMode::Cached, CAS::IoMode::Bulk, CAS::IoMode::Direct})
+  {
+    CAS::ResetIoCounters();
+    const auto archive = td.dir / Name(mode);
+    const auto output = td.dir / (std::string(Name(mode)) + ".out");
+
+    CAS::StoreResult stored;
+    const auto store = Measure([&]
+                               { stored = CAS::Store(archive, source, CAS::StoreOptions{.Mode = mode}); });
+    const auto retrieve = Measure([&]
+                                  { CAS::Retrieve(archive, stored.Hash, output, CAS::RetrieveOptions{.ExpectedSize = stored.RawBytes, .Mode = mode}); });
+
+    const auto io = CAS::GetIoCounters();
+    std::cout << Name(mode) << '\t' << store << '\t' << retrieve << '\t'
+              << ResidentFraction(source) << '\t' << ResidentFraction(CAS::BlobPath(archive, stored.Hash)) << '\t' << ResidentFraction(output) << '\t'
+              << io.CachedReadBytes << '\t' << io.DroppedReadBytes << '\t' << io.DirectReadBytes << '\t'
+              << io.CachedWriteBytes << '\t' << io.DroppedWriteBytes << '\t' << io.DirectWriteBytes << "\n";
+    fs::remove(output);
+  }
+  return 0;
+}
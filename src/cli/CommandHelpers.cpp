@@ -1,5 +1,6 @@
 #include "CommandHelpers.hpp"
 
+#include <charconv>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -64,6 +65,30 @@ namespace Docmasys::CLI
     throw std::runtime_error("unknown workspace state");
   }
 
+  std::string ToString(DB::ChangeKind kind)
+  {
+    switch (kind)
+    {
+    case DB::ChangeKind::VersionCreated:
+      return "version-created";
+    case DB::ChangeKind::CurrentVersionChanged:
+      return "current-changed";
+    case DB::ChangeKind::PropertySet:
+      return "property-set";
+    case DB::ChangeKind::PropertyRemoved:
+      return "property-removed";
+    case DB::ChangeKind::RelationAdded:
+      return "relation-added";
+    case DB::ChangeKind::RelationRemoved:
+      return "relation-removed";
+    case DB::ChangeKind::LockAcquired:
+      return "lock-acquired";
+    case DB::ChangeKind::LockReleased:
+      return "lock-released";
+    }
+    throw std::runtime_error("unknown change kind");
+  }
+
   std::string ToString(PropertyValueType type)
   {
     switch (type)
@@ -123,6 +148,97 @@ namespace Docmasys::CLI
     throw std::runtime_error("invalid property type: " + type);
   }
 
+  DB::PropertyComparison ParsePropertyComparison(const std::string &value)
+  {
+    if (value == "eq") return DB::PropertyComparison::Equal;
+    if (value == "ne") return DB::PropertyComparison::NotEqual;
+    if (value == "lt") return DB::PropertyComparison::Less;
+    if (value == "le") return DB::PropertyComparison::LessOrEqual;
+    if (value == "gt") return DB::PropertyComparison::Greater;
+    if (value == "ge") return DB::PropertyComparison::GreaterOrEqual;
+    throw std::runtime_error("invalid property comparison: " + value);
+  }
+
+  DB::CheckpointMode ParseCheckpointMode(const std::string &value)
+  {
+    if (value == "none") return DB::CheckpointMode::None;
+    if (value == "passive") return DB::CheckpointMode::Passive;
+    if (value == "full") return DB::CheckpointMode::Full;
+    if (value == "truncate") return DB::CheckpointMode::Truncate;
+    throw std::runtime_error("invalid checkpoint mode: " + value);
+  }
+
+  namespace
+  {
+    template <typename Integer>
+    Integer ParseInteger(const std::string &option, const std::string &value)
+    {
+      Integer result{};
+      const auto *end = value.data() + value.size();
+      const auto [last, error] = std::from_chars(value.data(), end, result);
+      if (value.empty() || error != std::errc{} || last != end)
+        throw std::runtime_error("invalid value for --" + option + ": " + value);
+      return result;
+    }
+  }
+
+  std::uint64_t ParseCount(const std::string &option, const std::string &value)
+  {
+    return ParseInteger<std::uint64_t>(option, value);
+  }
+
+  int ParseInt(const std::string &option, const std::string &value)
+  {
+    return ParseInteger<int>(option, value);
+  }
+
+  std::int64_t ParseNonNegative(const std::string &option, const std::string &value)
+  {
+    const auto result = ParseInteger<std::int64_t>(option, value);
+    if (result < 0)
+      throw std::runtime_error("invalid value for --" + option + ": " + value);
+    return result;
+  }
+
+  CAS::CompressionOptions ParseCompressionOptions(const Options &options)
+  {
+    CAS::CompressionOptions compression;
+    const auto level = OptionalValue(options, "compression-level").value_or(std::to_string(CAS::DefaultCompressionLevel));
+    if (level == "adaptive")
+      compression.Adaptive = true;
+    else
+      compression.Level = ParseInt("compression-level", level);
+
+    if (const auto minLevel = OptionalValue(options, "compression-min"))
+      compression.MinLevel = ParseInt("compression-min", *minLevel);
+    if (const auto maxLevel = OptionalValue(options, "compression-max"))
+      compression.MaxLevel = ParseInt("compression-max", *maxLevel);
+    if (compression.MinLevel > compression.MaxLevel)
+      throw std::runtime_error("--compression-min must not exceed --compression-max");
+    return compression;
+  }
+
+  VaultOptions ParseVaultOptions(const Options &options)
+  {
+    VaultOptions vaultOptions;
+    const auto engine = OptionalValue(options, "io-engine").value_or("sync");
+    if (engine == "io_uring")
+      vaultOptions.IoEngine = CAS::IoEngine::IoUring;
+    else if (engine != "sync")
+      throw std::runtime_error("invalid io engine: " + engine);
+
+    const auto mode = OptionalValue(options, "io-mode").value_or("cached");
+    if (mode == "bulk")
+      vaultOptions.IoMode = CAS::IoMode::Bulk;
+    else if (mode == "direct")
+      vaultOptions.IoMode = CAS::IoMode::Direct;
+    else if (mode != "cached")
+      throw std::runtime_error("invalid io mode: " + mode);
+
+    vaultOptions.VerifyOnRead = OptionalValue(options, "verify").value_or("false") == "true";
+    return vaultOptions;
+  }
+
   ParsedRef ParseRef(const std::string &value)
   {
     const auto at = value.rfind('@');
@@ -133,6 +249,23 @@ namespace Docmasys::CLI
     return ref;
   }
 
+  Identity ParseHash(const std::string &value)
+  {
+    if (value.size() != 64)
+      throw std::runtime_error("hash must be 64 hex digits: " + value);
+    const auto digit = [&](char c) -> std::uint8_t
+    {
+      if (c >= '0' && c <= '9') return static_cast<std::uint8_t>(c - '0');
+      if (c >= 'a' && c <= 'f') return static_cast<std::uint8_t>(c - 'a' + 10);
+      if (c >= 'A' && c <= 'F') return static_cast<std::uint8_t>(c - 'A' + 10);
+      throw std::runtime_error("hash must be 64 hex digits: " + value);
+    };
+    Identity hash{};
+    for (std::size_t i = 0; i < hash.size(); ++i)
+      hash[i] = static_cast<std::uint8_t>(digit(value[2 * i]) << 4 | digit(value[2 * i + 1]));
+    return hash;
+  }
+
   Options ParseOptions(int argc, char *argv[], int start)
   {
     Options options;
@@ -254,22 +387,34 @@ namespace Docmasys::CLI
     std::cout << "Archive / workspace engine with immutable versions, relations, properties, and explicit checkout flow.\n\n";
     std::cout << "Usage:\n";
     std::cout << "  " << programName << " help\n";
-    std::cout << "  " << programName << " import --archive <archive> --root <folder> [--include <glob> | --includes-file <file>]... [--ignore <glob> | --ignores-file <file>]...\n";
-    std::cout << "  " << programName << " get --archive <archive> (--ref <path[@version]> | --refs-file <file>)... [--out <folder>] [--scope none|strong|strong+weak|all] [--mode readonly-copy|readonly-symlink]\n";
-    std::cout << "  " << programName << " checkout --archive <archive> (--ref <path[@version]> | --refs-file <file>)... --out <folder> --user <user> --environment <environment> [--scope none|strong|strong+weak|all]\n";
-    std::cout << "  " << programName << " checkin --archive <archive> (--ref <path> | --refs-file <file>)... --root <folder> --user <user> --environment <environment> [--keep-lock true|false]\n";
+    std::cout << "  " << programName << " import --archive <archive> --root <folder> [--include <glob> | --includes-file <file>]... [--ignore <glob> | --ignores-file <file>]... [--compression-level <level>|adaptive [--compression-min <level>] [--compression-max <level>]] [--batch-files <n>] [--batch-ms <ms>] [--stats true|false] [--in-memory true|false] [--io-engine sync|io_uring] [--io-mode cached|bulk|direct]\n";
+    std::cout << "  " << programName << " get --archive <archive> ((--ref <path[@version]> | --refs-file <file>)... | --baseline <name>) [--out <folder>] [--scope none|strong|strong+weak|all] [--mode readonly-copy|readonly-symlink] [--io-engine sync|io_uring] [--io-mode cached|bulk|direct] [--verify true|false]\n";
+    std::cout << "  " << programName << " checkout --archive <archive> (--ref <path[@version]> | --refs-file <file>)... --out <folder> --user <user> --environment <environment> [--scope none|strong|strong+weak|all] [--io-engine sync|io_uring] [--io-mode cached|bulk|direct] [--verify true|false]\n";
+    std::cout << "  " << programName << " checkin --archive <archive> (--ref <path> | --refs-file <file>)... --root <folder> --user <user> --environment <environment> [--keep-lock true|false] [--io-engine sync|io_uring] [--io-mode cached|bulk|direct]\n";
     std::cout << "  " << programName << " unlock --archive <archive> (--ref <path> | --refs-file <file>)...\n";
-    std::cout << "  " << programName << " status --archive <archive> --root <folder>\n";
-    std::cout << "  " << programName << " repair --archive <archive> --root <folder>\n";
+    std::cout << "  " << programName << " status --archive <archive> --root <folder> [--io-engine sync|io_uring] [--io-mode cached|bulk|direct]\n";
+    std::cout << "  " << programName << " repair --archive <archive> --root <folder> [--io-engine sync|io_uring] [--io-mode cached|bulk|direct] [--verify true|false]\n";
     std::cout << "  " << programName << " versions --archive <archive> (--path <path> | --paths-file <file>)...\n";
     std::cout << "  " << programName << " relate --archive <archive> [--from <path[@version]> --to <path[@version]> --type strong|weak|optional]... [--edges-file <file>]\n";
-    std::cout << "  " << programName << " relations --archive <archive> (--ref <path[@version]> | --refs-file <file>)... [--type strong|weak|optional|all]\n";
+    std::cout << "  " << programName << " relations --archive <archive> (--ref <path[@version]> | --refs-file <file>)... [--type strong|weak|optional|all] [--direction out|in]\n";
+    std::cout << "  " << programName << " where-used --archive <archive> (--ref <path[@version]> | --refs-file <file>)... [--scope strong|strong+weak|all] [--depth <n>]\n";
     std::cout << "  " << programName << " props list --archive <archive> (--ref <path[@version]> | --refs-file <file>)...\n";
     std::cout << "  " << programName << " props get --archive <archive> (--ref <path[@version]> | --refs-file <file>)... --name <property>\n";
     std::cout << "  " << programName << " props set --archive <archive> (--ref <path[@version]> | --refs-file <file>)... --name <property> --type string|int|bool --value <value>\n";
     std::cout << "  " << programName << " props remove --archive <archive> (--ref <path[@version]> | --refs-file <file>)... --name <property>\n";
+    std::cout << "  " << programName << " props find --archive <archive> --name <property> --type string|int|bool --value <value> [--op eq|ne|lt|le|gt|ge] [--all-versions true] [--path-prefix <folder>]\n";
     std::cout << "  " << programName << " locks list --archive <archive>\n";
-    std::cout << "  " << programName << " inspect --archive <archive> [--root <folder>]\n\n";
+    std::cout << "  " << programName << " blobs backfill-sizes --archive <archive>\n";
+    std::cout << "  " << programName << " changes --archive <archive> [--since <sequence>] [--limit <n>]\n";
+    std::cout << "  " << programName << " maintain --archive <archive> [--optimize true|false] [--analyze true|false] [--vacuum-pages <n>|all|none] [--full-vacuum true|false] [--checkpoint none|passive|full|truncate]\n";
+    std::cout << "  " << programName << " baselines create|remove --archive <archive> --name <baseline>\n";
+    std::cout << "  " << programName << " baselines list --archive <archive>\n";
+    std::cout << "  " << programName << " baselines diff --archive <archive> --from <baseline> --to <baseline>\n";
+    std::cout << "  " << programName << " search --archive <archive> --text <terms> [--all-versions true] [--limit <n>]\n";
+    std::cout << "  " << programName << " inspect --archive <archive> [--root <folder>]\n";
+    std::cout << "  " << programName << " federated inspect --archive <archive> --archive <archive>...\n";
+    std::cout << "  " << programName << " federated props-find --archive <archive>... --name <property> --type string|int|bool --value <value> [--op eq|ne|lt|le|gt|ge] [--all-versions true] [--path-prefix <folder>]\n";
+    std::cout << "  " << programName << " federated blob --archive <archive>... --hash <sha256>\n\n";
 
     std::cout << "Common flows:\n";
     std::cout << "  Import folder into archive\n";
@@ -286,5 +431,11 @@ namespace Docmasys::CLI
     std::cout << "  - checkin/unlock accept logical paths only, not @version selectors.\n";
     std::cout << "  - status states: ok, missing, modified, replaced.\n";
     std::cout << "  - import include/ignore globs are matched against workspace-relative paths.\n";
+    std::cout << "  - import --compression-level adaptive tunes the zstd level between --compression-min and --compression-max (default 1..19).\n";
+    std::cout << "  - --io-engine io_uring batches hashing and small-file retrieval on Linux; it falls back to sync elsewhere.\n";
+    std::cout << "  - --verify true hashes retrieved content while writing it and refuses to install corrupt objects.\n";
+    std::cout << "  - --io-mode bulk drops file data from the page cache after use; direct uses O_DIRECT where the filesystem allows it.\n";
+    std::cout << "  - import --in-memory true builds the archive database in memory and writes content.db once at the end.\n";
+    std::cout << "  - federated commands open every archive read-only on one connection and prefix each row with its --archive.\n";
   }
 }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "../CAS/CAS.hpp"
 #include "../DB/Database.hpp"
 #include "../Types.hpp"
+#include "../Vault.hpp"
 
 #include <filesystem>
 #include <optional>
@@ -32,6 +34,7 @@ namespace Docmasys::CLI
   std::string ToString(DB::BlobStatus status);
   std::string ToString(DB::MaterializationKind kind);
   std::string ToString(DB::WorkspaceEntryState state);
+  std::string ToString(DB::ChangeKind kind);
   std::string ToString(PropertyValueType type);
   std::string ToString(const PropertyValue &value);
 
@@ -39,7 +42,18 @@ namespace Docmasys::CLI
   DB::RelationScope ParseScope(const std::string &value);
   DB::MaterializationKind ParseMaterializationKind(const std::string &value);
   PropertyValue ParsePropertyValue(const std::string &type, const std::string &value);
+  DB::PropertyComparison ParsePropertyComparison(const std::string &value);
+  DB::CheckpointMode ParseCheckpointMode(const std::string &value);
+  /// @brief Parses the value of @p option as a non-negative integer; the error names the option.
+  std::uint64_t ParseCount(const std::string &option, const std::string &value);
+  /// @brief Parses the value of @p option as a signed integer; the error names the option.
+  int ParseInt(const std::string &option, const std::string &value);
+  /// @brief Parses the value of @p option as a non-negative signed 64-bit integer, such as a sequence number.
+  std::int64_t ParseNonNegative(const std::string &option, const std::string &value);
+  CAS::CompressionOptions ParseCompressionOptions(const Options &options);
+  VaultOptions ParseVaultOptions(const Options &options);
   ParsedRef ParseRef(const std::string &value);
+  Identity ParseHash(const std::string &value);
   Options ParseOptions(int argc, char *argv[], int start);
   std::vector<std::string> ReadManifestLines(const fs::path &file);
   std::vector<std::string> ValuesOf(const Options &options, const std::string &key);
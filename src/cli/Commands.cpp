@@ -1,12 +1,17 @@
 #include "Commands.hpp"
 #include "CommandHelpers.hpp"
 
+#include "../CAS/CAS.hpp"
 #include "../Common/PathUtils.hpp"
 #include "../DB/Database.hpp"
+#include "../DB/Federation.hpp"
 #include "../Vault.hpp"
 
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 using namespace Docmasys;
 
@@ -16,9 +21,37 @@ namespace Docmasys::CLI
   {
     int RunImport(const Options &options)
     {
-      Vault(Require(options, "root"), Require(options, "archive")).Push(ImportOptions{
+      auto vaultOptions = ParseVaultOptions(options);
+      if (OptionalValue(options, "in-memory").value_or("false") == "true")
+        vaultOptions.Storage = DB::StorageMode::Memory;
+      const ImportOptions importOptions{
           .IncludePatterns = CollectBatchValues(options, "include", "includes-file"),
-          .IgnorePatterns = CollectBatchValues(options, "ignore", "ignores-file")});
+          .IgnorePatterns = CollectBatchValues(options, "ignore", "ignores-file"),
+          .Compression = ParseCompressionOptions(options),
+          .BatchFiles = ParseCount("batch-files", OptionalValue(options, "batch-files").value_or("5000")),
+          .BatchInterval = std::chrono::milliseconds(ParseCount("batch-ms", OptionalValue(options, "batch-ms").value_or("250")))};
+      Vault vault(Require(options, "root"), Require(options, "archive"), vaultOptions);
+      const auto statistics = vault.Push(importOptions);
+      vault.SaveSnapshot();
+
+      if (OptionalValue(options, "stats").value_or("false") == "true")
+      {
+        std::cout << "files_scanned\t" << statistics.FilesScanned << "\n"
+                  << "versions_created\t" << statistics.VersionsCreated << "\n"
+                  << "blobs_stored\t" << statistics.BlobsStored << "\n"
+                  << "raw_bytes\t" << statistics.RawBytesStored << "\n"
+                  << "stored_bytes\t" << statistics.CompressedBytesStored << "\n"
+                  << "transactions\t" << statistics.Transactions << "\n";
+        for (const auto &[level, count] : statistics.BlobsByCompressionLevel)
+          std::cout << "compression_level\t" << level << '\t' << count << "\n";
+        const auto io = CAS::GetIoCounters();
+        std::cout << "io_read_bytes\tcached\t" << io.CachedReadBytes << "\n"
+                  << "io_read_bytes\tdropped\t" << io.DroppedReadBytes << "\n"
+                  << "io_read_bytes\tdirect\t" << io.DirectReadBytes << "\n"
+                  << "io_write_bytes\tcached\t" << io.CachedWriteBytes << "\n"
+                  << "io_write_bytes\tdropped\t" << io.DroppedWriteBytes << "\n"
+                  << "io_write_bytes\tdirect\t" << io.DirectWriteBytes << "\n";
+      }
       return 0;
     }
 
@@ -26,25 +59,35 @@ namespace Docmasys::CLI
     {
       const auto archive = fs::path(Require(options, "archive"));
       const auto out = fs::path(OptionalValue(options, "out").value_or("."));
+      const auto baseline = OptionalValue(options, "baseline");
       const auto refs = CollectBatchValues(options, "ref", "refs-file");
-      if (refs.empty())
-        throw std::runtime_error("get requires at least one --ref or --refs-file");
+      if (refs.empty() && !baseline)
+        throw std::runtime_error("get requires at least one --ref or --refs-file, or --baseline");
+      if (!refs.empty() && baseline)
+        throw std::runtime_error("get accepts either refs or --baseline, not both");
 
-      Vault vault(out, archive);
+      Vault vault(out, archive, ParseVaultOptions(options));
       const auto scope = ParseScope(OptionalValue(options, "scope").value_or("none"));
       const auto kind = ParseMaterializationKind(OptionalValue(options, "mode").value_or("readonly-copy"));
       if (kind == DB::MaterializationKind::CheckoutCopy)
         throw std::runtime_error("get does not accept checkout-copy mode; use checkout verb");
+      if (baseline)
+      {
+        vault.PopBaseline(*baseline, kind);
+        return 0;
+      }
 
+      std::vector<MaterializationOptions> requests;
       for (const auto &rawRef : refs)
       {
         const auto ref = ParseRef(rawRef);
-        vault.Pop(MaterializationOptions{
+        requests.push_back(MaterializationOptions{
             .RelativeFilePath = Common::EnsureRootedVaultPath(ref.Path),
             .VersionNumber = ref.Version,
             .RelationScope = scope,
             .Kind = kind});
       }
+      vault.Pop(requests);
       return 0;
     }
 
@@ -56,20 +99,22 @@ namespace Docmasys::CLI
       if (refs.empty())
         throw std::runtime_error("checkout requires at least one --ref or --refs-file");
 
-      Vault vault(out, archive);
+      Vault vault(out, archive, ParseVaultOptions(options));
       const auto scope = ParseScope(OptionalValue(options, "scope").value_or("none"));
       const auto user = Require(options, "user");
       const auto environment = Require(options, "environment");
+      std::vector<CheckoutOptions> requests;
       for (const auto &rawRef : refs)
       {
         const auto ref = ParseRef(rawRef);
-        vault.Checkout(CheckoutOptions{
+        requests.push_back(CheckoutOptions{
             .RelativeFilePath = Common::EnsureRootedVaultPath(ref.Path),
             .VersionNumber = ref.Version,
             .RelationScope = scope,
             .User = user,
             .Environment = environment});
       }
+      vault.Checkout(requests);
       return 0;
     }
 
@@ -81,7 +126,7 @@ namespace Docmasys::CLI
       if (refs.empty())
         throw std::runtime_error("checkin requires at least one --ref or --refs-file");
 
-      Vault vault(root, archive);
+      Vault vault(root, archive, ParseVaultOptions(options));
       const auto user = Require(options, "user");
       const auto environment = Require(options, "environment");
       const bool releaseLock = OptionalValue(options, "keep-lock").value_or("false") != "true";
@@ -119,18 +164,18 @@ namespace Docmasys::CLI
 
     int RunStatus(const Options &options)
     {
-      Vault vault(fs::path(Require(options, "root")), fs::path(Require(options, "archive")));
-      for (const auto &status : vault.Status())
-        std::cout << status.Entry.RelativePath.generic_string() << '\t'
-                  << ToString(status.Entry.Kind) << '\t'
-                  << ToString(status.State) << '\t'
-                  << status.Entry.Version->VersionNumber << "\n";
+      Vault vault(fs::path(Require(options, "root")), fs::path(Require(options, "archive")), ParseVaultOptions(options));
+      vault.ForEachStatus([](const DB::WorkspaceEntryStatus &status)
+                          { std::cout << status.Entry.RelativePath.generic_string() << '\t'
+                                      << ToString(status.Entry.Kind) << '\t'
+                                      << ToString(status.State) << '\t'
+                                      << status.Entry.Version->VersionNumber << "\n"; });
       return 0;
     }
 
     int RunRepair(const Options &options)
     {
-      Vault(fs::path(Require(options, "root")), fs::path(Require(options, "archive"))).Repair();
+      Vault(fs::path(Require(options, "root")), fs::path(Require(options, "archive")), ParseVaultOptions(options)).Repair();
       return 0;
     }
 
@@ -177,6 +222,10 @@ namespace Docmasys::CLI
       if (filter != "all")
         typeFilter = ParseRelationType(filter);
 
+      const auto direction = OptionalValue(options, "direction").value_or("out");
+      if (direction != "out" && direction != "in")
+        throw std::runtime_error("invalid direction: " + direction);
+
       const auto refs = CollectBatchValues(options, "ref", "refs-file");
       if (refs.empty())
         throw std::runtime_error("relations requires at least one --ref or --refs-file");
@@ -186,10 +235,12 @@ namespace Docmasys::CLI
         const auto ref = ParseRef(rawRef);
         auto file = db->GetFileByRelativePath(Common::EnsureRootedVaultPath(ref.Path));
         auto version = db->GetFileVersion(file, ref.Version);
-        for (const auto &rel : db->GetOutgoingRelations(version, typeFilter))
+        const auto relations = direction == "out" ? db->GetOutgoingRelations(version, typeFilter) : db->GetIncomingRelations(version, typeFilter);
+        for (const auto &rel : relations)
         {
-          auto targetFile = db->GetFileById(rel.To->FileId);
-          std::cout << db->BuildRelativePath(file).generic_string() << '@' << version->VersionNumber
+          auto fromFile = direction == "out" ? file : db->GetFileById(rel.From->FileId);
+          auto targetFile = direction == "out" ? db->GetFileById(rel.To->FileId) : file;
+          std::cout << db->BuildRelativePath(fromFile).generic_string() << '@' << rel.From->VersionNumber
                     << " --" << ToString(rel.Type) << "--> "
                     << db->BuildRelativePath(targetFile).generic_string() << '@' << rel.To->VersionNumber << "\n";
         }
@@ -197,9 +248,55 @@ namespace Docmasys::CLI
       return 0;
     }
 
+    int RunWhereUsed(const Options &options)
+    {
+      auto db = OpenArchiveDb(options);
+      const auto scope = ParseScope(OptionalValue(options, "scope").value_or("all"));
+      std::optional<std::size_t> maxDepth;
+      if (const auto depth = OptionalValue(options, "depth"))
+        maxDepth = ParseCount("depth", *depth);
+
+      const auto refs = CollectBatchValues(options, "ref", "refs-file");
+      if (refs.empty())
+        throw std::runtime_error("where-used requires at least one --ref or --refs-file");
+
+      for (const auto &rawRef : refs)
+      {
+        const auto ref = ParseRef(rawRef);
+        auto file = db->GetFileByRelativePath(Common::EnsureRootedVaultPath(ref.Path));
+        auto version = db->GetFileVersion(file, ref.Version);
+        const auto used = db->BuildRelativePath(file).generic_string() + '@' + std::to_string(version->VersionNumber);
+        db->ForEachWhereUsed(version->Id, scope, maxDepth, [&](const DB::WhereUsedRow &row)
+                             { std::cout << used << '\t' << row.RelativePath << '@' << row.VersionNumber << '\t'
+                                         << row.Depth << '\t' << ToString(row.Type) << '\t'
+                                         << (row.IsCurrent ? "current" : "superseded") << "\n"; });
+      }
+      return 0;
+    }
+
+    DB::PropertyQuery ParsePropertyQuery(const Options &options)
+    {
+      const auto prefix = OptionalValue(options, "path-prefix");
+      return DB::PropertyQuery{
+          .Name = Require(options, "name"),
+          .Comparison = ParsePropertyComparison(OptionalValue(options, "op").value_or("eq")),
+          .Value = ParsePropertyValue(Require(options, "type"), Require(options, "value")),
+          .CurrentOnly = OptionalValue(options, "all-versions").value_or("false") != "true",
+          .PathPrefix = prefix ? std::optional(Common::EnsureRootedVaultPath(*prefix)) : std::nullopt};
+    }
+
     int RunProps(const std::string &subcommand, const Options &options)
     {
       auto db = OpenArchiveDb(options);
+      if (subcommand == "find")
+      {
+        db->FindVersionsByProperty(ParsePropertyQuery(options), [](const DB::PropertyMatch &match)
+                                   { std::cout << match.RelativePath << '@' << match.VersionNumber << '\t'
+                                               << match.Property.Name << '\t' << ToString(match.Property.Type) << '\t'
+                                               << ToString(match.Property.Value) << "\n"; });
+        return 0;
+      }
+
       const auto refs = CollectBatchValues(options, "ref", "refs-file");
       if (refs.empty())
         throw std::runtime_error("props requires at least one --ref or --refs-file");
@@ -252,10 +349,145 @@ namespace Docmasys::CLI
       auto db = OpenArchiveDb(options);
       if (subcommand != "list")
         throw std::runtime_error("unknown locks subcommand: " + subcommand);
-      for (const auto &lock : db->ListCheckoutLocks())
-        std::cout << db->BuildRelativePath(lock.LogicalFile).generic_string() << '\t'
-                  << lock.User << '\t' << lock.Environment << '\t'
-                  << lock.WorkspaceRoot.generic_string() << "\n";
+      db->ForEachCheckoutLock([&](const DB::CheckoutLock &lock)
+                              { std::cout << db->BuildRelativePath(lock.LogicalFile).generic_string() << '\t'
+                                          << lock.User << '\t' << lock.Environment << '\t'
+                                          << lock.WorkspaceRoot.generic_string() << "\n"; });
+      return 0;
+    }
+
+    int RunBlobs(const std::string &subcommand, const Options &options)
+    {
+      if (subcommand != "backfill-sizes")
+        throw std::runtime_error("unknown blobs subcommand: " + subcommand);
+
+      // Blobs updated per transaction, so a large backfill neither commits per row nor holds one huge transaction.
+      constexpr std::size_t BACKFILL_BATCH = 1000;
+
+      const auto archive = fs::path(Require(options, "archive"));
+      auto db = OpenArchiveDb(options);
+      std::size_t updated = 0;
+      std::size_t missing = 0;
+      std::optional<DB::Database::Transaction> transaction;
+      for (const auto &blob : db->ListBlobsMissingSizes())
+      {
+        if (!fs::exists(CAS::BlobPath(archive, blob->Hash)))
+        {
+          ++missing;
+          continue;
+        }
+        const auto info = CAS::Inspect(archive, blob->Hash);
+        if (!transaction)
+          transaction.emplace(*db);
+        db->SetBlobSizes(blob, info.RawSize, info.StoredSize);
+        if (++updated % BACKFILL_BATCH == 0)
+        {
+          transaction->Commit();
+          transaction.reset();
+        }
+      }
+      if (transaction)
+        transaction->Commit();
+      std::cout << "backfilled\t" << updated << "\n";
+      if (missing > 0)
+        std::cout << "missing\t" << missing << "\n";
+      return 0;
+    }
+
+    int RunBaselines(const std::string &subcommand, const Options &options)
+    {
+      auto db = OpenArchiveDb(options);
+      if (subcommand == "create")
+      {
+        const auto baseline = db->CreateBaseline(Require(options, "name"));
+        std::cout << baseline.Name << '\t' << baseline.FileCount << "\n";
+        return 0;
+      }
+      if (subcommand == "list")
+      {
+        for (const auto &baseline : db->ListBaselines())
+          std::cout << baseline.Name << '\t' << baseline.CreatedAt << '\t' << baseline.FileCount << "\n";
+        return 0;
+      }
+      if (subcommand == "remove")
+      {
+        if (!db->RemoveBaseline(Require(options, "name")))
+          throw std::runtime_error("baseline not found");
+        return 0;
+      }
+      if (subcommand == "diff")
+      {
+        db->DiffBaselines(Require(options, "from"), Require(options, "to"), [](const DB::BaselineDifference &difference)
+                          {
+                            const auto change = !difference.FromVersion ? "added" : !difference.ToVersion ? "removed" : "changed";
+                            std::cout << change << '\t' << difference.RelativePath << '\t'
+                                      << (difference.FromVersion ? std::to_string(*difference.FromVersion) : "-") << '\t'
+                                      << (difference.ToVersion ? std::to_string(*difference.ToVersion) : "-") << "\n"; });
+        return 0;
+      }
+      throw std::runtime_error("unknown baselines subcommand: " + subcommand);
+    }
+
+    int RunChanges(const Options &options)
+    {
+      std::optional<std::size_t> limit;
+      if (const auto value = OptionalValue(options, "limit"))
+        limit = ParseCount("limit", *value);
+      const auto since = ParseNonNegative("since", OptionalValue(options, "since").value_or("0"));
+      auto db = OpenArchiveDb(options);
+      db->ForEachChangeSince(since, limit, [](const DB::ChangeRecord &change)
+                             {
+                               std::cout << change.Sequence << '\t' << ToString(change.Kind) << '\t' << change.RelativePath;
+                               if (change.VersionNumber)
+                                 std::cout << '@' << *change.VersionNumber;
+                               std::cout << '\t' << change.Detail;
+                               if (change.TargetVersionNumber)
+                                 std::cout << '\t' << change.TargetRelativePath << '@' << *change.TargetVersionNumber;
+                               std::cout << "\n"; });
+      return 0;
+    }
+
+    int RunMaintain(const Options &options)
+    {
+      DB::MaintenanceOptions maintenance{
+          .Optimize = OptionalValue(options, "optimize").value_or("true") == "true",
+          .Analyze = OptionalValue(options, "analyze").value_or("false") == "true",
+          .FullVacuum = OptionalValue(options, "full-vacuum").value_or("false") == "true",
+          .Checkpoint = ParseCheckpointMode(OptionalValue(options, "checkpoint").value_or("passive"))};
+      const auto pages = OptionalValue(options, "vacuum-pages").value_or("all");
+      if (pages == "none")
+        maintenance.VacuumPages.reset();
+      else if (pages != "all")
+        maintenance.VacuumPages = ParseCount("vacuum-pages", pages);
+
+      auto db = OpenArchiveDb(options);
+      const auto report = db->Maintain(maintenance);
+      const auto &before = report.Before;
+      const auto &after = report.After;
+      std::cout << "metric\tbefore\tafter\n"
+                << "db_bytes\t" << before.DatabaseBytes << '\t' << after.DatabaseBytes << "\n"
+                << "wal_bytes\t" << before.WalBytes << '\t' << after.WalBytes << "\n"
+                << "pages\t" << before.PageCount << '\t' << after.PageCount << "\n"
+                << "free_pages\t" << before.FreePages << '\t' << after.FreePages << "\n"
+                << std::fixed << std::setprecision(4)
+                << "free_fraction\t" << before.FreeFraction() << '\t' << after.FreeFraction() << "\n"
+                << "incremental_vacuum\t" << (before.IncrementalVacuum ? "on" : "off") << '\t' << (after.IncrementalVacuum ? "on" : "off") << "\n";
+      if (maintenance.Checkpoint != DB::CheckpointMode::None)
+        std::cout << "checkpoint\t" << report.CheckpointedFrames << '/' << report.WalFrames << " frames\t"
+                  << (report.CheckpointBusy ? "busy" : "done") << "\n";
+      return 0;
+    }
+
+    int RunSearch(const Options &options)
+    {
+      const DB::TextSearchOptions searchOptions{
+          .CurrentOnly = OptionalValue(options, "all-versions").value_or("false") != "true",
+          .Limit = ParseCount("limit", OptionalValue(options, "limit").value_or("100"))};
+      auto db = OpenArchiveDb(options);
+      db->SearchText(Require(options, "text"), searchOptions, [](const DB::TextSearchHit &hit)
+                     { std::cout << hit.RelativePath << '@' << hit.VersionNumber << '\t'
+                                 << (hit.PropertyName.empty() ? std::string_view("name") : hit.PropertyName) << '\t'
+                                 << hit.Text << "\n"; });
       return 0;
     }
 
@@ -264,17 +496,54 @@ namespace Docmasys::CLI
       const auto archive = fs::path(Require(options, "archive"));
       auto db = DB::Database::Open(archive / "content.db", OptionalValue(options, "root").value_or("."));
       std::cout << "path\tversion\tblob\tproperties\toutgoing_relations\n";
-      for (const auto &item : db->InspectCurrentFiles())
+      db->InspectFiles([](const DB::InspectionRow &row)
+                       { std::cout << row.RelativePath << '\t'
+                                   << row.VersionNumber << '\t'
+                                   << ToString(row.Status) << '\t'
+                                   << row.PropertyCount << '\t'
+                                   << row.OutgoingRelationCount << "\n"; });
+      return 0;
+    }
+
+    int RunFederated(const std::string &subcommand, const Options &options)
+    {
+      std::vector<DB::FederatedArchive> archives;
+      for (const auto &archive : ValuesOf(options, "archive"))
+        archives.push_back({archive, fs::path(archive) / "content.db"});
+      auto federation = DB::Federation::Open(archives);
+
+      if (subcommand == "inspect")
       {
-        const auto propertyCount = db->ListVersionProperties(item.Version).size();
-        const auto relationCount = db->GetOutgoingRelations(item.Version, std::nullopt).size();
-        std::cout << item.RelativePath.generic_string() << '\t'
-                  << item.Version->VersionNumber << '\t'
-                  << ToString(item.BlobRef->Status) << '\t'
-                  << propertyCount << '\t'
-                  << relationCount << "\n";
+        std::cout << "archive\tpath\tversion\tblob\tproperties\toutgoing_relations\n";
+        federation->InspectFiles([](std::string_view archive, const DB::InspectionRow &row)
+                                 { std::cout << archive << '\t' << row.RelativePath << '\t'
+                                             << row.VersionNumber << '\t'
+                                             << ToString(row.Status) << '\t'
+                                             << row.PropertyCount << '\t'
+                                             << row.OutgoingRelationCount << "\n"; });
+        return 0;
       }
-      return 0;
+
+      if (subcommand == "props-find")
+      {
+        federation->FindVersionsByProperty(ParsePropertyQuery(options), [](std::string_view archive, const DB::PropertyMatch &match)
+                                           { std::cout << archive << '\t' << match.RelativePath << '@' << match.VersionNumber << '\t'
+                                                       << match.Property.Name << '\t' << ToString(match.Property.Type) << '\t'
+                                                       << ToString(match.Property.Value) << "\n"; });
+        return 0;
+      }
+
+      if (subcommand == "blob")
+      {
+        federation->FindBlob(ParseHash(Require(options, "hash")), [](std::string_view archive, const DB::BlobUsage &usage)
+                             { std::cout << archive << '\t' << ToString(usage.Status) << '\t'
+                                         << (usage.RawSize ? std::to_string(*usage.RawSize) : "-") << '\t'
+                                         << (usage.StoredSize ? std::to_string(*usage.StoredSize) : "-") << '\t'
+                                         << usage.VersionCount << "\n"; });
+        return 0;
+      }
+
+      throw std::runtime_error("unknown federated subcommand: " + subcommand);
     }
   }
 
@@ -308,6 +577,27 @@ namespace Docmasys::CLI
       return RunLocks(argv[2], ParseOptions(argc, argv, 3));
     }
 
+    if (command == "blobs")
+    {
+      if (argc < 3)
+        throw std::runtime_error("blobs requires a subcommand");
+      return RunBlobs(argv[2], ParseOptions(argc, argv, 3));
+    }
+
+    if (command == "baselines")
+    {
+      if (argc < 3)
+        throw std::runtime_error("baselines requires a subcommand");
+      return RunBaselines(argv[2], ParseOptions(argc, argv, 3));
+    }
+
+    if (command == "federated")
+    {
+      if (argc < 3)
+        throw std::runtime_error("federated requires a subcommand");
+      return RunFederated(argv[2], ParseOptions(argc, argv, 3));
+    }
+
     const auto options = ParseOptions(argc, argv, 2);
     if (command == "import") return RunImport(options);
     if (command == "get") return RunGet(options);
@@ -319,6 +609,10 @@ namespace Docmasys::CLI
     if (command == "versions") return RunVersions(options);
     if (command == "relate") return RunRelate(options);
     if (command == "relations") return RunRelations(options);
+    if (command == "where-used") return RunWhereUsed(options);
+    if (command == "search") return RunSearch(options);
+    if (command == "maintain") return RunMaintain(options);
+    if (command == "changes") return RunChanges(options);
     if (command == "inspect") return RunInspect(options);
 
     throw std::runtime_error("unknown command: " + command);
@@ -9,6 +9,7 @@
 #include <chrono>
 
 #include "../CAS/CAS.hpp" // your header
+#include "../CAS/IoEngine.hpp"
 
 namespace fs = std::filesystem;
 
@@ -31,6 +32,12 @@ static fs::path MakeFile(const fs::path &p, std::string_view data)
   return p;
 }
 
+static std::string ReadAll(const fs::path &p)
+{
+  std::ifstream f(p, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(f)), {});
+}
+
 struct TempDir
 {
   fs::path dir;
@@ -248,6 +255,199 @@ TEST(CAS, Delete_While_Retrieve_Race_Tolerant)
   // (we don't assert the exception message to keep this test portable)
 }
 
+TEST(CAS, Store_WithOptions_ReportsLevelAndSizes)
+{
+  TempDir td;
+  auto root = td.dir / "vault";
+  fs::create_directories(root);
+
+  auto src = td.dir / "text.txt";
+  std::string data(64 * 1024, 'a');
+  MakeFile(src, data);
+
+  auto result = Docmasys::CAS::Store(root, src, Docmasys::CAS::StoreOptions{.CompressionLevel = 7});
+  EXPECT_EQ(result.Hash, Docmasys::CAS::Identify(src));
+  EXPECT_EQ(result.CompressionLevel, 7);
+  EXPECT_EQ(result.RawBytes, data.size());
+  EXPECT_GT(result.StoredBytes, 0u);
+  EXPECT_LT(result.StoredBytes, result.RawBytes);
+
+  auto out = td.dir / "out.txt";
+  Docmasys::CAS::Retrieve(root, result.Hash, out);
+  std::ifstream fi(out, std::ios::binary);
+  std::string got((std::istreambuf_iterator<char>(fi)), {});
+  EXPECT_EQ(got, data);
+}
+
+TEST(CAS, Inspect_And_Retrieve_WithExpectedSize)
+{
+  TempDir td;
+  auto root = td.dir / "vault";
+  fs::create_directories(root);
+
+  auto src = td.dir / "data.bin";
+  auto data = RandomBytes(300 * 1024);
+  MakeFile(src, data);
+  auto stored = Docmasys::CAS::Store(root, src, Docmasys::CAS::StoreOptions{});
+
+  const auto info = Docmasys::CAS::Inspect(root, stored.Hash);
+  EXPECT_EQ(info.RawSize, data.size());
+  EXPECT_EQ(info.StoredSize, stored.StoredBytes);
+
+  auto out = td.dir / "out.bin";
+  Docmasys::CAS::Retrieve(root, stored.Hash, out, Docmasys::CAS::RetrieveOptions{.ExpectedSize = info.RawSize});
+  EXPECT_EQ(fs::file_size(out), data.size());
+  std::ifstream fi(out, std::ios::binary);
+  std::string got((std::istreambuf_iterator<char>(fi)), {});
+  EXPECT_EQ(got, data);
+
+  auto wrong = td.dir / "wrong.bin";
+  EXPECT_THROW(Docmasys::CAS::Retrieve(root, stored.Hash, wrong, Docmasys::CAS::RetrieveOptions{.ExpectedSize = info.RawSize + 1}), std::runtime_error);
+  EXPECT_FALSE(fs::exists(wrong));
+  EXPECT_TRUE(fs::is_empty(td.dir / ".tmp"));
+}
+
+TEST(CAS, CompressionTuner_AdaptsWithinBounds)
+{
+  using Docmasys::CAS::CompressionTuner;
+  using Docmasys::CAS::StoreResult;
+
+  CompressionTuner fixed({.Level = 5});
+  fixed.Observe(StoreResult{.RawBytes = 64u << 20, .ReadSeconds = 0.1, .CompressSeconds = 10.0});
+  EXPECT_EQ(fixed.Level(), 5);
+
+  CompressionTuner tuner({.Level = 3, .Adaptive = true, .MinLevel = 2, .MaxLevel = 4});
+  const StoreResult cpuBound{.RawBytes = 16u << 20, .ReadSeconds = 0.1, .CompressSeconds = 1.0};
+  const StoreResult ioBound{.RawBytes = 16u << 20, .ReadSeconds = 1.0, .CompressSeconds = 0.1, .WriteSeconds = 0.5};
+
+  tuner.Observe(cpuBound);
+  EXPECT_EQ(tuner.Level(), 2);
+  tuner.Observe(cpuBound);
+  EXPECT_EQ(tuner.Level(), 2);
+
+  tuner.Observe(ioBound);
+  tuner.Observe(ioBound);
+  tuner.Observe(ioBound);
+  EXPECT_EQ(tuner.Level(), 4);
+
+  // Small blobs are pooled until the window is full.
+  tuner.Observe(StoreResult{.RawBytes = 1024, .ReadSeconds = 0.0, .CompressSeconds = 1.0});
+  EXPECT_EQ(tuner.Level(), 4);
+
+  // Reported input replaces Store's warm re-reads: slow input makes even fast Store reads I/O-bound.
+  CompressionTuner fromInput({.Level = 3, .Adaptive = true, .MinLevel = 2, .MaxLevel = 4});
+  fromInput.ObserveInput(16u << 20, 2.0);
+  fromInput.Observe(StoreResult{.RawBytes = 16u << 20, .ReadSeconds = 0.001, .CompressSeconds = 0.5});
+  EXPECT_EQ(fromInput.Level(), 4);
+}
+
+TEST(CAS, BulkAndDirectModes_RoundtripAndCountBytes)
+{
+  using Docmasys::CAS::IoMode;
+  TempDir td;
+  const auto data = RandomBytes((9u << 20) + 123); // spans a cache-drop window and leaves an unaligned tail
+  const auto src = MakeFile(td.dir / "big.bin", data);
+  const auto expected = Docmasys::CAS::Identify(src);
+
+  for (const auto mode : {IoMode::Bulk, IoMode::Direct})
+  {
+    Docmasys::CAS::ResetIoCounters();
+    EXPECT_EQ(Docmasys::CAS::Identify(src, mode), expected);
+    const auto stored = Docmasys::CAS::Store(td.dir, src, Docmasys::CAS::StoreOptions{.Mode = mode});
+    EXPECT_EQ(stored.Hash, expected);
+
+    const auto out = td.dir / "out" / (mode == IoMode::Bulk ? "bulk.bin" : "direct.bin");
+    Docmasys::CAS::Retrieve(td.dir, stored.Hash, out, Docmasys::CAS::RetrieveOptions{.ExpectedSize = data.size(), .Mode = mode});
+    EXPECT_EQ(ReadAll(out), data);
+
+    const auto io = Docmasys::CAS::GetIoCounters();
+    EXPECT_EQ(io.CachedReadBytes, 0u);
+    EXPECT_EQ(io.CachedWriteBytes, 0u);
+    EXPECT_EQ(io.DroppedReadBytes + io.DirectReadBytes, 2 * data.size() + stored.StoredBytes);
+    EXPECT_EQ(io.DroppedWriteBytes + io.DirectWriteBytes, stored.StoredBytes + data.size());
+    Docmasys::CAS::Delete(td.dir, stored.Hash);
+  }
+
+  Docmasys::CAS::ResetIoCounters();
+  static_cast<void>(Docmasys::CAS::Identify(src));
+  EXPECT_EQ(Docmasys::CAS::GetIoCounters().CachedReadBytes, data.size());
+}
+
+TEST(CAS, Retrieve_WithVerify_RejectsCorruptObject)
+{
+  TempDir td;
+  const auto good = Docmasys::CAS::Store(td.dir, MakeFile(td.dir / "good.bin", RandomBytes(200 * 1024)), Docmasys::CAS::StoreOptions{});
+  const auto other = Docmasys::CAS::Store(td.dir, MakeFile(td.dir / "other.bin", "different content in a valid frame"), Docmasys::CAS::StoreOptions{});
+
+  const auto verified = td.dir / "verified.bin";
+  Docmasys::CAS::Retrieve(td.dir, good.Hash, verified, Docmasys::CAS::RetrieveOptions{.Verify = true});
+  EXPECT_EQ(ReadAll(verified), ReadAll(td.dir / "good.bin"));
+
+  // A decodable object under the wrong identity only shows up when the output is hashed.
+  fs::copy_file(Docmasys::CAS::BlobPath(td.dir, other.Hash), Docmasys::CAS::BlobPath(td.dir, good.Hash), fs::copy_options::overwrite_existing);
+  for (const auto engine : {Docmasys::CAS::IoEngine::Synchronous, Docmasys::CAS::IoEngine::IoUring})
+  {
+    const auto out = td.dir / "corrupt" / "out.bin";
+    EXPECT_THROW(Docmasys::CAS::RetrieveMany(td.dir, {{good.Hash, out, Docmasys::CAS::RetrieveOptions{.Verify = true}}}, engine), std::runtime_error);
+    EXPECT_FALSE(fs::exists(out));
+    EXPECT_TRUE(fs::is_empty(td.dir / "corrupt" / ".tmp"));
+  }
+
+  Docmasys::CAS::Retrieve(td.dir, good.Hash, td.dir / "unverified.bin");
+  EXPECT_EQ(ReadAll(td.dir / "unverified.bin"), ReadAll(td.dir / "other.bin"));
+}
+
+TEST(CAS, IdentifyMany_MatchesIdentify_ForBothEngines)
+{
+  TempDir td;
+  std::vector<fs::path> files;
+  for (int i = 0; i < 100; ++i)
+    files.push_back(MakeFile(td.dir / "in" / (std::to_string(i) + ".bin"), RandomBytes(static_cast<size_t>(i) * 1733)));
+
+  for (const auto engine : {Docmasys::CAS::IoEngine::Synchronous, Docmasys::CAS::IoEngine::IoUring})
+  {
+    const auto identities = Docmasys::CAS::IdentifyMany(files, engine);
+    ASSERT_EQ(identities.size(), files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+      EXPECT_EQ(identities[i], Docmasys::CAS::Identify(files[i]));
+  }
+
+  files.push_back(td.dir / "in" / "missing.bin");
+  EXPECT_THROW(Docmasys::CAS::IdentifyMany(files, Docmasys::CAS::IoEngine::IoUring), std::runtime_error);
+}
+
+TEST(CAS, RetrieveMany_InstallsEveryTarget_ForBothEngines)
+{
+  TempDir td;
+  std::vector<std::string> contents;
+  std::vector<Docmasys::CAS::RetrieveRequest> requests;
+  for (int i = 0; i < 80; ++i)
+  {
+    contents.push_back(RandomBytes(static_cast<size_t>(i) * 1031) + std::to_string(i));
+    const auto src = MakeFile(td.dir / "src" / (std::to_string(i) + ".bin"), contents.back());
+    const auto stored = Docmasys::CAS::Store(td.dir, src, Docmasys::CAS::StoreOptions{});
+    requests.push_back({stored.Hash, {}, Docmasys::CAS::RetrieveOptions{.ExpectedSize = stored.RawBytes}});
+  }
+
+  for (const auto engine : {Docmasys::CAS::IoEngine::Synchronous, Docmasys::CAS::IoEngine::IoUring})
+  {
+    const auto outDir = td.dir / (engine == Docmasys::CAS::IoEngine::IoUring ? "uring" : "sync");
+    for (size_t i = 0; i < requests.size(); ++i)
+      requests[i].OutFile = outDir / "sub" / (std::to_string(i) + ".bin");
+
+    Docmasys::CAS::RetrieveMany(td.dir, requests, engine);
+    for (size_t i = 0; i < requests.size(); ++i)
+      EXPECT_EQ(ReadAll(requests[i].OutFile), contents[i]);
+    EXPECT_TRUE(fs::is_empty(outDir / "sub" / ".tmp"));
+  }
+
+  requests.resize(1);
+  requests[0].OutFile = td.dir / "bad" / "wrong-size.bin";
+  requests[0].Options.ExpectedSize = *requests[0].Options.ExpectedSize + 1;
+  EXPECT_THROW(Docmasys::CAS::RetrieveMany(td.dir, requests, Docmasys::CAS::IoEngine::IoUring), std::runtime_error);
+  EXPECT_FALSE(fs::exists(requests[0].OutFile));
+}
+
 // Optionally: stress test (disabled by default)
 // Define -DCAS_ENABLE_STRESS to enable.
 #ifdef CAS_ENABLE_STRESS
@@ -72,11 +72,33 @@ TEST(CLI, HelpAndVerbFlow)
 
   EXPECT_EQ(RunCommand(std::string(bin) + " help" + NullRedirect()), 0);
   EXPECT_EQ(RunCommand(std::string(bin) + " import --archive " + archive.string() + " --root " + root.string()), 0);
+  EXPECT_NE(RunCommand(std::string(bin) + " import --archive " + archive.string() + " --root " + root.string() + " --batch-files -1" + NullRedirectBoth()), 0);
+  EXPECT_NE(RunCommand(std::string(bin) + " import --archive " + archive.string() + " --root " + root.string() + " --batch-ms 1s" + NullRedirectBoth()), 0);
   EXPECT_EQ(RunCommand(std::string(bin) + " versions --archive " + archive.string() + " --path alpha.txt" + NullRedirect()), 0);
   EXPECT_EQ(RunCommand(std::string(bin) + " props set --archive " + archive.string() + " --ref alpha.txt@1 --name answer --type int --value 42"), 0);
   EXPECT_EQ(RunCommand(std::string(bin) + " props get --archive " + archive.string() + " --ref alpha.txt@1 --name ANSWER" + NullRedirect()), 0);
   EXPECT_EQ(RunCommand(std::string(bin) + " get --archive " + archive.string() + " --ref alpha.txt --out " + out.string() + " --mode readonly-copy"), 0);
   EXPECT_TRUE(fs::exists(out / "alpha.txt"));
+
+  const auto backfillText = RunAndCapture(td.dir / "backfill.txt", std::string(bin) + " blobs backfill-sizes --archive " + archive.string());
+  EXPECT_EQ(backfillText, "backfilled\t0\n");
+
+  const auto changesText = RunAndCapture(td.dir / "changes.txt", std::string(bin) + " changes --archive " + archive.string() + " --since 4");
+  EXPECT_EQ(changesText, "5\tproperty-set\tROOT/alpha.txt@1\tanswer\n");
+  EXPECT_NE(RunCommand(std::string(bin) + " changes --archive " + archive.string() + " --limit -1" + NullRedirectBoth()), 0);
+  EXPECT_NE(RunCommand(std::string(bin) + " changes --archive " + archive.string() + " --since -4" + NullRedirectBoth()), 0);
+
+  const auto maintainText = RunAndCapture(td.dir / "maintain.txt", std::string(bin) + " maintain --archive " + archive.string() + " --checkpoint truncate");
+  EXPECT_NE(maintainText.find("incremental_vacuum\ton\ton\n"), std::string::npos);
+  EXPECT_NE(maintainText.find("\tdone\n"), std::string::npos);
+  EXPECT_NE(RunCommand(std::string(bin) + " maintain --archive " + archive.string() + " --vacuum-pages -1" + NullRedirectBoth()), 0);
+
+  auto other = td.dir / "other";
+  EXPECT_EQ(RunCommand(std::string(bin) + " import --archive " + other.string() + " --root " + root.string() + " --in-memory true"), 0);
+  EXPECT_TRUE(fs::exists(other / "content.db"));
+  const auto federatedText = RunAndCapture(td.dir / "federated.txt", std::string(bin) + " federated props-find --archive " + archive.string() +
+                                                                          " --archive " + other.string() + " --name answer --type int --value 42");
+  EXPECT_EQ(federatedText, archive.string() + "\tROOT/alpha.txt@1\tanswer\tint\t42\n");
 }
 
 TEST(CLI, BatchOperations)
@@ -120,6 +142,17 @@ TEST(CLI, BatchOperations)
   EXPECT_NE(propsOutput.find("ROOT/docs/alpha.txt@1\treviewed\tbool\ttrue"), std::string::npos);
   EXPECT_NE(propsOutput.find("ROOT/refs/beta.txt@1\treviewed\tbool\ttrue"), std::string::npos);
 
+  const auto findOutput = RunAndCapture(capture,
+      std::string(bin) + " props find --archive " + archive.string() +
+      " --name reviewed --type bool --value true --path-prefix docs");
+  EXPECT_NE(findOutput.find("ROOT/docs/alpha.txt@1\treviewed\tbool\ttrue"), std::string::npos);
+  EXPECT_EQ(findOutput.find("ROOT/refs/beta.txt"), std::string::npos);
+
+  const auto searchOutput = RunAndCapture(capture,
+      std::string(bin) + " search --archive " + archive.string() + " --text alph*");
+  EXPECT_NE(searchOutput.find("ROOT/docs/alpha.txt@1\tname\talpha.txt"), std::string::npos);
+  EXPECT_NE(RunCommand(std::string(bin) + " search --archive " + archive.string() + " --text alph* --limit -1" + NullRedirectBoth()), 0);
+
   Docmasys::Tests::WriteFile(edgesFile, "docs/alpha.txt@1 refs/beta.txt@1 strong\n");
   ASSERT_EQ(RunCommand(std::string(bin) + " relate --archive " + archive.string() +
                        " --edges-file " + edgesFile.string()), 0);
@@ -129,6 +162,13 @@ TEST(CLI, BatchOperations)
       " --refs-file " + refsFile.string());
   EXPECT_NE(relationsOutput.find("ROOT/docs/alpha.txt@1 --strong--> ROOT/refs/beta.txt@1"), std::string::npos);
 
+  const auto whereUsedOutput = RunAndCapture(capture,
+      std::string(bin) + " where-used --archive " + archive.string() + " --ref refs/beta.txt@1");
+  EXPECT_NE(whereUsedOutput.find("ROOT/refs/beta.txt@1\tROOT/docs/alpha.txt@1\t1\tstrong\tcurrent"), std::string::npos);
+  EXPECT_NE(RunCommand(std::string(bin) + " where-used --archive " + archive.string() + " --ref refs/beta.txt@1 --depth -1" + NullRedirectBoth()), 0);
+
+  ASSERT_EQ(RunCommand(std::string(bin) + " baselines create --archive " + archive.string() + " --name before" + NullRedirect()), 0);
+
   ASSERT_EQ(RunCommand(std::string(bin) + " checkout --archive " + archive.string() +
                        " --refs-file " + refsFile.string() +
                        " --out " + out.string() +
@@ -152,6 +192,15 @@ TEST(CLI, BatchOperations)
       " --root " + out.string());
   EXPECT_NE(statusOutput.find("docs/alpha.txt\tcheckout-copy\tok\t2"), std::string::npos);
 
+  ASSERT_EQ(RunCommand(std::string(bin) + " baselines create --archive " + archive.string() + " --name after" + NullRedirect()), 0);
+  const auto diffOutput = RunAndCapture(capture,
+      std::string(bin) + " baselines diff --archive " + archive.string() + " --from before --to after");
+  EXPECT_EQ(diffOutput, "changed\tROOT/docs/alpha.txt\t1\t2\n");
+  const auto released = td.dir / "released";
+  ASSERT_EQ(RunCommand(std::string(bin) + " get --archive " + archive.string() + " --baseline before --out " + released.string()), 0);
+  EXPECT_EQ(fs::file_size(released / "docs" / "alpha.txt"), 5u);
+  EXPECT_TRUE(fs::exists(released / "refs" / "beta.txt"));
+
   ASSERT_EQ(RunCommand(std::string(bin) + " props remove --archive " + archive.string() +
                        " --refs-file " + refsFile.string() +
                        " --name reviewed"), 0);
@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <filesystem>
+#include <random>
 #include <sqlite3.h>
+#include <thread>
+#include <vector>
 
 #include "../DB/Database.hpp"
+#include "../DB/Federation.hpp"
 #include "TestSupport.hpp"
 
 namespace fs = std::filesystem;
@@ -85,6 +92,51 @@ TEST(DB, ImportCreatesVersionHistoryAndPreservesBlobs)
   EXPECT_EQ(db->GetBlob(v2.Version->BlobId)->Id, v2.Version->BlobId);
 }
 
+TEST(DB, RepeatedImportsReuseCachedStatements)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  fs::create_directories(vaultRoot / "docs");
+  for (int i = 0; i < 4; ++i)
+    std::ofstream(vaultRoot / "docs" / (std::to_string(i) + ".txt")) << i;
+
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  db->Import(vaultRoot / "docs" / "0.txt", MakeIdentity(0));
+  const auto warm = db->GetStatementStatistics();
+
+  for (int i = 1; i < 4; ++i)
+    db->Import(vaultRoot / "docs" / (std::to_string(i) + ".txt"), MakeIdentity(static_cast<unsigned char>(i)));
+  const auto after = db->GetStatementStatistics();
+
+  EXPECT_EQ(after.Prepares, warm.Prepares);
+  EXPECT_GT(after.CacheHits, warm.CacheHits);
+  EXPECT_GT(after.Steps, warm.Steps);
+  EXPECT_EQ(db->GetFileVersion(db->GetFileByRelativePath("ROOT/docs/3.txt"), std::nullopt)->VersionNumber, 1);
+}
+
+TEST(DB, FolderCacheSkipsKnownFoldersAndForgetsRolledBackOnes)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  const auto deep = vaultRoot / "a" / "b" / "c" / "d";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+
+  {
+    Database::Transaction transaction(*db);
+    db->Import(deep / "discarded.txt", MakeIdentity(1));
+  }
+  EXPECT_THROW(db->GetFileByRelativePath("ROOT/a/b/c/d/discarded.txt"), std::runtime_error);
+
+  const auto before = db->GetStatementStatistics().Steps;
+  db->Import(deep / "first.txt", MakeIdentity(2));
+  const auto first = db->GetStatementStatistics().Steps - before;
+  db->Import(vaultRoot / "A" / "B" / "c" / "d" / "second.txt", MakeIdentity(3));
+  const auto second = db->GetStatementStatistics().Steps - before - first;
+
+  EXPECT_EQ(first - second, 10u); // one INSERT and one SELECT for each of ROOT/a/b/c/d
+  EXPECT_EQ(db->GetFileByRelativePath("ROOT/a/b/c/d/second.txt")->ParentId, db->GetFileByRelativePath("ROOT/a/b/c/d/first.txt")->ParentId);
+}
+
 TEST(DB, RelationsTraverseAndCyclesAreRejected)
 {
   TempDir td;
@@ -107,6 +159,290 @@ TEST(DB, RelationsTraverseAndCyclesAreRejected)
   EXPECT_THROW(db->AddRelation(vc, va, RelationType::Optional), std::runtime_error);
 }
 
+TEST(DB, RelationOrderStaysTopologicalAndSurvivesRebuild)
+{
+  TempDir td;
+  const auto dbPath = td.dir / "content.db";
+  const auto vaultRoot = td.dir / "vault";
+  std::vector<std::shared_ptr<FileVersion>> versions;
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  {
+    auto db = Database::Open(dbPath, vaultRoot);
+    for (int i = 0; i < 60; ++i)
+      versions.push_back(db->Import(vaultRoot / ("v" + std::to_string(i) + ".txt"), MakeIdentity(100 + i)).Version);
+
+    // Edges follow index order, inserted shuffled so later edges keep pointing backwards in the current order.
+    std::mt19937 random(7);
+    for (std::size_t from = 0; from < versions.size(); ++from)
+      for (std::size_t to = from + 1; to < std::min(versions.size(), from + 6); ++to)
+        edges.emplace_back(from, to);
+    std::shuffle(edges.begin(), edges.end(), random);
+    for (const auto &[from, to] : edges)
+      db->AddRelation(versions[from], versions[to], RelationType::Strong);
+
+    EXPECT_THROW(db->AddRelation(versions[59], versions[0], RelationType::Weak), std::runtime_error);
+    EXPECT_THROW(db->AddRelation(versions[10], versions[10], RelationType::Weak), std::runtime_error);
+    db->AddRelation(versions[0], versions[59], RelationType::Optional);
+  }
+
+  sqlite3 *raw = nullptr;
+  ASSERT_EQ(sqlite3_open(dbPath.string().c_str(), &raw), SQLITE_OK);
+  const auto count = [&](const char *sql)
+  {
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(raw, sql, -1, &stmt, nullptr);
+    sqlite3_step(stmt);
+    const int value = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+  };
+  const auto countViolations = [&]
+  {
+    return count("SELECT COUNT(*) FROM version_relations vr JOIN version_order a ON a.version_id=vr.from_version_id "
+                 "JOIN version_order b ON b.version_id=vr.to_version_id WHERE a.position >= b.position;");
+  };
+  EXPECT_EQ(countViolations(), 0);
+  ASSERT_EQ(sqlite3_exec(raw, "DELETE FROM version_order;", nullptr, nullptr, nullptr), SQLITE_OK);
+
+  {
+    auto db = Database::Open(dbPath, vaultRoot);
+    EXPECT_EQ(count("SELECT COUNT(*) FROM version_order;"), 60);
+    EXPECT_EQ(countViolations(), 0);
+    EXPECT_THROW(db->AddRelation(versions[30], versions[2], RelationType::Strong), std::runtime_error);
+  }
+  sqlite3_close(raw);
+}
+
+TEST(DB, IncomingRelationsAndWhereUsedFollowScopeAndDepth)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  auto part = db->Import(vaultRoot / "part.txt", MakeIdentity(50)).Version;
+  auto sub = db->Import(vaultRoot / "sub.txt", MakeIdentity(51)).Version;
+  auto assembly1 = db->Import(vaultRoot / "assembly.txt", MakeIdentity(52)).Version;
+  auto assembly2 = db->Import(vaultRoot / "assembly.txt", MakeIdentity(53)).Version;
+  auto manual = db->Import(vaultRoot / "manual.txt", MakeIdentity(54)).Version;
+  db->AddRelation(sub, part, RelationType::Strong);
+  db->AddRelation(assembly1, sub, RelationType::Strong);
+  db->AddRelation(assembly2, sub, RelationType::Strong);
+  db->AddRelation(assembly2, part, RelationType::Weak);
+  db->AddRelation(manual, assembly2, RelationType::Optional);
+
+  const auto incoming = db->GetIncomingRelations(part, std::nullopt);
+  ASSERT_EQ(incoming.size(), 2u);
+  EXPECT_EQ(incoming[0].From->Id, sub->Id);
+  EXPECT_EQ(incoming[1].From->Id, assembly2->Id);
+  EXPECT_EQ(incoming[1].Type, RelationType::Weak);
+  EXPECT_EQ(db->GetIncomingRelations(part, RelationType::Strong).size(), 1u);
+
+  const auto whereUsed = [&](RelationScope scope, std::optional<std::size_t> depth)
+  {
+    std::vector<std::string> rows;
+    db->ForEachWhereUsed(part->Id, scope, depth, [&](const WhereUsedRow &row)
+                         { rows.push_back(std::string(row.RelativePath) + "@" + std::to_string(row.VersionNumber) + "/" +
+                                          std::to_string(row.Depth) + (row.IsCurrent ? "" : "/old")); });
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  };
+  EXPECT_EQ(whereUsed(RelationScope::Strong, std::nullopt),
+            (std::vector<std::string>{"ROOT/assembly.txt@1/2/old", "ROOT/assembly.txt@2/2", "ROOT/sub.txt@1/1"}));
+  EXPECT_EQ(whereUsed(RelationScope::All, std::nullopt),
+            (std::vector<std::string>{"ROOT/assembly.txt@1/2/old", "ROOT/assembly.txt@2/1", "ROOT/manual.txt@1/2", "ROOT/sub.txt@1/1"}));
+  EXPECT_EQ(whereUsed(RelationScope::All, 1), (std::vector<std::string>{"ROOT/assembly.txt@2/1", "ROOT/sub.txt@1/1"}));
+}
+
+TEST(DB, MultiRootMaterializationDeduplicatesAndDetectsCrossRootConflicts)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  auto part1 = db->Import(vaultRoot / "part.txt", MakeIdentity(60)).Version;
+  auto part2 = db->Import(vaultRoot / "part.txt", MakeIdentity(61)).Version;
+  auto left = db->Import(vaultRoot / "left.txt", MakeIdentity(62)).Version;
+  auto right = db->Import(vaultRoot / "right.txt", MakeIdentity(63)).Version;
+  auto other = db->Import(vaultRoot / "other.txt", MakeIdentity(64)).Version;
+  auto manual = db->Import(vaultRoot / "manual.txt", MakeIdentity(65)).Version;
+  db->AddRelation(left, part2, RelationType::Strong);
+  db->AddRelation(right, part2, RelationType::Strong);
+  db->AddRelation(right, manual, RelationType::Optional);
+  db->AddRelation(other, part1, RelationType::Strong);
+
+  const auto plan = db->ResolveMaterialization({{left->Id, RelationScope::Strong}, {right->Id, RelationScope::All}});
+  std::vector<std::string> paths;
+  for (const auto &item : plan)
+    paths.push_back(item.RelativePath.generic_string());
+  std::sort(paths.begin(), paths.end());
+  EXPECT_EQ(paths, (std::vector<std::string>{"ROOT/left.txt", "ROOT/manual.txt", "ROOT/part.txt", "ROOT/right.txt"}));
+
+  EXPECT_THROW(db->ResolveMaterialization({{left->Id, RelationScope::Strong}, {other->Id, RelationScope::Strong}}), std::runtime_error);
+  EXPECT_EQ(db->ResolveMaterialization({{left->Id, RelationScope::Strong}}).size(), 2u);
+}
+
+TEST(DB, BaselinesSnapshotCurrentVersionsAndDiff)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  db->Import(vaultRoot / "a.txt", MakeIdentity(70));
+  db->Import(vaultRoot / "b.txt", MakeIdentity(71));
+  EXPECT_EQ(db->CreateBaseline("Release-1").FileCount, 2u);
+  EXPECT_THROW(db->CreateBaseline("release-1"), std::runtime_error);
+
+  db->Import(vaultRoot / "a.txt", MakeIdentity(72));
+  db->Import(vaultRoot / "c.txt", MakeIdentity(73));
+  db->CreateBaseline("release-2");
+
+  const auto files = db->ResolveBaseline("release-1");
+  ASSERT_EQ(files.size(), 2u);
+  EXPECT_EQ(files[0].RelativePath.generic_string(), "ROOT/a.txt");
+  EXPECT_EQ(files[0].Version->VersionNumber, 1);
+  EXPECT_EQ(files[0].BlobRef->Hash, MakeIdentity(70));
+
+  std::vector<std::string> differences;
+  db->DiffBaselines("release-2", "release-1", [&](const BaselineDifference &difference)
+                    { differences.push_back(std::string(difference.RelativePath) + ":" +
+                                            (difference.FromVersion ? std::to_string(*difference.FromVersion) : "-") + ">" +
+                                            (difference.ToVersion ? std::to_string(*difference.ToVersion) : "-")); });
+  EXPECT_EQ(differences, (std::vector<std::string>{"ROOT/a.txt:2>1", "ROOT/c.txt:1>-"}));
+
+  ASSERT_EQ(db->ListBaselines().size(), 2u);
+  EXPECT_TRUE(db->RemoveBaseline("release-1"));
+  EXPECT_FALSE(db->GetBaseline("release-1"));
+  EXPECT_THROW(db->ResolveBaseline("release-1"), std::runtime_error);
+}
+
+TEST(DB, InMemoryArchiveLoadsFromAndSnapshotsToItsDatabaseFile)
+{
+  TempDir td;
+  const auto dbPath = td.dir / "archive" / "content.db";
+  const auto vaultRoot = td.dir / "vault";
+  {
+    auto db = Database::Open(dbPath, vaultRoot, StorageMode::Memory);
+    EXPECT_EQ(db->GetStorageMode(), StorageMode::Memory);
+    db->Import(vaultRoot / "a.txt", MakeIdentity(120));
+    EXPECT_FALSE(fs::exists(dbPath));
+    EXPECT_THROW(db->OpenReadSession(), std::runtime_error);
+    db->SaveSnapshot(dbPath);
+  }
+  EXPECT_EQ(ReadUserVersion(dbPath), DB_SCHEMA_VERSION);
+
+  {
+    auto db = Database::Open(dbPath, vaultRoot, StorageMode::Memory);
+    EXPECT_EQ(db->GetFileByRelativePath("ROOT/a.txt")->Name, "a.txt");
+    db->Import(vaultRoot / "b.txt", MakeIdentity(121));
+    EXPECT_EQ(db->GetDatabaseMetrics().WalBytes, 0u);
+  }
+  auto onDisk = Database::Open(dbPath, vaultRoot);
+  EXPECT_EQ(onDisk->InspectCurrentFiles().size(), 1u);
+  const auto copy = td.dir / "copy" / "content.db";
+  onDisk->SaveSnapshot(copy);
+  EXPECT_THROW(onDisk->SaveSnapshot(dbPath), std::runtime_error);
+  EXPECT_EQ(Database::Open(copy, vaultRoot)->InspectCurrentFiles().size(), 1u);
+}
+
+TEST(DB, BlobIndexResolvesKnownContentAndBatchInsertsNewHashes)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  const auto existing = db->Import(vaultRoot / "a.txt", MakeIdentity(110)).Version;
+  db->MarkBlobStored(db->GetBlob(existing->BlobId), BlobStorageInfo{.CompressionLevel = 1, .RawSize = 3, .StoredSize = 3});
+
+  auto index = db->LoadBlobIndex();
+  ASSERT_EQ(index.size(), 1u);
+  ASSERT_NE(index.Find(MakeIdentity(110)), nullptr);
+  EXPECT_EQ(index.Find(MakeIdentity(110))->Id, existing->BlobId);
+  EXPECT_EQ(index.Find(MakeIdentity(110))->Status, BlobStatus::Ready);
+  EXPECT_EQ(index.Find(MakeIdentity(111)), nullptr);
+
+  const auto inserted = db->InsertBlobs({MakeIdentity(111), MakeIdentity(110), MakeIdentity(111), MakeIdentity(112)});
+  ASSERT_EQ(inserted.size(), 3u);
+  for (const auto &blob : inserted)
+    index.Add(blob);
+  EXPECT_EQ(index.Find(MakeIdentity(110))->Id, existing->BlobId);
+  EXPECT_EQ(index.Find(MakeIdentity(111))->Status, BlobStatus::Pending);
+
+  const auto known = *index.Find(MakeIdentity(112));
+  const auto imported = db->Import(vaultRoot / "b.txt", known);
+  EXPECT_TRUE(imported.CreatedNewVersion);
+  EXPECT_EQ(imported.Version->BlobId, known.Id);
+  EXPECT_FALSE(db->Import(vaultRoot / "b.txt", known).CreatedNewVersion);
+  EXPECT_EQ(db->LoadBlobIndex().size(), 3u);
+}
+
+TEST(DB, FederationUnionsArchivesAndLabelsRowsWithTheirArchive)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto first = Database::Open(td.dir / "unit#1" / "content.db", vaultRoot);
+  auto second = Database::Open(td.dir / "unit 2" / "content.db", vaultRoot);
+  const auto a = first->Import(vaultRoot / "a.txt", MakeIdentity(100)).Version;
+  first->Import(vaultRoot / "shared.txt", MakeIdentity(101));
+  const auto b = second->Import(vaultRoot / "b.txt", MakeIdentity(101)).Version;
+  first->SetVersionProperty(a, "Owner", std::string("ops"));
+  second->SetVersionProperty(b, "owner", std::string("ops"));
+
+  auto federation = Federation::Open({{"one", td.dir / "unit#1" / "content.db"}, {"two", td.dir / "unit 2" / "content.db"}});
+  std::vector<std::string> files;
+  federation->InspectFiles([&](std::string_view archive, const InspectionRow &row)
+                           { files.push_back(std::string(archive) + ":" + std::string(row.RelativePath)); });
+  EXPECT_EQ(files, (std::vector<std::string>{"one:ROOT/a.txt", "one:ROOT/shared.txt", "two:ROOT/b.txt"}));
+
+  std::vector<std::string> matches;
+  federation->FindVersionsByProperty(PropertyQuery{.Name = "OWNER", .Value = std::string("ops")}, [&](std::string_view archive, const PropertyMatch &match)
+                                     { matches.push_back(std::string(archive) + ":" + std::string(match.RelativePath)); });
+  EXPECT_EQ(matches, (std::vector<std::string>{"one:ROOT/a.txt", "two:ROOT/b.txt"}));
+
+  std::vector<std::string> holders;
+  federation->FindBlob(MakeIdentity(101), [&](std::string_view archive, const BlobUsage &usage)
+                       { holders.push_back(std::string(archive) + ":" + std::to_string(usage.VersionCount)); });
+  EXPECT_EQ(holders, (std::vector<std::string>{"one:1", "two:1"}));
+
+  EXPECT_THROW(Federation::Open({{"one", td.dir / "missing" / "content.db"}}), std::runtime_error);
+  EXPECT_THROW(Federation::Open({{"one", td.dir / "unit#1" / "content.db"}, {"one", td.dir / "unit 2" / "content.db"}}), std::runtime_error);
+}
+
+TEST(DB, ChangeJournalRecordsChangesInOrderWithTheirTransaction)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  EXPECT_EQ(db->GetLastChangeSequence(), 0);
+  const auto a = db->Import(vaultRoot / "a.txt", MakeIdentity(90)).Version;
+  const auto b = db->Import(vaultRoot / "b.txt", MakeIdentity(91)).Version;
+  const auto afterImports = db->GetLastChangeSequence();
+
+  db->SetVersionProperty(a, "Title", std::string("first"));
+  db->AddRelation(a, b, RelationType::Weak);
+  const auto fileA = db->GetFileById(a->FileId);
+  db->AcquireCheckoutLock(fileA, a, "user", "env", td.dir / "ws");
+  db->ReleaseCheckoutLock(fileA, "user", "env", td.dir / "ws");
+  {
+    Database::Transaction abandoned(*db);
+    db->RemoveVersionProperty(a, "title");
+  }
+  db->Import(vaultRoot / "a.txt", MakeIdentity(92));
+
+  std::vector<std::string> changes;
+  std::int64_t last = afterImports;
+  db->ForEachChangeSince(afterImports, std::nullopt, [&](const ChangeRecord &change)
+                         {
+                           EXPECT_GT(change.Sequence, last);
+                           last = change.Sequence;
+                           changes.push_back(std::to_string(static_cast<int>(change.Kind)) + " " + std::string(change.RelativePath) + "@" +
+                                             std::to_string(change.VersionNumber.value_or(0)) + " " + std::string(change.Detail) +
+                                             (change.TargetVersionNumber ? " -> " + std::string(change.TargetRelativePath) : "")); });
+  EXPECT_EQ(changes, (std::vector<std::string>{"2 ROOT/a.txt@1 Title", "4 ROOT/a.txt@1 weak -> ROOT/b.txt",
+                                               "6 ROOT/a.txt@1 user@env", "7 ROOT/a.txt@1 user@env",
+                                               "0 ROOT/a.txt@2 ", "1 ROOT/a.txt@2 "}));
+  EXPECT_EQ(last, db->GetLastChangeSequence());
+
+  std::size_t imported = 0;
+  db->ForEachChangeSince(0, 3, [&](const ChangeRecord &) { ++imported; });
+  EXPECT_EQ(imported, 3u);
+}
+
 TEST(DB, VersionPropertiesAreTypedAndCaseInsensitive)
 {
   TempDir td;
@@ -136,6 +472,362 @@ TEST(DB, VersionPropertiesAreTypedAndCaseInsensitive)
   EXPECT_FALSE(db->GetVersionProperty(version, "title").has_value());
 }
 
+TEST(DB, FindVersionsByPropertyFiltersByValueCurrencyAndPath)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  auto a1 = db->Import(vaultRoot / "a.txt", MakeIdentity(30)).Version;
+  auto a2 = db->Import(vaultRoot / "a.txt", MakeIdentity(31)).Version;
+  auto b = db->Import(vaultRoot / "docs" / "b.txt", MakeIdentity(32)).Version;
+  auto c = db->Import(vaultRoot / "docs2" / "c.txt", MakeIdentity(33)).Version;
+  db->SetVersionProperty(a1, "Score", std::int64_t(1));
+  db->SetVersionProperty(a2, "score", std::int64_t(5));
+  db->SetVersionProperty(b, "score", std::int64_t(3));
+  db->SetVersionProperty(c, "score", std::string("high"));
+  db->SetVersionProperty(b, "project.code", std::string("X1"));
+
+  const auto find = [&](PropertyQuery query)
+  {
+    std::vector<std::string> matches;
+    db->FindVersionsByProperty(query, [&](const PropertyMatch &match)
+                               { matches.push_back(std::string(match.RelativePath) + "@" + std::to_string(match.VersionNumber)); });
+    return matches;
+  };
+
+  EXPECT_EQ(find({.Name = "SCORE", .Comparison = PropertyComparison::GreaterOrEqual, .Value = std::int64_t(3)}),
+            (std::vector<std::string>{"ROOT/a.txt@2", "ROOT/docs/b.txt@1"}));
+  EXPECT_EQ(find({.Name = "score", .Comparison = PropertyComparison::Less, .Value = std::int64_t(5), .CurrentOnly = false}),
+            (std::vector<std::string>{"ROOT/a.txt@1", "ROOT/docs/b.txt@1"}));
+  EXPECT_EQ(find({.Name = "score", .Comparison = PropertyComparison::NotEqual, .Value = std::int64_t(0), .PathPrefix = fs::path("ROOT/DOCS")}),
+            (std::vector<std::string>{"ROOT/docs/b.txt@1"}));
+  EXPECT_EQ(find({.Name = "score", .Value = std::string("high")}), (std::vector<std::string>{"ROOT/docs2/c.txt@1"}));
+  EXPECT_EQ(find({.Name = "project.code", .Value = std::string("X1")}), (std::vector<std::string>{"ROOT/docs/b.txt@1"}));
+  EXPECT_THROW(find({.Name = "score", .Comparison = PropertyComparison::Less, .Value = true}), std::runtime_error);
+}
+
+TEST(DB, SearchTextTracksPropertyChangesAndFileNames)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  auto a1 = db->Import(vaultRoot / "specs" / "pump-manual.txt", MakeIdentity(40)).Version;
+  auto a2 = db->Import(vaultRoot / "specs" / "pump-manual.txt", MakeIdentity(41)).Version;
+  auto b = db->Import(vaultRoot / "notes.txt", MakeIdentity(42)).Version;
+  db->SetVersionProperty(a1, "title", std::string("Centrifugal pump draft"));
+  db->SetVersionProperty(a2, "title", std::string("Centrifugal pump"));
+  db->SetVersionProperty(b, "summary", std::string("valve and pump notes"));
+
+  const auto search = [&](const std::string &terms, TextSearchOptions options = {})
+  {
+    std::vector<std::string> hits;
+    db->SearchText(terms, options, [&](const TextSearchHit &hit)
+                   { hits.push_back(std::string(hit.RelativePath) + "@" + std::to_string(hit.VersionNumber) + ":" +
+                                    (hit.PropertyName.empty() ? std::string("name") : std::string(hit.PropertyName))); });
+    std::sort(hits.begin(), hits.end());
+    return hits;
+  };
+
+  EXPECT_EQ(search("centrifugal PUMP"), (std::vector<std::string>{"ROOT/specs/pump-manual.txt@2:title"}));
+  EXPECT_EQ(search("centri* draft", {.CurrentOnly = false}), (std::vector<std::string>{"ROOT/specs/pump-manual.txt@1:title"}));
+  EXPECT_EQ(search("manual"), (std::vector<std::string>{"ROOT/specs/pump-manual.txt@2:name"}));
+  EXPECT_EQ(search("valve"), (std::vector<std::string>{"ROOT/notes.txt@1:summary"}));
+
+  // Property and file-name hits are ranked separately and interleaved, best of each kind first.
+  std::vector<bool> nameHits;
+  db->SearchText("pump", {.CurrentOnly = false}, [&](const TextSearchHit &hit)
+                 { nameHits.push_back(hit.PropertyName.empty()); });
+  EXPECT_EQ(nameHits, (std::vector<bool>{false, true, false, false}));
+
+  db->SetVersionProperty(b, "summary", std::int64_t(7));
+  EXPECT_TRUE(search("valve").empty());
+  db->SetVersionProperty(b, "summary", std::string("gasket"));
+  EXPECT_TRUE(db->RemoveVersionProperty(a2, "title"));
+  EXPECT_EQ(search("gasket"), (std::vector<std::string>{"ROOT/notes.txt@1:summary"}));
+  EXPECT_TRUE(search("centrifugal").empty());
+  EXPECT_THROW(search("  "), std::runtime_error);
+}
+
+TEST(DB, InspectFilesStreamsCountsPerCurrentVersion)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  auto a = db->Import(vaultRoot / "a.txt", MakeIdentity(20)).Version;
+  auto b = db->Import(vaultRoot / "b.txt", MakeIdentity(21)).Version;
+  db->SetVersionProperty(a, "title", std::string("alpha"));
+  db->SetVersionProperty(a, "build", std::int64_t(1));
+  db->AddRelation(a, b, RelationType::Strong);
+
+  std::vector<std::tuple<std::string, std::int64_t, std::uint64_t, std::uint64_t>> rows;
+  db->InspectFiles([&](const InspectionRow &row)
+                   { rows.emplace_back(std::string(row.RelativePath), row.VersionNumber, row.PropertyCount, row.OutgoingRelationCount); });
+
+  ASSERT_EQ(rows.size(), 2u);
+  EXPECT_EQ(rows[0], std::make_tuple(std::string("ROOT/a.txt"), std::int64_t(1), std::uint64_t(2), std::uint64_t(1)));
+  EXPECT_EQ(rows[1], std::make_tuple(std::string("ROOT/b.txt"), std::int64_t(1), std::uint64_t(0), std::uint64_t(0)));
+}
+
+TEST(DB, ValueRowsMatchSharedPointerListings)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  const auto workspace = td.dir / "workspace";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  auto a = db->Import(vaultRoot / "docs" / "a.txt", MakeIdentity(30)).Version;
+  auto b = db->Import(vaultRoot / "b.txt", MakeIdentity(31)).Version;
+  db->AddRelation(a, b, RelationType::Strong);
+  db->UpsertWorkspaceEntry(workspace, db->GetFileById(a->FileId), a, "docs/a.txt", MaterializationKind::ReadOnlyCopy);
+
+  auto rows = std::make_unique<MaterializedRows>(db->InspectCurrentFileRows());
+  const auto moved = std::move(*rows);
+  rows.reset();
+  const auto files = db->InspectCurrentFiles();
+  ASSERT_EQ(moved.size(), files.size());
+  for (std::size_t i = 0; i < files.size(); ++i)
+  {
+    EXPECT_EQ(moved[i].FileId, files[i].LogicalFile->Id);
+    EXPECT_EQ(moved[i].Hash, files[i].BlobRef->Hash);
+    EXPECT_EQ(fs::path(moved[i].RelativePath), files[i].RelativePath);
+  }
+
+  const auto resolved = db->ResolveMaterializationRows(a->Id, RelationScope::Strong);
+  ASSERT_EQ(resolved.size(), 2u);
+  EXPECT_EQ(resolved[1].RelativePath, "ROOT/b.txt");
+
+  const auto entries = db->ListWorkspaceEntryRows(workspace);
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].RelativePath, "docs/a.txt");
+  EXPECT_EQ(entries[0].LogicalPath, "ROOT/docs/a.txt");
+  EXPECT_EQ(entries[0].VersionNumber, 1);
+}
+
+TEST(DB, WorkspaceStatusStreamsAcrossHashingBatches)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  const auto workspace = td.dir / "workspace";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  constexpr int entries = 300;
+  for (int i = 0; i < entries; ++i)
+  {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%03d.txt", i);
+    Docmasys::Tests::WriteFile(workspace / name, name);
+    const auto identity = i % 2 == 0 ? CAS::Identify(workspace / name) : MakeIdentity(static_cast<std::uint8_t>(i));
+    const auto version = db->Import(vaultRoot / name, identity).Version;
+    db->UpsertWorkspaceEntry(workspace, db->GetFileById(version->FileId), version, name, MaterializationKind::CheckoutCopy);
+  }
+
+  int visited = 0;
+  db->ForEachWorkspaceStatus(workspace, CAS::IoEngine::Synchronous, CAS::IoMode::Cached, [&](const WorkspaceEntryStatus &status)
+                             {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%03d.txt", visited);
+    EXPECT_EQ(status.Entry.RelativePath, fs::path(name));
+    EXPECT_EQ(status.State, visited % 2 == 0 ? WorkspaceEntryState::Ok : WorkspaceEntryState::Modified);
+    ++visited; });
+  EXPECT_EQ(visited, entries);
+}
+
+TEST(DB, ReadSessionsQueryConcurrentlyWithWriter)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  db->Import(vaultRoot / "seed.txt", MakeIdentity(0));
+
+  {
+    auto session = db->OpenReadSession();
+    EXPECT_THROW(session->Import(vaultRoot / "denied.txt", MakeIdentity(1)), std::runtime_error);
+  }
+
+  std::atomic<bool> writing{true};
+  std::atomic<int> failures{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i)
+    readers.emplace_back([&]
+                         {
+      std::uint64_t lastSeen = 0;
+      do
+      {
+        try
+        {
+          auto session = db->OpenReadSession();
+          std::uint64_t seen = 0;
+          session->InspectFiles([&](const InspectionRow &) { ++seen; });
+          if (seen < lastSeen || session->GetFileByRelativePath("ROOT/seed.txt")->Name != "seed.txt")
+            ++failures;
+          lastSeen = seen;
+        }
+        catch (...)
+        {
+          ++failures;
+        }
+      } while (writing); });
+
+  for (int i = 0; i < 200; ++i)
+  {
+    Database::Transaction transaction(*db);
+    db->Import(vaultRoot / "docs" / (std::to_string(i) + ".txt"), MakeIdentity(static_cast<std::uint8_t>(i + 2)));
+    transaction.Commit();
+  }
+  writing = false;
+  for (auto &reader : readers)
+    reader.join();
+
+  EXPECT_EQ(failures, 0);
+  std::uint64_t total = 0;
+  db->OpenReadSession()->InspectFiles([&](const InspectionRow &) { ++total; });
+  EXPECT_EQ(total, 201u);
+}
+
+TEST(DB, MaintainReturnsFreePagesAndCheckpointsWhileReadersAreOpen)
+{
+  TempDir td;
+  const auto vaultRoot = td.dir / "vault";
+  auto db = Database::Open(td.dir / "content.db", vaultRoot);
+  std::vector<std::shared_ptr<FileVersion>> versions;
+  for (int i = 0; i < 64; ++i)
+  {
+    versions.push_back(db->Import(vaultRoot / ("f" + std::to_string(i) + ".txt"), MakeIdentity(static_cast<std::uint8_t>(i))).Version);
+    db->SetVersionProperty(versions.back(), "notes", std::string(3000, 'x') + " needle");
+  }
+  for (std::size_t i = 1; i < versions.size(); ++i)
+    db->RemoveVersionProperty(versions[i], "notes");
+
+  auto session = db->OpenReadSession();
+  std::size_t files = 0;
+  session->InspectFiles([&](const InspectionRow &) { ++files; });
+
+  const auto report = db->Maintain({.Checkpoint = CheckpointMode::Passive});
+  EXPECT_TRUE(report.Before.IncrementalVacuum);
+  EXPECT_GT(report.Before.FreePages, 0u);
+  EXPECT_EQ(report.After.FreePages, 0u);
+  EXPECT_LT(report.After.PageCount, report.Before.PageCount);
+  EXPECT_FALSE(report.CheckpointBusy);
+  EXPECT_EQ(files, 64u);
+
+  const auto vacuumed = db->Maintain({.VacuumPages = std::nullopt, .FullVacuum = true, .Checkpoint = CheckpointMode::Truncate});
+  EXPECT_EQ(vacuumed.After.WalBytes, 0u);
+  if (db->HasFullTextIndex())
+  {
+    std::size_t hits = 0;
+    db->SearchText("needle", {}, [&](const TextSearchHit &) { ++hits; });
+    EXPECT_EQ(hits, 1u);
+  }
+}
+
+TEST(DB, OlderV1BlobTableGainsStorageColumnsAndCanBeBackfilled)
+{
+  TempDir td;
+  const auto dbPath = td.dir / "content.db";
+  const auto vaultRoot = td.dir / "vault";
+  fs::create_directories(vaultRoot);
+  std::ofstream(vaultRoot / "a.txt") << "a";
+
+  {
+    auto db = Database::Open(dbPath, vaultRoot);
+    db->UpdateBlobStatus(db->GetBlob(db->Import(vaultRoot / "a.txt", MakeIdentity(3)).Version->BlobId), BlobStatus::Ready);
+  }
+
+  sqlite3 *raw = nullptr;
+  ASSERT_EQ(sqlite3_open(dbPath.string().c_str(), &raw), SQLITE_OK);
+  ASSERT_EQ(sqlite3_exec(raw, "DROP INDEX uq_files_relative_path;", nullptr, nullptr, nullptr), SQLITE_OK);
+  ASSERT_EQ(sqlite3_exec(raw, DB_DROP_FULL_TEXT_TRIGGERS, nullptr, nullptr, nullptr), SQLITE_OK);
+  ASSERT_EQ(sqlite3_exec(raw, "INSERT INTO version_properties VALUES (1, 'title', 'title', 0, 'unindexed words', NULL, NULL);", nullptr, nullptr, nullptr), SQLITE_OK);
+  for (const auto &column : DB_SCHEMA_ADDED_COLUMNS)
+    ASSERT_EQ(sqlite3_exec(raw, (std::string("ALTER TABLE ") + column.Table + " DROP COLUMN " + column.Column + ";").c_str(), nullptr, nullptr, nullptr), SQLITE_OK);
+  sqlite3_close(raw);
+
+  auto db = Database::Open(dbPath, vaultRoot);
+  const auto missing = db->ListBlobsMissingSizes();
+  ASSERT_EQ(missing.size(), 1u);
+  EXPECT_FALSE(missing.front()->RawSize.has_value());
+
+  db->SetBlobSizes(missing.front(), 10, 4);
+  EXPECT_TRUE(db->ListBlobsMissingSizes().empty());
+  const auto blob = db->GetBlob(missing.front()->Id);
+  EXPECT_EQ(blob->RawSize, std::optional<std::uint64_t>(10));
+  EXPECT_EQ(blob->StoredSize, std::optional<std::uint64_t>(4));
+  EXPECT_EQ(db->GetCurrentContentSize(), 10u);
+
+  const auto file = db->GetFileByRelativePath("root/A.TXT");
+  EXPECT_EQ(file->RelativePath, fs::path("ROOT/a.txt"));
+  EXPECT_EQ(db->InspectCurrentFiles().front().RelativePath, fs::path("ROOT/a.txt"));
+
+  if (db->HasFullTextIndex())
+  {
+    std::size_t hits = 0;
+    db->SearchText("unindexed", {}, [&](const TextSearchHit &) { ++hits; });
+    EXPECT_EQ(hits, 1u);
+  }
+}
+
+TEST(DB, Version1SchemaIsMigratedInPlace)
+{
+  TempDir td;
+  const auto dbPath = td.dir / "content.db";
+  const auto vaultRoot = td.dir / "vault";
+  const auto workspace = td.dir / "ws";
+  {
+    auto db = Database::Open(dbPath, vaultRoot);
+    const auto a = db->Import(vaultRoot / "a.txt", MakeIdentity(80)).Version;
+    const auto b = db->Import(vaultRoot / "b.txt", MakeIdentity(81)).Version;
+    db->AddRelation(a, b, RelationType::Weak);
+    const auto fileA = db->GetFileById(a->FileId);
+    db->UpsertWorkspaceEntry(workspace, fileA, a, "a.txt", MaterializationKind::CheckoutCopy);
+    db->AcquireCheckoutLock(fileA, a, "user", "env", workspace);
+  }
+
+  // Rewrite the tables into their v1 layout: text workspace roots, a rowid relation table and the redundant indexes.
+  sqlite3 *raw = nullptr;
+  ASSERT_EQ(sqlite3_open(dbPath.string().c_str(), &raw), SQLITE_OK);
+  ASSERT_EQ(sqlite3_exec(raw, R"SQL(
+    CREATE TABLE v1_relations (from_version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE, to_version_id INTEGER NOT NULL REFERENCES file_versions(id) ON DELETE CASCADE, relation_type INTEGER NOT NULL CHECK (relation_type IN (0,1,2)), PRIMARY KEY(from_version_id, to_version_id, relation_type));
+    INSERT INTO v1_relations SELECT * FROM version_relations;
+    DROP TABLE version_relations;
+    ALTER TABLE v1_relations RENAME TO version_relations;
+    CREATE INDEX idx_version_relations_to ON version_relations(to_version_id);
+    CREATE TRIGGER trg_version_relations_no_self_loop BEFORE INSERT ON version_relations FOR EACH ROW WHEN NEW.from_version_id = NEW.to_version_id BEGIN SELECT RAISE(ABORT, 'version relation cycle detected'); END;
+    CREATE TABLE v1_entries (workspace_root TEXT NOT NULL, file_id INTEGER NOT NULL, version_id INTEGER NOT NULL, relative_path TEXT NOT NULL, materialization_kind INTEGER NOT NULL, PRIMARY KEY(workspace_root, file_id), UNIQUE(workspace_root, relative_path));
+    INSERT INTO v1_entries SELECT w.root, e.file_id, e.version_id, e.relative_path, e.materialization_kind FROM workspace_entries e JOIN workspaces w ON w.id = e.workspace_id;
+    DROP TABLE workspace_entries;
+    ALTER TABLE v1_entries RENAME TO workspace_entries;
+    CREATE INDEX idx_workspace_entries_workspace ON workspace_entries(workspace_root);
+    CREATE TABLE v1_locks (file_id INTEGER PRIMARY KEY, version_id INTEGER NOT NULL, user_name TEXT NOT NULL, environment_name TEXT NOT NULL, workspace_root TEXT NOT NULL);
+    INSERT INTO v1_locks SELECT l.file_id, l.version_id, l.user_name, l.environment_name, w.root FROM checkout_locks l JOIN workspaces w ON w.id = l.workspace_id;
+    DROP TABLE checkout_locks;
+    ALTER TABLE v1_locks RENAME TO checkout_locks;
+    DROP TABLE workspaces;
+    CREATE INDEX idx_blobs ON blobs(hash);
+    CREATE INDEX idx_file_versions_file ON file_versions(file_id);
+    PRAGMA user_version = 1;
+  )SQL", nullptr, nullptr, nullptr), SQLITE_OK);
+  sqlite3_close(raw);
+
+  auto db = Database::Open(dbPath, vaultRoot);
+  EXPECT_EQ(ReadUserVersion(dbPath), DB_SCHEMA_VERSION);
+  const auto fileA = db->GetFileByRelativePath("ROOT/a.txt");
+  const auto a = db->GetFileVersion(fileA, std::nullopt);
+  const auto entries = db->ListWorkspaceEntries(workspace);
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries.front().Kind, MaterializationKind::CheckoutCopy);
+  ASSERT_TRUE(db->GetCheckoutLock(fileA));
+  EXPECT_EQ(db->GetCheckoutLock(fileA)->User, "user");
+  EXPECT_TRUE(db->ReleaseCheckoutLock(fileA, "user", "env", workspace));
+  ASSERT_EQ(db->GetOutgoingRelations(a, std::nullopt).size(), 1u);
+  EXPECT_THROW(db->AddRelation(db->GetOutgoingRelations(a, std::nullopt).front().To, a, RelationType::Strong), std::runtime_error);
+
+  ASSERT_EQ(sqlite3_open(dbPath.string().c_str(), &raw), SQLITE_OK);
+  sqlite3_stmt *stmt = nullptr;
+  ASSERT_EQ(sqlite3_prepare_v2(raw, "SELECT COUNT(*) FROM sqlite_master WHERE name IN ('idx_blobs', 'idx_file_versions_file', 'idx_workspace_entries_workspace') OR name LIKE 'v1_%';", -1, &stmt, nullptr), SQLITE_OK);
+  ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ(sqlite3_column_int(stmt, 0), 0);
+  sqlite3_finalize(stmt);
+  sqlite3_close(raw);
+}
+
 TEST(DB, UnsupportedNewerSchemaVersionIsRejected)
 {
   TempDir td;
@@ -321,6 +321,30 @@ TEST(Vault, PushCanFilterImportedFilesByIncludeAndIgnorePatterns)
   EXPECT_THROW(db->GetFileByRelativePath("ROOT/tmp/drop.txt"), std::runtime_error);
 }
 
+TEST(Vault, PushCommitsInBatchesAndRollsBackFailedBatch)
+{
+  TempDir td;
+  auto source = td.dir / "source";
+  auto archive = td.dir / "archive";
+  fs::create_directories(archive);
+  for (int i = 0; i < 5; ++i)
+    MakeFile(source / (std::to_string(i) + ".txt"), std::to_string(i));
+  MakeFile(source / "rules.dmsrel", "strong 0.txt\n");
+
+  Vault vault(source, archive);
+  EXPECT_THROW(vault.Push(), std::runtime_error);
+  {
+    auto db = DB::Database::Open(archive / "content.db", source);
+    EXPECT_THROW(db->GetFileByRelativePath("ROOT/0.txt"), std::runtime_error);
+  }
+
+  fs::remove(source / "rules.dmsrel");
+  const auto statistics = vault.Push(ImportOptions{.BatchFiles = 2, .BatchInterval = std::chrono::hours(1)});
+  EXPECT_EQ(statistics.VersionsCreated, 5u);
+  EXPECT_EQ(statistics.Transactions, 3u);
+  EXPECT_EQ(vault.Push().VersionsCreated, 0u);
+}
+
 TEST(Vault, ImportExtensionsCanAttachPropertiesAndRelations)
 {
   TempDir td;
@@ -348,3 +372,132 @@ TEST(Vault, ImportExtensionsCanAttachPropertiesAndRelations)
   auto targetFile = db->GetFileById(relations.front().To->FileId);
   EXPECT_EQ(db->BuildRelativePath(targetFile), fs::path("ROOT/target.txt"));
 }
+
+TEST(Vault, AdaptivePushRaisesLevelWhenInputIsSlowerThanCompression)
+{
+  TempDir td;
+  auto source = td.dir / "source";
+  auto archive = td.dir / "archive";
+  fs::create_directories(source);
+  fs::create_directories(archive);
+
+  // Runs of zeros compress far faster than they hash, so the hashing read dominates and the level must go up.
+  for (char i = 0; i < 12; ++i)
+  {
+    std::string content(1u << 20, '\0');
+    content.front() = static_cast<char>('a' + i);
+    MakeFile(source / (std::string(1, static_cast<char>('a' + i)) + ".bin"), content);
+  }
+
+  const auto statistics = Vault(source, archive).Push(ImportOptions{.Compression = {.Level = 1, .Adaptive = true, .MinLevel = 1, .MaxLevel = 2}});
+  EXPECT_EQ(statistics.BlobsStored, 12u);
+  EXPECT_TRUE(statistics.BlobsByCompressionLevel.contains(2));
+}
+
+TEST(Vault, PushReportsStatisticsAndRecordsCompressionLevel)
+{
+  TempDir td;
+  auto source = td.dir / "source";
+  auto archive = td.dir / "archive";
+  fs::create_directories(source);
+  fs::create_directories(archive);
+
+  MakeFile(source / "a.txt", std::string(4096, 'a'));
+  MakeFile(source / "b.txt", std::string(4096, 'b'));
+  MakeFile(source / "copy-of-a.txt", std::string(4096, 'a'));
+
+  const auto statistics = Vault(source, archive).Push(ImportOptions{.Compression = {.Level = 9}});
+  EXPECT_EQ(statistics.FilesScanned, 3u);
+  EXPECT_EQ(statistics.VersionsCreated, 3u);
+  EXPECT_EQ(statistics.BlobsStored, 2u);
+  EXPECT_EQ(statistics.RawBytesStored, 8192u);
+  EXPECT_LT(statistics.CompressedBytesStored, statistics.RawBytesStored);
+  ASSERT_EQ(statistics.BlobsByCompressionLevel.size(), 1u);
+  EXPECT_EQ(statistics.BlobsByCompressionLevel.at(9), 2u);
+
+  auto db = DB::Database::Open(archive / "content.db", source);
+  auto version = db->GetFileVersion(db->GetFileByRelativePath("ROOT/a.txt"), std::nullopt);
+  auto blob = db->GetBlob(version->BlobId);
+  EXPECT_EQ(blob->Status, DB::BlobStatus::Ready);
+  ASSERT_TRUE(blob->CompressionLevel.has_value());
+  EXPECT_EQ(*blob->CompressionLevel, 9);
+  EXPECT_EQ(blob->RawSize, std::optional<std::uint64_t>(4096));
+  EXPECT_EQ(blob->StoredSize, std::optional<std::uint64_t>(CAS::Inspect(archive, blob->Hash).StoredSize));
+
+  const auto again = Vault(source, archive).Push();
+  EXPECT_EQ(again.FilesScanned, 3u);
+  EXPECT_EQ(again.VersionsCreated, 0u);
+  EXPECT_EQ(again.BlobsStored, 0u);
+}
+
+TEST(Vault, IoUringEngineMaterializesAndDetectsModifiedFiles)
+{
+  TempDir td;
+  auto source = td.dir / "source";
+  auto archive = td.dir / "archive";
+  auto workspace = td.dir / "workspace";
+  fs::create_directories(source);
+  fs::create_directories(archive);
+
+  const VaultOptions options{.IoEngine = CAS::IoEngine::IoUring};
+  for (int i = 0; i < 300; ++i)
+    MakeFile(source / "docs" / ("doc" + std::to_string(i) + ".txt"), "content " + std::to_string(i));
+  const auto statistics = Vault(source, archive, options).Push();
+  EXPECT_EQ(statistics.FilesScanned, 300u);
+  EXPECT_EQ(statistics.VersionsCreated, 300u);
+
+  Vault vault(workspace, archive, options);
+  vault.Pop();
+  EXPECT_EQ(ReadFile(workspace / "docs" / "doc7.txt"), "content 7");
+  EXPECT_EQ(ReadFile(workspace / "docs" / "doc299.txt"), "content 299");
+  EXPECT_EQ((fs::status(workspace / "docs" / "doc7.txt").permissions() & fs::perms::owner_write), fs::perms::none);
+
+  fs::permissions(workspace / "docs" / "doc7.txt", fs::perms::owner_write, fs::perm_options::add);
+  MakeFile(workspace / "docs" / "doc7.txt", "tampered");
+  fs::permissions(workspace / "docs" / "doc7.txt", fs::perms::owner_write, fs::perm_options::remove);
+
+  size_t modified = 0;
+  for (const auto &status : vault.Status())
+  {
+    if (status.State != DB::WorkspaceEntryState::Ok)
+    {
+      ++modified;
+      EXPECT_EQ(status.Entry.RelativePath.generic_string(), "docs/doc7.txt");
+      EXPECT_EQ(status.State, DB::WorkspaceEntryState::Modified);
+    }
+  }
+  EXPECT_EQ(modified, 1u);
+}
+
+TEST(Vault, FailedRetrievalKeepsExistingFilesAndTracksInstalledOnes)
+{
+  for (const auto engine : {CAS::IoEngine::Synchronous, CAS::IoEngine::IoUring})
+  {
+    TempDir td;
+    auto source = td.dir / "source";
+    auto archive = td.dir / "archive";
+    auto workspace = td.dir / "workspace";
+    fs::create_directories(archive);
+    MakeFile(source / "a.txt", "alpha");
+    MakeFile(source / "b.txt", "beta");
+    MakeFile(source / "c.txt", "gamma");
+    Vault(source, archive).Push();
+
+    fs::remove(CAS::BlobPath(archive, CAS::Identify(source / "b.txt")));
+    MakeFile(workspace / "b.txt", "local beta");
+
+    Vault vault(workspace, archive, VaultOptions{.IoEngine = engine});
+    EXPECT_THROW(vault.Pop(), std::runtime_error);
+    EXPECT_EQ(ReadFile(workspace / "b.txt"), "local beta");
+    EXPECT_EQ(ReadFile(workspace / "a.txt"), "alpha");
+    EXPECT_EQ(ReadFile(workspace / "c.txt"), "gamma");
+
+    std::vector<std::string> tracked;
+    for (const auto &status : vault.Status())
+    {
+      tracked.push_back(status.Entry.RelativePath.generic_string());
+      EXPECT_EQ(status.State, DB::WorkspaceEntryState::Ok);
+    }
+    EXPECT_EQ(tracked, (std::vector<std::string>{"a.txt", "c.txt"}));
+  }
+}